@@ -0,0 +1,255 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-backend.c
+ * @brief	echo throughput and per-session memory benchmark of GLib backend and epoll backend
+ *
+ * The same source is built with libglib_support (bench_backend_glib) and
+ * with libepoll_support and -DGLIBHELPER_EPOLL (bench_backend_epoll).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <malloc.h>
+
+#include "glibhelper-unix-socket-support.h"
+#include "glibhelper-unix-socket-support-util.h"
+
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#define BENCH_BACKEND "epoll"
+#define bench_iteration(block) glibhelper_epoll_iteration(NULL, (block))
+#else
+#include <glib.h>
+#include <gio/gio.h>
+#define BENCH_BACKEND "glib"
+#define bench_iteration(block) g_main_context_iteration(NULL, (block))
+#endif
+
+#define BENCH_SOCKET_NAME "\0/glibhelper/bench-backend"
+#define BENCH_PACKET_SIZE (64)
+#define BENCH_WINDOW (8)	// Packets in flight per client
+#define BENCH_ROUND_TRIPS (200000)
+#define BENCH_SESSIONS (1000)
+
+typedef struct s_bench_backend_data {
+	uint64_t accepted;
+	uint64_t sent;
+	uint64_t received;
+	uint64_t target;
+} bench_backend_data;
+
+static uint8_t bench_packet[BENCH_PACKET_SIZE];
+//-----------------------------------------------------------------------------
+static uint64_t bench_time(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+static size_t bench_heap(void)
+{
+	struct mallinfo2 mi = mallinfo2();
+
+	return mi.uordblks;
+}
+//-----------------------------------------------------------------------------
+static void get_new_session_cb(glibhelper_server_session_handle session)
+{
+	bench_backend_data *bd = (bench_backend_data *)glibhelper_server_get_userdata(session);
+
+	bd->accepted++;
+}
+//-----------------------------------------------------------------------------
+static gboolean receive_cb(glibhelper_server_session_handle session)
+{
+	uint8_t buf[BENCH_PACKET_SIZE];
+	ssize_t ret = -1;
+
+	// Echo
+	ret = glibhelper_server_socket_read(session, buf, sizeof(buf));
+	if (ret > 0)
+		(void)glibhelper_server_socket_write(session, buf, (size_t)ret);
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean client_receive_cb(glibhelper_client_session_handle session)
+{
+	bench_backend_data *bd = (bench_backend_data *)glibhelper_client_get_userdata(session);
+	uint8_t buf[BENCH_PACKET_SIZE];
+
+	if (glibhelper_client_socket_read(session, buf, sizeof(buf)) <= 0)
+		return TRUE;
+
+	bd->received++;
+	if (bd->sent < bd->target) {
+		if (glibhelper_client_socket_write(session, bench_packet, sizeof(bench_packet)) > 0)
+			bd->sent++;
+	}
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean bench_server(glibhelper_unix_socket_server_support *svhandle, bench_backend_data *bd)
+{
+	glibhelper_server_socket_config scfg;
+
+	memset(&scfg, 0, sizeof(scfg));
+	memcpy(scfg.socket_name, BENCH_SOCKET_NAME, sizeof(BENCH_SOCKET_NAME));
+	scfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(BENCH_PACKET_SIZE * 2, BENCH_WINDOW * 2);
+	scfg.operation.get_new_session = get_new_session_cb;
+	scfg.operation.receive = receive_cb;
+
+	if (glibhelper_create_server_socket(svhandle, NULL, &scfg, bd) != TRUE) {
+		fprintf(stderr, "glibhelper_create_server_socket error\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean bench_connect(glibhelper_unix_socket_client_support *clihandle, bench_backend_data *bd)
+{
+	glibhelper_client_socket_config ccfg;
+
+	memset(&ccfg, 0, sizeof(ccfg));
+	memcpy(ccfg.socket_name, BENCH_SOCKET_NAME, sizeof(BENCH_SOCKET_NAME));
+	ccfg.operation.receive = client_receive_cb;
+
+	if (glibhelper_connect_socket(clihandle, NULL, &ccfg, bd) != TRUE) {
+		fprintf(stderr, "glibhelper_connect_socket error\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static int run_throughput(int num_of_client)
+{
+	glibhelper_unix_socket_server_support svhandle = NULL;
+	glibhelper_unix_socket_client_support *clihandle = NULL;
+	bench_backend_data svdata;
+	bench_backend_data clidata;
+	uint64_t start = 0, elapsed = 0;
+	int ret = -1;
+
+	memset(&svdata, 0, sizeof(svdata));
+	memset(&clidata, 0, sizeof(clidata));
+	clidata.target = BENCH_ROUND_TRIPS;
+
+	clihandle = (glibhelper_unix_socket_client_support*)calloc(num_of_client, sizeof(glibhelper_unix_socket_client_support));
+	if (clihandle == NULL)
+		return -1;
+
+	if (bench_server(&svhandle, &svdata) != TRUE)
+		goto out;
+
+	for (int i = 0; i < num_of_client; i++) {
+		if (bench_connect(&clihandle[i], &clidata) != TRUE)
+			goto out;
+		while (svdata.accepted < (uint64_t)(i + 1))
+			(void)bench_iteration(TRUE);
+	}
+
+	start = bench_time();
+	for (int i = 0; i < num_of_client; i++) {
+		for (int j = 0; j < BENCH_WINDOW && clidata.sent < clidata.target; j++) {
+			if (glibhelper_client_socket_write(clihandle[i], bench_packet, sizeof(bench_packet)) > 0)
+				clidata.sent++;
+		}
+	}
+	while (clidata.received < clidata.sent)
+		(void)bench_iteration(TRUE);
+	elapsed = bench_time() - start;
+
+	fprintf(stdout, "backend=%s clients=%d round_trips=%lu time=%.3fs round_trips/s=%.0f\n",
+			BENCH_BACKEND, num_of_client, (unsigned long)clidata.received, (double)elapsed / 1e9,
+			(double)clidata.received * 1e9 / (double)elapsed);
+	ret = 0;
+
+out:
+	for (int i = 0; i < num_of_client; i++) {
+		if (clihandle[i] != NULL)
+			glibhelper_terminate_client_socket(clihandle[i]);
+	}
+	if (svhandle != NULL)
+		glibhelper_terminate_server_socket(svhandle);
+	free(clihandle);
+
+	return ret;
+}
+//-----------------------------------------------------------------------------
+static int run_memory(int num_of_session)
+{
+	glibhelper_unix_socket_server_support svhandle = NULL;
+	glibhelper_unix_socket_client_support *clihandle = NULL;
+	bench_backend_data svdata;
+	bench_backend_data clidata;
+	size_t before = 0, connected = 0;
+	size_t server_bytes = 0, client_bytes = 0;
+	int ret = -1;
+
+	memset(&svdata, 0, sizeof(svdata));
+	memset(&clidata, 0, sizeof(clidata));
+
+	clihandle = (glibhelper_unix_socket_client_support*)calloc(num_of_session + 1, sizeof(glibhelper_unix_socket_client_support));
+	if (clihandle == NULL)
+		return -1;
+
+	if (bench_server(&svhandle, &svdata) != TRUE)
+		goto out;
+
+	// First session allocates the loop resources. It is not counted.
+	for (int i = 0; i <= num_of_session; i++) {
+		before = bench_heap();
+		if (bench_connect(&clihandle[i], &clidata) != TRUE)
+			goto out;
+		connected = bench_heap();
+		while (svdata.accepted < (uint64_t)(i + 1))
+			(void)bench_iteration(TRUE);
+		if (i == 0)
+			continue;
+		client_bytes += connected - before;
+		server_bytes += bench_heap() - connected;
+	}
+
+	fprintf(stdout, "backend=%s sessions=%d server_bytes/session=%.1f client_bytes/session=%.1f\n",
+			BENCH_BACKEND, num_of_session, (double)server_bytes / num_of_session, (double)client_bytes / num_of_session);
+	ret = 0;
+
+out:
+	for (int i = 0; i <= num_of_session; i++) {
+		if (clihandle[i] != NULL)
+			glibhelper_terminate_client_socket(clihandle[i]);
+	}
+	if (svhandle != NULL)
+		glibhelper_terminate_server_socket(svhandle);
+	free(clihandle);
+
+	return ret;
+}
+//-----------------------------------------------------------------------------
+int main (void)
+{
+	int clients[] = {1, 16, 128};
+
+	memset(bench_packet, 0xa5, sizeof(bench_packet));
+
+	for (size_t i = 0; i < (sizeof(clients) / sizeof(clients[0])); i++) {
+		if (run_throughput(clients[i]) < 0)
+			return -1;
+	}
+
+	if (run_memory(BENCH_SESSIONS) < 0)
+		return -1;
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-distributor.c
+ * @brief	skewed job benchmark for internal distributor with and without work stealing
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-internal-distributor.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_WORKER (4)
+#define BENCH_JOB (20000)
+#define BENCH_HEAVY_LOOP (20000)
+#define BENCH_LIGHT_LOOP (200)
+
+typedef struct s_bench_distributor_data {
+	gint num_of_done;
+} bench_distributor_data;
+
+typedef struct s_bench_job {
+	int loop;
+} bench_job;
+
+static bench_job jobs[BENCH_JOB];
+//-----------------------------------------------------------------------------
+static void job_cb(glibhelper_distributor_worker_handle worker, void *job)
+{
+	bench_distributor_data *bd = (bench_distributor_data *)glibhelper_internal_distributor_get_userdata(worker);
+	volatile uint64_t value = 0;
+
+	for (int i = 0; i < ((bench_job*)job)->loop; i++)
+		value += (uint64_t)i * (uint64_t)i;
+
+	g_atomic_int_inc(&bd->num_of_done);
+}
+//-----------------------------------------------------------------------------
+static gpointer workerthread(gpointer data)
+{
+	g_main_loop_run((GMainLoop*)data);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean steal)
+{
+	GMainContext *ctx[BENCH_WORKER];
+	GMainLoop *loop[BENCH_WORKER];
+	GThread *thread[BENCH_WORKER];
+	glibhelper_internal_distributor dist = NULL;
+	glibhelper_internal_distributor_config cfg;
+	glibhelper_distributor_worker_stats stats;
+	bench_distributor_data bd;
+	gint64 start = 0, end = 0;
+	int max_depth = 0;
+	int depth = 0;
+
+	memset(&bd, 0, sizeof(bd));
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.operation.job = job_cb;
+	cfg.num_of_worker = BENCH_WORKER;
+	cfg.disable_steal = (steal == TRUE) ? FALSE : TRUE;
+
+	for (int i = 0; i < BENCH_WORKER; i++) {
+		ctx[i] = g_main_context_new();
+		loop[i] = g_main_loop_new(ctx[i], FALSE);
+	}
+
+	if (glibhelper_create_internal_distributor(&dist, ctx, &cfg, &bd) != TRUE) {
+		fprintf(stderr, "distributor create error\n");
+		return -1;
+	}
+
+	for (int i = 0; i < BENCH_WORKER; i++)
+		thread[i] = g_thread_new("bench_worker", workerthread, loop[i]);
+
+	start = g_get_monotonic_time();
+
+	// Round robin post puts all heavy jobs on worker 0.
+	for (int i = 0; i < BENCH_JOB; i++)
+		(void)glibhelper_internal_distributor_post(dist, &jobs[i]);
+
+	while (g_atomic_int_get(&bd.num_of_done) < BENCH_JOB) {
+		depth = glibhelper_internal_distributor_get_queue_depth(dist);
+		if (depth > max_depth)
+			max_depth = depth;
+		g_usleep(100);
+	}
+
+	end = g_get_monotonic_time();
+
+	fprintf(stdout, "steal=%s jobs=%d elapsed_ms=%.1f max_queue_depth=%d\n",
+			(steal == TRUE) ? "on " : "off", BENCH_JOB, (double)(end - start) / 1000.0, max_depth);
+
+	for (int i = 0; i < BENCH_WORKER; i++) {
+		(void)glibhelper_internal_distributor_get_worker_stats(dist, i, &stats);
+		fprintf(stdout, "  worker%d posted=%lu executed=%lu stolen=%lu\n",
+				i, stats.posted, stats.executed, stats.stolen);
+	}
+
+	for (int i = 0; i < BENCH_WORKER; i++) {
+		g_main_loop_quit(loop[i]);
+		g_main_context_wakeup(ctx[i]);
+		(void)g_thread_join(thread[i]);
+	}
+
+	glibhelper_terminate_internal_distributor(dist);
+
+	for (int i = 0; i < BENCH_WORKER; i++) {
+		g_main_loop_unref(loop[i]);
+		g_main_context_unref(ctx[i]);
+	}
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	for (int i = 0; i < BENCH_JOB; i++)
+		jobs[i].loop = ((i % BENCH_WORKER) == 0) ? BENCH_HEAVY_LOOP : BENCH_LIGHT_LOOP;
+
+	if (run_bench(FALSE) < 0)
+		return -1;
+
+	if (run_bench(TRUE) < 0)
+		return -1;
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-drain.c
+ * @brief	benchmark for drain mode (receive_budget) of the server socket helper
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-unix-socket-support.h"
+#include "glibhelper-unix-socket-support-util.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_PACKET_SIZE (256)
+#define BENCH_BURST (32)
+#define BENCH_ROUNDS (10000)
+
+typedef struct s_bench_drain_data {
+	glibhelper_server_session_handle session;
+	uint64_t num_of_read;
+	uint64_t num_of_packet;
+} bench_drain_data;
+
+//-----------------------------------------------------------------------------
+static void get_new_session_cb(glibhelper_server_session_handle session)
+{
+	bench_drain_data *bd = (bench_drain_data *)glibhelper_server_get_userdata(session);
+
+	bd->session = session;
+}
+//-----------------------------------------------------------------------------
+static gboolean receive_cb(glibhelper_server_session_handle session)
+{
+	bench_drain_data *bd = (bench_drain_data *)glibhelper_server_get_userdata(session);
+	uint8_t buf[BENCH_PACKET_SIZE];
+	ssize_t ret = -1;
+
+	ret = glibhelper_server_socket_read(session, buf, sizeof(buf));
+	bd->num_of_read++;
+	if (ret > 0)
+		bd->num_of_packet++;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean client_receive_cb(glibhelper_client_session_handle session)
+{
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(int receive_budget)
+{
+	glibhelper_server_socket_config scfg;
+	glibhelper_client_socket_config ccfg;
+	glibhelper_unix_socket_server_support svhandle = NULL;
+	glibhelper_unix_socket_client_support clihandle = NULL;
+	bench_drain_data bd;
+	uint8_t packet[BENCH_PACKET_SIZE];
+	uint64_t num_of_iteration = 0;
+	uint64_t expected = 0;
+
+	memset(&bd, 0, sizeof(bd));
+	memset(&scfg, 0, sizeof(scfg));
+	memset(&ccfg, 0, sizeof(ccfg));
+	memset(packet, 0xa5, sizeof(packet));
+
+	memcpy(scfg.socket_name, "\0/glibhelper/bench-drain", sizeof("\0/glibhelper/bench-drain"));
+	scfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(BENCH_PACKET_SIZE * 2, BENCH_BURST);
+	scfg.operation.get_new_session = get_new_session_cb;
+	scfg.operation.receive = receive_cb;
+	scfg.receive_budget = receive_budget;
+
+	memcpy(ccfg.socket_name, scfg.socket_name, sizeof(ccfg.socket_name));
+	ccfg.operation.receive = client_receive_cb;
+
+	if (glibhelper_create_server_socket(&svhandle, NULL, &scfg, &bd) != TRUE) {
+		fprintf(stderr, "glibhelper_create_server_socket error\n");
+		return -1;
+	}
+
+	if (glibhelper_connect_socket(&clihandle, NULL, &ccfg, NULL) != TRUE) {
+		fprintf(stderr, "glibhelper_connect_socket error\n");
+		glibhelper_terminate_server_socket(svhandle);
+		return -1;
+	}
+
+	while (bd.session == NULL)
+		(void)g_main_context_iteration(NULL, TRUE);
+
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		for (int i = 0; i < BENCH_BURST; i++) {
+			if (glibhelper_client_socket_write(clihandle, packet, sizeof(packet)) > 0)
+				expected++;
+		}
+
+		while (bd.num_of_packet < expected) {
+			(void)g_main_context_iteration(NULL, TRUE);
+			num_of_iteration++;
+		}
+	}
+
+	// One loop iteration is one poll() call, one receive callback is one read() call.
+	fprintf(stdout, "receive_budget=%d packets=%lu poll=%lu read=%lu poll/packet=%.3f syscall/packet=%.3f\n",
+			receive_budget, bd.num_of_packet, num_of_iteration, bd.num_of_read,
+			(double)num_of_iteration / (double)bd.num_of_packet,
+			(double)(num_of_iteration + bd.num_of_read) / (double)bd.num_of_packet);
+
+	glibhelper_terminate_client_socket(clihandle);
+	glibhelper_terminate_server_socket(svhandle);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	int budget[] = {0, 4, 16, 64};
+
+	for (int i = 0; i < (sizeof(budget) / sizeof(budget[0])); i++) {
+		if (run_bench(budget[i]) < 0)
+			return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,240 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-internal.c
+ * @brief	cross thread latency benchmark for internal socket and internal ring
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+#include "glibhelper-unix-socket-support.h"
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-internal-ring.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_PACKET_SIZE (64)
+#define BENCH_ROUNDTRIP (200000)
+#define BENCH_STREAM (2000000)
+#define BENCH_QUEUE (256)
+
+typedef ssize_t (*fp_bench_read)(void *handle, void *buf, size_t count);
+typedef ssize_t (*fp_bench_write)(void *handle, void *buf, size_t count);
+
+typedef struct s_bench_internal_data {
+	GMainLoop *loop;
+	fp_bench_read read;
+	fp_bench_write write;
+	uint64_t num_of_roundtrip;
+	gint num_of_stream;
+	gboolean stream;
+} bench_internal_data;
+
+//-----------------------------------------------------------------------------
+static ssize_t socket_read(void *handle, void *buf, size_t count)
+{
+	return glibhelper_internal_socket_read(handle, buf, count);
+}
+//-----------------------------------------------------------------------------
+static ssize_t socket_write(void *handle, void *buf, size_t count)
+{
+	return glibhelper_internal_socket_write(handle, buf, count);
+}
+//-----------------------------------------------------------------------------
+static ssize_t ring_read(void *handle, void *buf, size_t count)
+{
+	return glibhelper_internal_ring_read(handle, buf, count);
+}
+//-----------------------------------------------------------------------------
+static ssize_t ring_write(void *handle, void *buf, size_t count)
+{
+	return glibhelper_internal_ring_write(handle, buf, count);
+}
+//-----------------------------------------------------------------------------
+static void* get_userdata(void *handle, gboolean is_ring)
+{
+	if (is_ring == TRUE)
+		return glibhelper_internal_ring_get_userdata(handle);
+
+	return glibhelper_internal_get_userdata(handle);
+}
+//-----------------------------------------------------------------------------
+static gboolean is_ring_mode = FALSE;
+
+static gboolean receive_cb_primary(glibhelper_internal_session_handle session)
+{
+	bench_internal_data *bd = (bench_internal_data *)get_userdata(session, is_ring_mode);
+	uint8_t buf[BENCH_PACKET_SIZE];
+
+	if (bd->read(session, buf, sizeof(buf)) <= 0)
+		return TRUE;
+
+	bd->num_of_roundtrip++;
+	if (bd->num_of_roundtrip >= BENCH_ROUNDTRIP)
+		g_main_loop_quit(bd->loop);
+	else
+		(void)bd->write(session, buf, sizeof(buf));
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean receive_cb_secondary(glibhelper_internal_session_handle session)
+{
+	bench_internal_data *bd = (bench_internal_data *)get_userdata(session, is_ring_mode);
+	uint8_t buf[BENCH_PACKET_SIZE];
+
+	if (bd->read(session, buf, sizeof(buf)) <= 0)
+		return TRUE;
+
+	if (bd->stream == TRUE)
+		g_atomic_int_inc(&bd->num_of_stream);
+	else
+		(void)bd->write(session, buf, sizeof(buf));	// Echo back
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gpointer subthread(gpointer data)
+{
+	g_main_loop_run((GMainLoop*)data);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static double get_cpu_time(void)
+{
+	struct rusage usage;
+
+	(void)getrusage(RUSAGE_SELF, &usage);
+
+	return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1000000.0
+		+ (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1000000.0;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean is_ring)
+{
+	GMainContext *subctx = NULL;
+	GMainLoop *gsubloop = NULL;
+	GThread *sub_thread = NULL;
+	bench_internal_data bd_primary, bd_secondary;
+	glibhelper_internal_socket_config inscfg;
+	glibhelper_internal_ring_config ringcfg;
+	void *primary = NULL;
+	void *secondary = NULL;
+	uint8_t buf[BENCH_PACKET_SIZE];
+	gint64 start = 0, end = 0;
+	double cpu_start = 0.0, cpu_end = 0.0;
+	gboolean bret = FALSE;
+
+	is_ring_mode = is_ring;
+
+	memset(&bd_primary, 0, sizeof(bd_primary));
+	memset(&bd_secondary, 0, sizeof(bd_secondary));
+	memset(buf, 0, sizeof(buf));
+
+	bd_primary.loop = g_main_loop_new(NULL, FALSE);
+	bd_primary.read = (is_ring == TRUE) ? ring_read : socket_read;
+	bd_primary.write = (is_ring == TRUE) ? ring_write : socket_write;
+	bd_secondary.read = bd_primary.read;
+	bd_secondary.write = bd_primary.write;
+
+	subctx = g_main_context_new();
+	gsubloop = g_main_loop_new(subctx, FALSE);
+
+	if (is_ring == TRUE) {
+		memset(&ringcfg, 0, sizeof(ringcfg));
+		ringcfg.packet_max_size = BENCH_PACKET_SIZE;
+		ringcfg.packet_max_num = BENCH_QUEUE;
+		ringcfg.operation.receive = receive_cb_primary;
+		bret = glibhelper_create_internal_ring((glibhelper_internal_ring*)&primary, NULL, &ringcfg, &bd_primary);
+		ringcfg.operation.receive = receive_cb_secondary;
+		if (bret == TRUE)
+			bret = glibhelper_bind_secondary_internal_ring((glibhelper_internal_ring*)&secondary, primary, subctx, &ringcfg, &bd_secondary);
+	} else {
+		memset(&inscfg, 0, sizeof(inscfg));
+		inscfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(BENCH_PACKET_SIZE, BENCH_QUEUE);
+		inscfg.operation.receive = receive_cb_primary;
+		bret = glibhelper_create_internal_socket((glibhelper_unix_socket_internal_support*)&primary, NULL, &inscfg, &bd_primary);
+		inscfg.operation.receive = receive_cb_secondary;
+		if (bret == TRUE)
+			bret = glibhelper_bind_secondary_internal_socket((glibhelper_unix_socket_internal_support*)&secondary, primary, subctx, &inscfg, &bd_secondary);
+	}
+
+	if (bret != TRUE) {
+		fprintf(stderr, "internal channel create error\n");
+		return -1;
+	}
+
+	sub_thread = g_thread_new("bench_sub", subthread, gsubloop);
+
+	cpu_start = get_cpu_time();
+	start = g_get_monotonic_time();
+
+	(void)bd_primary.write(primary, buf, sizeof(buf));
+	g_main_loop_run(bd_primary.loop);
+
+	end = g_get_monotonic_time();
+	cpu_end = get_cpu_time();
+
+	fprintf(stdout, "%s roundtrip=%lu avg_rtt_us=%.3f cpu_us_per_roundtrip=%.3f\n",
+			(is_ring == TRUE) ? "internal_ring  " : "internal_socket",
+			bd_primary.num_of_roundtrip,
+			(double)(end - start) / (double)bd_primary.num_of_roundtrip,
+			(cpu_end - cpu_start) * 1000000.0 / (double)bd_primary.num_of_roundtrip);
+
+	// Stream from main thread to sub thread. Busy consumer does not need wakeup.
+	g_atomic_int_set(&bd_secondary.stream, TRUE);
+
+	cpu_start = get_cpu_time();
+	start = g_get_monotonic_time();
+
+	for (int i = 0; i < BENCH_STREAM; i++) {
+		while (bd_primary.write(primary, buf, sizeof(buf)) < 0)
+			g_thread_yield();
+	}
+	while (g_atomic_int_get(&bd_secondary.num_of_stream) < BENCH_STREAM)
+		g_thread_yield();
+
+	end = g_get_monotonic_time();
+	cpu_end = get_cpu_time();
+
+	fprintf(stdout, "%s stream=%d msg_per_sec=%.0f cpu_us_per_msg=%.3f\n",
+			(is_ring == TRUE) ? "internal_ring  " : "internal_socket",
+			BENCH_STREAM,
+			(double)BENCH_STREAM * 1000000.0 / (double)(end - start),
+			(cpu_end - cpu_start) * 1000000.0 / (double)BENCH_STREAM);
+
+	g_main_loop_quit(gsubloop);
+	(void)g_thread_join(sub_thread);
+
+	if (is_ring == TRUE) {
+		glibhelper_terminate_internal_ring(secondary);
+		glibhelper_terminate_internal_ring(primary);
+	} else {
+		glibhelper_terminate_internal_socket(secondary);
+		glibhelper_terminate_internal_socket(primary);
+	}
+
+	g_main_loop_unref(gsubloop);
+	g_main_context_unref(subctx);
+	g_main_loop_unref(bd_primary.loop);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	if (run_bench(FALSE) < 0)
+		return -1;
+
+	if (run_bench(TRUE) < 0)
+		return -1;
+
+	return 0;
+}
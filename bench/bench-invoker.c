@@ -0,0 +1,124 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-invoker.c
+ * @brief	cross context call benchmark for g_main_context_invoke and invoker
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+#include "glibhelper-invoker.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_CALL (1000000)
+#define BENCH_BURST (1000)
+
+static gint num_of_called = 0;
+//-----------------------------------------------------------------------------
+static void invoke_cb(void *data)
+{
+	g_atomic_int_inc(&num_of_called);
+}
+//-----------------------------------------------------------------------------
+static gboolean context_invoke_cb(gpointer data)
+{
+	g_atomic_int_inc(&num_of_called);
+
+	return G_SOURCE_REMOVE;
+}
+//-----------------------------------------------------------------------------
+static gpointer subthread(gpointer data)
+{
+	g_main_loop_run((GMainLoop*)data);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static double get_cpu_time(void)
+{
+	struct rusage usage;
+
+	(void)getrusage(RUSAGE_SELF, &usage);
+
+	return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1000000.0
+		+ (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1000000.0;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean is_invoker)
+{
+	GMainContext *subctx = NULL;
+	GMainLoop *gsubloop = NULL;
+	GThread *sub_thread = NULL;
+	glibhelper_invoker invoker = NULL;
+	gint64 start = 0, end = 0;
+	double cpu_start = 0.0, cpu_end = 0.0;
+
+	g_atomic_int_set(&num_of_called, 0);
+
+	subctx = g_main_context_new();
+	gsubloop = g_main_loop_new(subctx, FALSE);
+
+	if (is_invoker == TRUE && glibhelper_create_invoker(&invoker, subctx, NULL) != TRUE) {
+		fprintf(stderr, "invoker create error\n");
+		return -1;
+	}
+
+	sub_thread = g_thread_new("bench_sub", subthread, gsubloop);
+
+	cpu_start = get_cpu_time();
+	start = g_get_monotonic_time();
+
+	for (int i = 0; i < BENCH_CALL; i++) {
+		if (is_invoker == TRUE)
+			(void)glibhelper_invoker_post(invoker, invoke_cb, NULL);
+		else
+			g_main_context_invoke(subctx, context_invoke_cb, NULL);
+
+		if ((i % BENCH_BURST) == (BENCH_BURST - 1))
+			g_thread_yield();
+	}
+	while (g_atomic_int_get(&num_of_called) < BENCH_CALL)
+		g_thread_yield();
+
+	end = g_get_monotonic_time();
+	cpu_end = get_cpu_time();
+
+	fprintf(stdout, "%s calls=%d calls_per_sec=%.0f cpu_us_per_call=%.3f",
+			(is_invoker == TRUE) ? "glibhelper_invoker    " : "g_main_context_invoke",
+			BENCH_CALL,
+			(double)BENCH_CALL * 1000000.0 / (double)(end - start),
+			(cpu_end - cpu_start) * 1000000.0 / (double)BENCH_CALL);
+	if (is_invoker == TRUE)
+		fprintf(stdout, " wakeups=%u", glibhelper_invoker_get_wakeup_count(invoker));
+	fprintf(stdout, "\n");
+
+	g_main_loop_quit(gsubloop);
+	g_main_context_wakeup(subctx);
+	(void)g_thread_join(sub_thread);
+
+	if (invoker != NULL)
+		glibhelper_terminate_invoker(invoker);
+
+	g_main_loop_unref(gsubloop);
+	g_main_context_unref(subctx);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	if (run_bench(FALSE) < 0)
+		return -1;
+
+	if (run_bench(TRUE) < 0)
+		return -1;
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-jitter.c
+ * @brief	1ms periodic timer wakeup jitter benchmark for relative and absolute timerfd
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-timerfd-support.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_INTERVAL (1000 * 1000)	// ns
+#define BENCH_PHASE (250 * 1000)	// ns
+#define BENCH_DURATION (2000)	// ms
+
+//-----------------------------------------------------------------------------
+static gboolean timeout_cb(glibhelper_timerfd_support_handle handle, const glibhelper_timerfd_info *info)
+{
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean quit_cb(gpointer data)
+{
+	g_main_loop_quit((GMainLoop*)data);
+
+	return G_SOURCE_REMOVE;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean is_absolute)
+{
+	GMainLoop *loop = NULL;
+	glibhelper_timerfd_support_handle timerfd = NULL;
+	glibhelper_timerfd_config tcfg;
+	glibhelper_histogram_stats stats;
+
+	loop = g_main_loop_new(NULL, FALSE);
+
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.operation.timeout_ex = timeout_cb;
+	tcfg.interval = BENCH_INTERVAL;
+	tcfg.initial_delay = BENCH_INTERVAL;
+	tcfg.absolute = is_absolute;
+	tcfg.phase = BENCH_PHASE;
+	tcfg.jitter_stats = TRUE;
+	if (glibhelper_create_timerfd(&timerfd, NULL, &tcfg, NULL) != TRUE)
+		return -1;
+
+	(void)g_timeout_add(BENCH_DURATION, quit_cb, loop);
+	g_main_loop_run(loop);
+
+	(void)glibhelper_timerfd_get_jitter(timerfd, &stats);
+
+	fprintf(stdout, "%s ticks=%lu overrun=%lu jitter_us min=%.1f p50=%.1f p99=%.1f p99.9=%.1f max=%.1f\n",
+			(is_absolute == TRUE) ? "absolute" : "relative",
+			glibhelper_timerfd_get_expirations(timerfd), glibhelper_timerfd_get_overrun(timerfd),
+			(double)stats.min / 1000.0, (double)stats.p50 / 1000.0, (double)stats.p99 / 1000.0,
+			(double)stats.p999 / 1000.0, (double)stats.max / 1000.0);
+
+	glibhelper_terminate_timerfd(timerfd);
+	g_main_loop_unref(loop);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	if (run_bench(FALSE) < 0)
+		return -1;
+
+	if (run_bench(TRUE) < 0)
+		return -1;
+
+	return 0;
+}
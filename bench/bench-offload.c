@@ -0,0 +1,238 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-offload.c
+ * @brief	light session latency benchmark with heavy sessions for inline and offload receive handler
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "glibhelper-unix-socket-support.h"
+#include "glibhelper-histogram.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_SOCKET_NAME "\0/glibhelper/bench-offload"
+#define BENCH_HEAVY_CLIENT (2)
+#define BENCH_HEAVY_WORK (5000)	// us
+#define BENCH_PING (500)
+#define BENCH_PING_INTERVAL (1000)	// us
+#define BENCH_OFFLOAD_THREADS (4)
+
+enum bench_request {
+	BENCH_REQUEST_LIGHT = 0,
+	BENCH_REQUEST_HEAVY,
+};
+
+typedef struct s_bench_packet {
+	int request;
+	int64_t time;
+} bench_packet;
+
+static gint bench_stop = 0;
+//-----------------------------------------------------------------------------
+static void bench_work(bench_packet *packet)
+{
+	int64_t end = 0;
+
+	if (packet->request != BENCH_REQUEST_HEAVY)
+		return;
+
+	// CPU heavy handler
+	end = g_get_monotonic_time() + BENCH_HEAVY_WORK;
+	while (g_get_monotonic_time() < end)
+		;
+}
+//-----------------------------------------------------------------------------
+static gboolean receive_cb(glibhelper_server_session_handle session)
+{
+	bench_packet packet;
+
+	if (glibhelper_server_socket_read(session, &packet, sizeof(packet)) != sizeof(packet))
+		return TRUE;
+
+	bench_work(&packet);
+	(void)glibhelper_server_socket_write(session, &packet, sizeof(packet));
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void* offload_cb(glibhelper_server_session_id id, void *buf, size_t count, void *userdata)
+{
+	if (count != sizeof(bench_packet))
+		return NULL;
+
+	bench_work((bench_packet*)buf);
+
+	return g_memdup2(buf, count);
+}
+//-----------------------------------------------------------------------------
+static void offload_complete_cb(glibhelper_server_session_handle session, void *result)
+{
+	if (session != NULL && result != NULL)
+		(void)glibhelper_server_socket_write(session, result, sizeof(bench_packet));
+
+	g_free(result);
+}
+//-----------------------------------------------------------------------------
+static int bench_connect(void)
+{
+	struct sockaddr_un addr;
+	int fd = -1;
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, BENCH_SOCKET_NAME, sizeof(BENCH_SOCKET_NAME) - 1);
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(sa_family_t) + sizeof(BENCH_SOCKET_NAME) - 1) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+//-----------------------------------------------------------------------------
+static gpointer heavy_client(gpointer data)
+{
+	bench_packet packet;
+	int fd = bench_connect();
+
+	if (fd < 0)
+		return NULL;
+
+	while (g_atomic_int_get(&bench_stop) == 0) {
+		packet.request = BENCH_REQUEST_HEAVY;
+		packet.time = g_get_monotonic_time();
+		if (write(fd, &packet, sizeof(packet)) != sizeof(packet))
+			break;
+		if (read(fd, &packet, sizeof(packet)) != sizeof(packet))
+			break;
+	}
+
+	close(fd);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static gpointer light_client(gpointer data)
+{
+	glibhelper_histogram histogram = (glibhelper_histogram)data;
+	bench_packet packet;
+	int fd = bench_connect();
+
+	if (fd < 0)
+		return NULL;
+
+	for (int i = 0; i < BENCH_PING; i++) {
+		packet.request = BENCH_REQUEST_LIGHT;
+		packet.time = g_get_monotonic_time();
+		if (write(fd, &packet, sizeof(packet)) != sizeof(packet))
+			break;
+		if (read(fd, &packet, sizeof(packet)) != sizeof(packet))
+			break;
+		glibhelper_histogram_record(histogram, (uint64_t)(g_get_monotonic_time() - packet.time));
+		g_usleep(BENCH_PING_INTERVAL);
+	}
+
+	close(fd);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static gboolean check_done(gpointer data)
+{
+	if (g_atomic_int_get(&bench_stop) != 0) {
+		g_main_loop_quit((GMainLoop*)data);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean quit_cb(gpointer data)
+{
+	g_main_loop_quit((GMainLoop*)data);
+
+	return G_SOURCE_REMOVE;
+}
+//-----------------------------------------------------------------------------
+static gpointer light_runner(gpointer data)
+{
+	(void)light_client(data);
+	g_atomic_int_set(&bench_stop, 1);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean is_offload)
+{
+	GMainLoop *loop = NULL;
+	glibhelper_unix_socket_server_support server = NULL;
+	glibhelper_server_socket_config scfg;
+	glibhelper_histogram histogram = NULL;
+	glibhelper_histogram_stats stats;
+	GThread *heavy[BENCH_HEAVY_CLIENT];
+	GThread *light = NULL;
+
+	g_atomic_int_set(&bench_stop, 0);
+	loop = g_main_loop_new(NULL, FALSE);
+
+	memset(&scfg, 0, sizeof(scfg));
+	memcpy(scfg.socket_name, BENCH_SOCKET_NAME, sizeof(BENCH_SOCKET_NAME));
+	scfg.operation.receive = receive_cb;
+	if (is_offload == TRUE) {
+		scfg.operation.offload = offload_cb;
+		scfg.operation.offload_complete = offload_complete_cb;
+		scfg.offload_threads = BENCH_OFFLOAD_THREADS;
+	}
+	if (glibhelper_create_server_socket(&server, NULL, &scfg, NULL) != TRUE)
+		return -1;
+	if (glibhelper_create_histogram(&histogram) != TRUE)
+		return -1;
+
+	for (int i = 0; i < BENCH_HEAVY_CLIENT; i++)
+		heavy[i] = g_thread_new("bench_heavy", heavy_client, NULL);
+	light = g_thread_new("bench_light", light_runner, histogram);
+
+	(void)g_timeout_add(10, check_done, loop);
+	g_main_loop_run(loop);
+
+	(void)g_thread_join(light);
+	// Heavy clients wait the last reply.
+	(void)g_timeout_add(BENCH_HEAVY_WORK / 1000 * 4, quit_cb, loop);
+	g_main_loop_run(loop);
+	for (int i = 0; i < BENCH_HEAVY_CLIENT; i++)
+		(void)g_thread_join(heavy[i]);
+
+	(void)glibhelper_histogram_get_stats(histogram, &stats);
+	fprintf(stdout, "%s light_rtt_us p50=%lu p99=%lu p99.9=%lu max=%lu\n",
+			(is_offload == TRUE) ? "offload" : "inline ",
+			(unsigned long)stats.p50, (unsigned long)stats.p99, (unsigned long)stats.p999, (unsigned long)stats.max);
+
+	(void)glibhelper_terminate_histogram(histogram);
+	(void)glibhelper_terminate_server_socket(server);
+	g_main_loop_unref(loop);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	if (run_bench(FALSE) < 0)
+		return -1;
+
+	if (run_bench(TRUE) < 0)
+		return -1;
+
+	return 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-pingpong.c
+ * @brief	ping-pong round trip latency benchmark of server/client socket helpers
+ *
+ * One client sends a packet, the server echoes it and the client sends next packet after the echo.
+ * The round trip time is measured for each message size in two modes:
+ *   single : server and client in one context and thread.
+ *   cross  : server in a loop thread, client in the main thread.
+ * Results are written to stdout as JSON lines, one object per mode and size.
+ *
+ * usage : bench_pingpong [round trips per case]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "glibhelper-unix-socket-support.h"
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-histogram.h"
+#include "glibhelper-loop-thread.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_SOCKET_NAME "\0/glibhelper/bench-pingpong"
+#define BENCH_PACKET_MAX (4096)
+#define BENCH_ROUND_TRIPS (20000)
+#define BENCH_WARMUP (1000)	// Round trips not recorded
+
+typedef struct s_bench_pingpong_data {
+	glibhelper_histogram rtt;
+	uint8_t packet[BENCH_PACKET_MAX];
+	size_t size;
+	int warmup;
+	int remaining;
+	gboolean done;
+	gboolean error;	// Run stopped by unexpected echo, write error or server close
+	glibhelper_unix_socket_client_support client;	// NULL after the helper released itself at server close
+} bench_pingpong_data;
+
+//-----------------------------------------------------------------------------
+static uint64_t bench_time(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+static gboolean receive_cb(glibhelper_server_session_handle session)
+{
+	uint8_t buf[BENCH_PACKET_MAX];
+	ssize_t ret = -1;
+
+	// Echo
+	ret = glibhelper_server_socket_read(session, buf, sizeof(buf));
+	if (ret > 0)
+		(void)glibhelper_server_socket_write(session, buf, (size_t)ret);
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean bench_ping(glibhelper_client_session_handle session, bench_pingpong_data *pd)
+{
+	uint64_t now = bench_time();
+
+	// Send time is carried in the packet.
+	memcpy(pd->packet, &now, sizeof(now));
+	if (glibhelper_client_socket_write(session, pd->packet, pd->size) != (ssize_t)pd->size)
+		return FALSE;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean client_receive_cb(glibhelper_client_session_handle session)
+{
+	bench_pingpong_data *pd = (bench_pingpong_data *)glibhelper_client_get_userdata(session);
+	uint8_t buf[BENCH_PACKET_MAX];
+	uint64_t sent = 0;
+	uint64_t now = 0;
+	ssize_t ret = -1;
+
+	// The next ping is sent only after the echo, a lost or short echo stops the run.
+	ret = glibhelper_client_socket_read(session, buf, sizeof(buf));
+	if (ret != (ssize_t)pd->size) {
+		if (ret < 0 && errno == EAGAIN)
+			return TRUE;
+		fprintf(stderr, "unexpected echo : ret=%ld size=%lu %s\n", (long)ret, (unsigned long)pd->size,
+				(ret < 0) ? strerror(errno) : "");
+		pd->error = TRUE;
+		pd->done = TRUE;
+		return TRUE;
+	}
+
+	now = bench_time();
+	memcpy(&sent, buf, sizeof(sent));
+
+	if (pd->warmup > 0) {
+		pd->warmup--;
+	} else {
+		glibhelper_histogram_record(pd->rtt, now - sent);
+		pd->remaining--;
+	}
+
+	if (pd->remaining <= 0) {
+		pd->done = TRUE;
+	} else if (bench_ping(session, pd) == FALSE) {
+		fprintf(stderr, "glibhelper_client_socket_write error : %s\n", strerror(errno));
+		pd->error = TRUE;
+		pd->done = TRUE;
+	}
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void client_destroyed_session_cb(glibhelper_client_session_handle session)
+{
+	bench_pingpong_data *pd = (bench_pingpong_data *)glibhelper_client_get_userdata(session);
+
+	// The client helper is released after this callback.
+	pd->client = NULL;
+	if (pd->done == FALSE) {
+		fprintf(stderr, "server closed the session\n");
+		pd->error = TRUE;
+		pd->done = TRUE;
+	}
+}
+//-----------------------------------------------------------------------------
+static void bench_report(const char *mode, bench_pingpong_data *pd)
+{
+	glibhelper_histogram_stats stats;
+
+	memset(&stats, 0, sizeof(stats));
+	(void)glibhelper_histogram_get_stats(pd->rtt, &stats);
+
+	fprintf(stdout, "{\"bench\":\"pingpong\",\"mode\":\"%s\",\"size\":%lu,\"count\":%lu,"
+			"\"min_ns\":%lu,\"mean_ns\":%lu,\"p50_ns\":%lu,\"p99_ns\":%lu,\"p999_ns\":%lu,\"max_ns\":%lu}\n",
+			mode, (unsigned long)pd->size, (unsigned long)stats.count,
+			(unsigned long)stats.min, (unsigned long)stats.mean, (unsigned long)stats.p50,
+			(unsigned long)stats.p99, (unsigned long)stats.p999, (unsigned long)stats.max);
+	fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean cross, size_t size, int round_trips)
+{
+	glibhelper_loop_thread loopthread = NULL;
+	glibhelper_loop_thread_config lcfg;
+	GMainContext *svcontext = NULL;
+	glibhelper_server_socket_config scfg;
+	glibhelper_client_socket_config ccfg;
+	glibhelper_unix_socket_server_support svhandle = NULL;
+	bench_pingpong_data *pd = NULL;
+	int ret = -1;
+
+	pd = (bench_pingpong_data *)g_malloc(sizeof(bench_pingpong_data));
+	if (pd == NULL)
+		return -1;
+	memset(pd, 0, sizeof(bench_pingpong_data));
+	memset(pd->packet, 0xa5, sizeof(pd->packet));
+	pd->size = size;
+	pd->warmup = BENCH_WARMUP;
+	pd->remaining = round_trips;
+
+	if (glibhelper_create_histogram(&pd->rtt) != TRUE)
+		goto out;
+
+	if (cross == TRUE) {
+		memset(&lcfg, 0, sizeof(lcfg));
+		lcfg.name = "bench-server";
+		if (glibhelper_create_loop_thread(&loopthread, &lcfg) != TRUE) {
+			fprintf(stderr, "glibhelper_create_loop_thread error\n");
+			goto out;
+		}
+		svcontext = glibhelper_loop_thread_get_context(loopthread);
+	}
+
+	memset(&scfg, 0, sizeof(scfg));
+	memset(&ccfg, 0, sizeof(ccfg));
+
+	memcpy(scfg.socket_name, BENCH_SOCKET_NAME, sizeof(BENCH_SOCKET_NAME));
+	scfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(BENCH_PACKET_MAX, 4);
+	scfg.operation.receive = receive_cb;
+
+	memcpy(ccfg.socket_name, scfg.socket_name, sizeof(ccfg.socket_name));
+	ccfg.operation.receive = client_receive_cb;
+	ccfg.operation.destroyed_session = client_destroyed_session_cb;
+
+	if (glibhelper_create_server_socket(&svhandle, svcontext, &scfg, NULL) != TRUE) {
+		fprintf(stderr, "glibhelper_create_server_socket error\n");
+		goto out;
+	}
+
+	if (glibhelper_connect_socket(&pd->client, NULL, &ccfg, pd) != TRUE) {
+		fprintf(stderr, "glibhelper_connect_socket error\n");
+		goto out;
+	}
+
+	// The connection is queued until the server accepts it, the first ping waits for it.
+	if (bench_ping(pd->client, pd) == FALSE) {
+		fprintf(stderr, "glibhelper_client_socket_write error : %s\n", strerror(errno));
+		goto out;
+	}
+
+	while (pd->done == FALSE)
+		(void)g_main_context_iteration(NULL, TRUE);
+	if (pd->error == TRUE)
+		goto out;
+
+	bench_report((cross == TRUE) ? "cross" : "single", pd);
+	ret = 0;
+
+out:
+	if (pd->client != NULL)
+		glibhelper_terminate_client_socket(pd->client);
+	// Stop the server loop before terminating the server in the loop context.
+	if (loopthread != NULL)
+		(void)glibhelper_loop_thread_stop(loopthread);
+	if (svhandle != NULL)
+		glibhelper_terminate_server_socket(svhandle);
+	if (loopthread != NULL)
+		glibhelper_terminate_loop_thread(loopthread);
+	if (pd->rtt != NULL)
+		(void)glibhelper_terminate_histogram(pd->rtt);
+	g_free(pd);
+
+	return ret;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	size_t sizes[] = {16, 64, 256, 1024, 4096};
+	int round_trips = BENCH_ROUND_TRIPS;
+
+	if (argc > 1)
+		round_trips = atoi(argv[1]);
+	if (round_trips <= 0) {
+		fprintf(stderr, "usage : %s [round trips per case]\n", argv[0]);
+		return -1;
+	}
+
+	for (size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		if (run_bench(FALSE, sizes[i], round_trips) < 0)
+			return -1;
+	}
+
+	for (size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		if (run_bench(TRUE, sizes[i], round_trips) < 0)
+			return -1;
+	}
+
+	return 0;
+}
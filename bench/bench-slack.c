@@ -0,0 +1,113 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-slack.c
+ * @brief	wakeup count benchmark for low priority periodic timers with and without slack
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+#include "glibhelper-timerfd-support.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_DURATION (3000)	// ms
+#define BENCH_SLEPT (200)	// us
+
+static const uint64_t bench_interval[] = {	// ms
+	100, 130, 170, 200, 250, 330, 500, 1000,
+};
+static const uint64_t bench_slack[] = {	// ms
+	0, 20, 50, 100,
+};
+#define BENCH_TIMER ((int)(sizeof(bench_interval) / sizeof(bench_interval[0])))
+
+static GPollFunc default_poll = NULL;
+static uint64_t num_of_wakeup = 0;
+static uint64_t num_of_timeout = 0;
+//-----------------------------------------------------------------------------
+static gint counting_poll(GPollFD *ufds, guint nfds, gint timeout)
+{
+	gint64 start = g_get_monotonic_time();
+	gint ret = default_poll(ufds, nfds, timeout);
+
+	// Count only polls that slept and were woken up by fd. Ready fds found without sleep are not a wakeup.
+	if (ret > 0 && (g_get_monotonic_time() - start) >= BENCH_SLEPT)
+		num_of_wakeup++;
+
+	return ret;
+}
+//-----------------------------------------------------------------------------
+static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
+{
+	num_of_timeout++;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean quit_cb(gpointer data)
+{
+	g_main_loop_quit((GMainLoop*)data);
+
+	return G_SOURCE_REMOVE;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(uint64_t slack)
+{
+	GMainLoop *loop = NULL;
+	glibhelper_timerfd_support_handle timerfd[BENCH_TIMER];
+	glibhelper_timerfd_config tcfg;
+	struct rusage start, end;
+
+	num_of_wakeup = 0;
+	num_of_timeout = 0;
+	loop = g_main_loop_new(NULL, FALSE);
+
+	for (int i = 0; i < BENCH_TIMER; i++) {
+		memset(&tcfg, 0, sizeof(tcfg));
+		tcfg.operation.timeout = timeout_cb;
+		tcfg.interval = bench_interval[i] * 1000 * 1000;
+		tcfg.initial_delay = tcfg.interval;
+		tcfg.slack = slack;
+		if (glibhelper_create_timerfd(&timerfd[i], NULL, &tcfg, NULL) != TRUE)
+			return -1;
+	}
+
+	(void)g_timeout_add(BENCH_DURATION, quit_cb, loop);
+
+	(void)getrusage(RUSAGE_SELF, &start);
+	num_of_wakeup = 0;
+	g_main_loop_run(loop);
+	(void)getrusage(RUSAGE_SELF, &end);
+
+	fprintf(stdout, "slack_ms=%-3lu timers=%d timeouts=%lu wakeups_per_sec=%.1f ctxsw_per_sec=%.1f\n",
+			slack / (1000 * 1000), BENCH_TIMER, num_of_timeout,
+			(double)num_of_wakeup * 1000.0 / (double)BENCH_DURATION,
+			(double)(end.ru_nvcsw - start.ru_nvcsw) * 1000.0 / (double)BENCH_DURATION);
+
+	for (int i = 0; i < BENCH_TIMER; i++)
+		glibhelper_terminate_timerfd(timerfd[i]);
+
+	g_main_loop_unref(loop);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	default_poll = g_main_context_get_poll_func(NULL);
+	g_main_context_set_poll_func(NULL, counting_poll);
+
+	for (int i = 0; i < (int)(sizeof(bench_slack) / sizeof(bench_slack[0])); i++) {
+		if (run_bench(bench_slack[i] * 1000 * 1000) < 0)
+			return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	bench-timer.c
+ * @brief	many periodic timers benchmark for timerfd per timer and timer service
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+
+#include "glibhelper-timerfd-support.h"
+#include "glibhelper-timer-service.h"
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define BENCH_TIMER (500)
+#define BENCH_INTERVAL (10 * 1000 * 1000)	// ns
+#define BENCH_DURATION (2000)	// ms
+
+static uint64_t num_of_timeout = 0;
+//-----------------------------------------------------------------------------
+static gboolean timerfd_timeout_cb(glibhelper_timerfd_support_handle handle)
+{
+	num_of_timeout++;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean service_timeout_cb(glibhelper_timer timer)
+{
+	num_of_timeout++;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static gboolean quit_cb(gpointer data)
+{
+	g_main_loop_quit((GMainLoop*)data);
+
+	return G_SOURCE_REMOVE;
+}
+//-----------------------------------------------------------------------------
+static double get_cpu_time(void)
+{
+	struct rusage usage;
+
+	(void)getrusage(RUSAGE_SELF, &usage);
+
+	return (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1000000.0
+		+ (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1000000.0;
+}
+//-----------------------------------------------------------------------------
+static int count_fd(void)
+{
+	int num = 0;
+
+	for (int fd = 0; fd < 4096; fd++) {
+		if (fcntl(fd, F_GETFD) != -1)
+			num++;
+	}
+
+	return num;
+}
+//-----------------------------------------------------------------------------
+static int run_bench(gboolean is_service)
+{
+	GMainLoop *loop = NULL;
+	glibhelper_timerfd_support_handle timerfd[BENCH_TIMER];
+	glibhelper_timerfd_config tcfg;
+	glibhelper_timer_service service = NULL;
+	double cpu_start = 0.0, cpu_end = 0.0;
+	int fd_start = 0, fd_end = 0;
+
+	num_of_timeout = 0;
+	loop = g_main_loop_new(NULL, FALSE);
+	fd_start = count_fd();
+
+	if (is_service == TRUE) {
+		if (glibhelper_create_timer_service(&service, NULL, NULL) != TRUE)
+			return -1;
+		for (int i = 0; i < BENCH_TIMER; i++)
+			(void)glibhelper_timer_service_add(service, BENCH_INTERVAL, BENCH_INTERVAL, service_timeout_cb, NULL);
+	} else {
+		memset(&tcfg, 0, sizeof(tcfg));
+		tcfg.operation.timeout = timerfd_timeout_cb;
+		tcfg.interval = BENCH_INTERVAL;
+		for (int i = 0; i < BENCH_TIMER; i++) {
+			if (glibhelper_create_timerfd(&timerfd[i], NULL, &tcfg, NULL) != TRUE)
+				return -1;
+		}
+	}
+
+	fd_end = count_fd();
+
+	(void)g_timeout_add(BENCH_DURATION, quit_cb, loop);
+
+	cpu_start = get_cpu_time();
+	g_main_loop_run(loop);
+	cpu_end = get_cpu_time();
+
+	fprintf(stdout, "%s timers=%d fds=%d timeouts=%lu cpu_us_per_timeout=%.3f\n",
+			(is_service == TRUE) ? "timer_service  " : "timerfd_support",
+			BENCH_TIMER, fd_end - fd_start, num_of_timeout,
+			(cpu_end - cpu_start) * 1000000.0 / (double)num_of_timeout);
+
+	if (is_service == TRUE)
+		glibhelper_terminate_timer_service(service);
+	else {
+		for (int i = 0; i < BENCH_TIMER; i++)
+			glibhelper_terminate_timerfd(timerfd[i]);
+	}
+
+	g_main_loop_unref(loop);
+
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int main (int argc, char **argv)
+{
+	if (run_bench(FALSE) < 0)
+		return -1;
+
+	if (run_bench(TRUE) < 0)
+		return -1;
+
+	return 0;
+}
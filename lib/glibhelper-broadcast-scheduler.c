@@ -0,0 +1,397 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-broadcast-scheduler.c
+ * @brief	rate limited broadcast to server sessions for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-broadcast-scheduler.h"
+#include "glibhelper-timerfd-support.h"
+#include "glibhelper-stats.h"
+
+#define BROADCAST_RATE_DEFAULT (100)
+#define BROADCAST_BURST_DEFAULT (10)
+#define BROADCAST_QUEUE_DEFAULT (64)
+
+// Packet shared by all session queues.
+struct s_broadcast_packet {
+	int ref;
+	uint64_t key;	// 0 = no conflation
+	size_t count;
+	uint8_t data[];
+};
+
+struct s_broadcast_session {
+	glibhelper_server_session_id id;
+	uint64_t credit;	// Token bucket (ns). One packet costs one period.
+	uint64_t last;	// Time of last refill (ns)
+	GQueue queue;	// struct s_broadcast_packet*
+};
+
+struct s_glibhelper_broadcast_scheduler {
+	glibhelper_unix_socket_server_support server;
+	glibhelper_timerfd_support_handle timer;	// Pacing timer, one-shot
+	GHashTable *table;	// Session ID -> struct s_broadcast_session*
+	GList *sessions;	// struct s_broadcast_session*
+	struct s_broadcast_packet *publishing;	// Packet in glibhelper_broadcast_scheduler_publish
+	uint64_t period;	// ns per packet
+	uint64_t capacity;	// Bucket size (ns)
+	int max_queue;
+	gboolean timer_armed;
+	uint64_t timer_deadline;
+	glibhelper_broadcast_scheduler_stats stats;
+	glibhelper_stats_entry stats_entry;
+};
+//-----------------------------------------------------------------------------
+static void broadcast_packet_unref(struct s_broadcast_packet *packet)
+{
+	packet->ref--;
+	if (packet->ref == 0)
+		g_free(packet);
+}
+/**
+ * Release session state and queued packets.
+ *
+ * @param [in]	scheduler	Broadcast scheduler
+ * @param [in]	state	Session state
+ */
+static void broadcast_session_free(struct s_glibhelper_broadcast_scheduler *scheduler, struct s_broadcast_session *state)
+{
+	struct s_broadcast_packet *packet = NULL;
+
+	while ((packet = (struct s_broadcast_packet*)g_queue_pop_head(&state->queue)) != NULL) {
+		scheduler->stats.dropped++;
+		broadcast_packet_unref(packet);
+	}
+
+	g_free(state);
+}
+//-----------------------------------------------------------------------------
+static void broadcast_enqueue_cb(glibhelper_server_session_handle session, void *userdata)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = (struct s_glibhelper_broadcast_scheduler*)userdata;
+	struct s_broadcast_packet *packet = scheduler->publishing;
+	struct s_broadcast_packet *old = NULL;
+	struct s_broadcast_session *state = NULL;
+	glibhelper_server_session_id id = 0;
+
+	id = glibhelper_server_get_session_id(session);
+	state = (struct s_broadcast_session*)g_hash_table_lookup(scheduler->table, &id);
+	if (state == NULL) {
+		state = (struct s_broadcast_session*)g_malloc(sizeof(struct s_broadcast_session));
+		if (state == NULL)
+			return;
+		memset(state,0,sizeof(struct s_broadcast_session));
+		g_queue_init(&state->queue);
+		state->id = id;
+		state->credit = scheduler->capacity;	// New session starts with full bucket
+		state->last = glibhelper_timerfd_get_time(scheduler->timer);
+
+		(void)g_hash_table_insert(scheduler->table, &state->id, state);
+		scheduler->sessions = g_list_prepend(scheduler->sessions, state);
+	}
+
+	// Conflation: replace queued packet of same key in place, the position in queue is kept.
+	if (packet->key != 0) {
+		for (GList *link = state->queue.head; link != NULL; link = link->next) {
+			old = (struct s_broadcast_packet*)link->data;
+			if (old->key == packet->key) {
+				packet->ref++;
+				link->data = packet;
+				broadcast_packet_unref(old);
+				scheduler->stats.conflated++;
+				return;
+			}
+		}
+	}
+
+	if ((int)g_queue_get_length(&state->queue) >= scheduler->max_queue) {
+		broadcast_packet_unref((struct s_broadcast_packet*)g_queue_pop_head(&state->queue));
+		scheduler->stats.dropped++;
+	}
+
+	packet->ref++;
+	g_queue_push_tail(&state->queue, packet);
+}
+/**
+ * Write queued packets to sessions under the token bucket budget and arm pacing timer for the rest.
+ *
+ * @param [in]	scheduler	Broadcast scheduler
+ */
+static void broadcast_flush(struct s_glibhelper_broadcast_scheduler *scheduler)
+{
+	struct s_broadcast_session *state = NULL;
+	struct s_broadcast_packet *packet = NULL;
+	glibhelper_server_session_handle session = NULL;
+	GList *listptr = NULL;
+	GList *next = NULL;
+	uint64_t now = 0;
+	uint64_t wait = UINT64_MAX;
+	uint64_t need = 0;
+	gboolean blocked = FALSE;
+	ssize_t ret = -1;
+
+	now = glibhelper_timerfd_get_time(scheduler->timer);
+
+	for (listptr = scheduler->sessions; listptr != NULL; listptr = next) {
+		next = listptr->next;
+		state = (struct s_broadcast_session*)listptr->data;
+
+		session = glibhelper_server_session_from_id(scheduler->server, state->id);
+		if (session == NULL) {
+			// Closed session
+			(void)g_hash_table_remove(scheduler->table, &state->id);
+			scheduler->sessions = g_list_delete_link(scheduler->sessions, listptr);
+			broadcast_session_free(scheduler, state);
+			continue;
+		}
+
+		state->credit += now - state->last;
+		if (state->credit > scheduler->capacity)
+			state->credit = scheduler->capacity;
+		state->last = now;
+
+		blocked = FALSE;
+		while (state->credit >= scheduler->period) {
+			packet = (struct s_broadcast_packet*)g_queue_peek_head(&state->queue);
+			if (packet == NULL)
+				break;
+
+			ret = glibhelper_server_socket_write(session, packet->data, packet->count);
+			if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				// Client socket buffer is full. Keep the packet and retry after one period.
+				blocked = TRUE;
+				break;
+			}
+
+			(void)g_queue_pop_head(&state->queue);
+			if (ret < 0)
+				scheduler->stats.dropped++;
+			else
+				scheduler->stats.sent++;
+			broadcast_packet_unref(packet);
+			state->credit -= scheduler->period;
+		}
+
+		if (g_queue_is_empty(&state->queue) == FALSE) {
+			if (blocked == TRUE || state->credit >= scheduler->period)
+				need = scheduler->period;
+			else
+				need = scheduler->period - state->credit;
+			if (need < wait)
+				wait = need;
+		}
+	}
+
+	if (wait == UINT64_MAX)
+		return;
+
+	// Keep earlier deadline to avoid re-arm per publish.
+	if (scheduler->timer_armed == TRUE && scheduler->timer_deadline <= now + wait)
+		return;
+
+	if (glibhelper_timerfd_rearm(scheduler->timer, wait, 0) == TRUE) {
+		scheduler->timer_armed = TRUE;
+		scheduler->timer_deadline = now + wait;
+	}
+}
+//-----------------------------------------------------------------------------
+static gboolean broadcast_timeout_cb(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = NULL;
+
+	scheduler = (struct s_glibhelper_broadcast_scheduler*)glibhelper_timerfd_get_userdata(handle);
+	scheduler->timer_armed = FALSE;
+
+	broadcast_flush(scheduler);
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void broadcast_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = (struct s_glibhelper_broadcast_scheduler*)userdata;
+
+	// Session list is owned by the server context, only counters are read here.
+	glibhelper_stats_print(fd, "  published=%lu sent=%lu conflated=%lu dropped=%lu\n",
+			(unsigned long)scheduler->stats.published, (unsigned long)scheduler->stats.sent,
+			(unsigned long)scheduler->stats.conflated, (unsigned long)scheduler->stats.dropped);
+}
+/**
+ * Publish packet to all connected sessions. Call this function in the server context.
+ * The packet is copied once and queued to each session, then written under the token bucket budget of the session.
+ * When key is not 0 and a packet of same key is still queued for a session, the queued packet is replaced (conflation),
+ * so the session receives only the latest value of the key.
+ *
+ * @param [in]	handle	Broadcast scheduler handle
+ * @param [in]	key	Conflation key. 0 = no conflation.
+ * @param [in]	buf	Pointer to packet data.
+ * @param [in]	count	Number of bytes of packet.
+ *
+ * @return int
+ * @retval >=0 Number of sessions the packet was queued to.
+ * @retval <0 Arg error or resource allocation error.
+ */
+int glibhelper_broadcast_scheduler_publish(glibhelper_broadcast_scheduler handle, uint64_t key, void *buf, size_t count)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = NULL;
+	struct s_broadcast_packet *packet = NULL;
+	int num = 0;
+
+	if (handle == NULL || buf == NULL)
+		return -1;
+
+	scheduler = (struct s_glibhelper_broadcast_scheduler*)handle;
+
+	packet = (struct s_broadcast_packet*)g_malloc(sizeof(struct s_broadcast_packet) + count);
+	if (packet == NULL)
+		return -1;
+	packet->ref = 1;	// Held by this function until queued to all sessions.
+	packet->key = key;
+	packet->count = count;
+	memcpy(packet->data, buf, count);
+
+	scheduler->publishing = packet;
+	num = glibhelper_server_socket_foreach_session(scheduler->server, broadcast_enqueue_cb, scheduler);
+	scheduler->publishing = NULL;
+	broadcast_packet_unref(packet);
+
+	scheduler->stats.published++;
+
+	broadcast_flush(scheduler);
+
+	return num;
+}
+/**
+ * Get statistics of broadcast scheduler. Call this function in the server context.
+ *
+ * @param [in]	handle	Broadcast scheduler handle
+ * @param [out]	stats	Pointer to store statistics.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_broadcast_scheduler_get_stats(glibhelper_broadcast_scheduler handle, glibhelper_broadcast_scheduler_stats *stats)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = NULL;
+
+	if (handle == NULL || stats == NULL)
+		return FALSE;
+
+	scheduler = (struct s_glibhelper_broadcast_scheduler*)handle;
+
+	(*stats) = scheduler->stats;
+	stats->pending = 0;
+	stats->sessions = 0;
+	for (GList *listptr = scheduler->sessions; listptr != NULL; listptr = g_list_next(listptr)) {
+		stats->pending += (int)g_queue_get_length(&((struct s_broadcast_session*)listptr->data)->queue);
+		stats->sessions++;
+	}
+
+	return TRUE;
+}
+/**
+ * Create broadcast scheduler for server socket. Attach it to the server context.
+ *
+ * @param [in]	handle	Pointer to store created broadcast scheduler handle.
+ * @param [in]	server	Server socket handle.
+ * @param [in]	context	Event loop context of server socket. NULL is default context.
+ * @param [in]	config	Broadcast scheduler configuration. NULL is default configuration.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_broadcast_scheduler(glibhelper_broadcast_scheduler *handle, glibhelper_unix_socket_server_support server,
+	GMainContext *context, glibhelper_broadcast_scheduler_config *config)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = NULL;
+	glibhelper_timerfd_config tcfg;
+	int rate = BROADCAST_RATE_DEFAULT;
+	int burst = BROADCAST_BURST_DEFAULT;
+
+	if (handle == NULL || server == NULL)
+		return FALSE;
+
+	scheduler = (struct s_glibhelper_broadcast_scheduler*)g_malloc(sizeof(struct s_glibhelper_broadcast_scheduler));
+	if (scheduler == NULL)
+		return FALSE;
+	memset(scheduler,0,sizeof(struct s_glibhelper_broadcast_scheduler));
+
+	scheduler->max_queue = BROADCAST_QUEUE_DEFAULT;
+	if (config != NULL) {
+		if (config->rate > 0)
+			rate = config->rate;
+		if (config->burst > 0)
+			burst = config->burst;
+		if (config->max_queue > 0)
+			scheduler->max_queue = config->max_queue;
+	}
+	scheduler->period = (uint64_t)1000 * 1000 * 1000 / (uint64_t)rate;
+	scheduler->capacity = scheduler->period * (uint64_t)burst;
+	scheduler->server = server;
+
+	scheduler->table = g_hash_table_new(g_int64_hash, g_int64_equal);
+	if (scheduler->table == NULL)
+		goto errorout;
+
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.operation.timeout = broadcast_timeout_cb;
+	if (glibhelper_create_timerfd(&scheduler->timer, context, &tcfg, scheduler) == FALSE)
+		goto errorout;
+	(void)glibhelper_timerfd_pause(scheduler->timer);	// Armed only while packets are waiting for tokens.
+
+	scheduler->stats_entry = glibhelper_stats_register("broadcast_scheduler", broadcast_stats_dump, scheduler);
+
+	(*handle) = (glibhelper_broadcast_scheduler)(scheduler);
+
+	return TRUE;
+
+errorout:
+	if (scheduler->table != NULL)
+		g_hash_table_destroy(scheduler->table);
+	g_free(scheduler);
+
+	return FALSE;
+}
+/**
+ * Terminate broadcast scheduler. The queued packets are discarded.
+ * Terminate it before the server socket.
+ *
+ * @param [in]	handle	Broadcast scheduler handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_broadcast_scheduler(glibhelper_broadcast_scheduler handle)
+{
+	struct s_glibhelper_broadcast_scheduler *scheduler = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	scheduler = (struct s_glibhelper_broadcast_scheduler*)handle;
+
+	glibhelper_stats_unregister(scheduler->stats_entry);
+	(void)glibhelper_terminate_timerfd(scheduler->timer);
+
+	for (GList *listptr = scheduler->sessions; listptr != NULL; listptr = g_list_next(listptr))
+		broadcast_session_free(scheduler, (struct s_broadcast_session*)listptr->data);
+	g_list_free(scheduler->sessions);
+	g_hash_table_destroy(scheduler->table);
+
+	g_free(scheduler);
+
+	return TRUE;
+}
@@ -0,0 +1,45 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-broadcast-scheduler.h
+ * @brief	header for glibhelper-broadcast-scheduler
+ */
+#ifndef GLIBHELPER_BROADCAST_SCHEDULER_H
+#define GLIBHELPER_BROADCAST_SCHEDULER_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+
+#include "glibhelper-unix-socket-support.h"
+
+struct s_glibhelper_broadcast_scheduler;
+typedef struct s_glibhelper_broadcast_scheduler *glibhelper_broadcast_scheduler;
+
+/** glibhelper_broadcast_scheduler_config.*/
+typedef struct s_glibhelper_broadcast_scheduler_config {
+	int rate; /**< Max output rate per session (packets/s). 0 = default (100). */
+	int burst; /**< Token bucket size, max packets sent at once to a session. 0 = default (10). */
+	int max_queue; /**< Max queued packets per session. The oldest one is dropped when full. 0 = default (64). */
+} glibhelper_broadcast_scheduler_config;
+
+/** glibhelper_broadcast_scheduler_stats.*/
+typedef struct s_glibhelper_broadcast_scheduler_stats {
+	guint64 published; /**< Number of published packets. */
+	guint64 sent; /**< Number of packets written to sessions. */
+	guint64 conflated; /**< Number of queued packets replaced by newer packet of same key. */
+	guint64 dropped; /**< Number of packets dropped by queue overflow, write error or closed session. */
+	int pending; /**< Number of packets queued now. */
+	int sessions; /**< Number of sessions tracked now. */
+} glibhelper_broadcast_scheduler_stats;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_broadcast_scheduler(glibhelper_broadcast_scheduler *handle, glibhelper_unix_socket_server_support server,
+	GMainContext *context, glibhelper_broadcast_scheduler_config *config);
+gboolean glibhelper_terminate_broadcast_scheduler(glibhelper_broadcast_scheduler handle);
+int glibhelper_broadcast_scheduler_publish(glibhelper_broadcast_scheduler handle, uint64_t key, void *buf, size_t count);
+gboolean glibhelper_broadcast_scheduler_get_stats(glibhelper_broadcast_scheduler handle, glibhelper_broadcast_scheduler_stats *stats);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_BROADCAST_SCHEDULER_H
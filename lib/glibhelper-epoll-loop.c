@@ -0,0 +1,293 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-epoll-loop.c
+ * @brief	GLib free epoll event loop for the epoll backend
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "glibhelper-epoll.h"
+
+#define EPOLL_LOOP_EVENTS (64)	// Max events per epoll_wait
+
+struct s_glibhelper_epoll_watch {
+	struct s_glibhelper_epoll_context *context;
+	int fd;
+	fp_epoll_watch_callback callback;
+	void *userdata;
+	gboolean removed;
+	struct s_glibhelper_epoll_watch *next;	// Removed watch list
+};
+
+struct s_glibhelper_epoll_context {
+	int epollfd;
+	int wakeupfd;	// eventfd to wake up epoll_wait from other threads
+	int quit;	// Quit request of glibhelper_epoll_run. Atomic.
+	int dispatching;	// Depth of running iterations, their events of epoll_wait refer the watches
+	struct s_glibhelper_epoll_watch *removed;	// Watches released after dispatch
+};
+
+static pthread_once_t epoll_default_once = PTHREAD_ONCE_INIT;
+static struct s_glibhelper_epoll_context *epoll_default_context = NULL;
+
+//-----------------------------------------------------------------------------
+static void epoll_default_init(void)
+{
+	epoll_default_context = glibhelper_epoll_context_new();
+}
+/**
+ * Get default epoll context. It is used when NULL context is passed to the helpers.
+ *
+ * @return GMainContext*
+ * @retval !NULL Default context.
+ * @retval NULL Resource allocation error.
+ */
+GMainContext* glibhelper_epoll_context_default(void)
+{
+	(void)pthread_once(&epoll_default_once, epoll_default_init);
+
+	return epoll_default_context;
+}
+/**
+ * Resolve NULL context to the default context.
+ *
+ * @param [in]	context	Context or NULL
+ *
+ * @return struct s_glibhelper_epoll_context*
+ */
+static struct s_glibhelper_epoll_context* epoll_context_resolve(GMainContext *context)
+{
+	if (context == NULL)
+		return glibhelper_epoll_context_default();
+
+	return context;
+}
+/**
+ * Release removed watches. The watches are kept until the end of outermost dispatch because
+ * the pending events of epoll_wait may refer them.
+ *
+ * @param [in]	context	Context
+ */
+static void epoll_context_release_removed(struct s_glibhelper_epoll_context *context)
+{
+	struct s_glibhelper_epoll_watch *watch = NULL;
+
+	while (context->removed != NULL) {
+		watch = context->removed;
+		context->removed = watch->next;
+		g_free(watch);
+	}
+}
+/**
+ * Create new epoll context.
+ *
+ * @return GMainContext*
+ * @retval !NULL Context.
+ * @retval NULL Resource allocation error.
+ */
+GMainContext* glibhelper_epoll_context_new(void)
+{
+	struct s_glibhelper_epoll_context *context = NULL;
+	struct epoll_event event;
+
+	context = (struct s_glibhelper_epoll_context*)g_malloc(sizeof(struct s_glibhelper_epoll_context));
+	if (context == NULL)
+		return NULL;
+	memset(context, 0, sizeof(struct s_glibhelper_epoll_context));
+	context->wakeupfd = -1;
+
+	context->epollfd = epoll_create1(EPOLL_CLOEXEC);
+	if (context->epollfd < 0)
+		goto errorout;
+
+	context->wakeupfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (context->wakeupfd < 0)
+		goto errorout;
+
+	// NULL data is the wakeup event.
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	if (epoll_ctl(context->epollfd, EPOLL_CTL_ADD, context->wakeupfd, &event) < 0)
+		goto errorout;
+
+	return context;
+
+errorout:
+	if (context->wakeupfd >= 0)
+		close(context->wakeupfd);
+
+	if (context->epollfd >= 0)
+		close(context->epollfd);
+
+	g_free(context);
+
+	return NULL;
+}
+/**
+ * Free epoll context. The helpers in the context shall be terminated before this function.
+ *
+ * @param [in]	context	Context
+ */
+void glibhelper_epoll_context_free(GMainContext *context)
+{
+	if (context == NULL || context == epoll_default_context)
+		return;
+
+	epoll_context_release_removed(context);
+	close(context->wakeupfd);
+	close(context->epollfd);
+	g_free(context);
+}
+/**
+ * Add fd watch to context. Call this function in the context thread or before the loop runs.
+ *
+ * @param [in]	context	Context. NULL = default context.
+ * @param [in]	fd	fd to watch. The fd is owned by the caller and shall be closed after removing the watch.
+ * @param [in]	events	epoll events (EPOLLIN etc.). EPOLLERR and EPOLLHUP are always reported.
+ * @param [in]	callback	Event callback.
+ * @param [in]	userdata	Argument of the callback.
+ *
+ * @return glibhelper_epoll_watch
+ * @retval !NULL Watch.
+ * @retval NULL Arg error or epoll error.
+ */
+glibhelper_epoll_watch glibhelper_epoll_watch_add(GMainContext *context, int fd, uint32_t events, fp_epoll_watch_callback callback, void *userdata)
+{
+	struct s_glibhelper_epoll_watch *watch = NULL;
+	struct epoll_event event;
+
+	context = epoll_context_resolve(context);
+	if (context == NULL || fd < 0 || callback == NULL)
+		return NULL;
+
+	watch = (struct s_glibhelper_epoll_watch*)g_malloc(sizeof(struct s_glibhelper_epoll_watch));
+	if (watch == NULL)
+		return NULL;
+	memset(watch, 0, sizeof(struct s_glibhelper_epoll_watch));
+	watch->context = context;
+	watch->fd = fd;
+	watch->callback = callback;
+	watch->userdata = userdata;
+
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.ptr = watch;
+	if (epoll_ctl(context->epollfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		g_free(watch);
+		return NULL;
+	}
+
+	return watch;
+}
+/**
+ * Remove fd watch from context. It can be called in any callback of the context, the pending event of the watch
+ * is not dispatched after this function.
+ *
+ * @param [in]	watch	Watch
+ */
+void glibhelper_epoll_watch_remove(glibhelper_epoll_watch watch)
+{
+	struct s_glibhelper_epoll_context *context = NULL;
+
+	if (watch == NULL || watch->removed == TRUE)
+		return;
+
+	context = watch->context;
+	(void)epoll_ctl(context->epollfd, EPOLL_CTL_DEL, watch->fd, NULL);
+	watch->removed = TRUE;
+
+	if (context->dispatching > 0) {
+		watch->next = context->removed;
+		context->removed = watch;
+	} else {
+		g_free(watch);
+	}
+}
+/**
+ * Run one iteration of context. Wait events and call the callbacks.
+ *
+ * @param [in]	context	Context. NULL = default context.
+ * @param [in]	may_block	TRUE = wait until any event, FALSE = dispatch ready events only.
+ *
+ * @return int
+ * @retval >=0 Number of dispatched watches.
+ * @retval <0 Arg error or epoll error.
+ */
+int glibhelper_epoll_iteration(GMainContext *context, gboolean may_block)
+{
+	struct epoll_event events[EPOLL_LOOP_EVENTS];
+	struct s_glibhelper_epoll_watch *watch = NULL;
+	uint64_t value = 0;
+	int num = 0;
+	int dispatched = 0;
+
+	context = epoll_context_resolve(context);
+	if (context == NULL)
+		return -1;
+
+	num = epoll_wait(context->epollfd, events, EPOLL_LOOP_EVENTS, (may_block == TRUE) ? -1 : 0);
+	if (num < 0)
+		return (errno == EINTR) ? 0 : -1;
+
+	context->dispatching++;	// Iteration can be nested in a callback
+	for (int i = 0; i < num; i++) {
+		watch = (struct s_glibhelper_epoll_watch*)events[i].data.ptr;
+		if (watch == NULL) {
+			(void)read(context->wakeupfd, &value, sizeof(value));
+			continue;
+		}
+		if (watch->removed == TRUE)
+			continue;	// Removed by previous callback
+
+		if (watch->callback(watch->fd, events[i].events, watch->userdata) == FALSE)
+			glibhelper_epoll_watch_remove(watch);
+		dispatched++;
+	}
+	context->dispatching--;
+	if (context->dispatching == 0)
+		epoll_context_release_removed(context);
+
+	return dispatched;
+}
+/**
+ * Run context until glibhelper_epoll_quit.
+ *
+ * @param [in]	context	Context. NULL = default context.
+ */
+void glibhelper_epoll_run(GMainContext *context)
+{
+	context = epoll_context_resolve(context);
+	if (context == NULL)
+		return;
+
+	while (__atomic_exchange_n(&context->quit, 0, __ATOMIC_ACQ_REL) == 0) {
+		if (glibhelper_epoll_iteration(context, TRUE) < 0)
+			break;
+	}
+}
+/**
+ * Stop glibhelper_epoll_run of context. This function is thread safe.
+ * A quit before glibhelper_epoll_run stops the next run at once.
+ *
+ * @param [in]	context	Context. NULL = default context.
+ */
+void glibhelper_epoll_quit(GMainContext *context)
+{
+	uint64_t value = 1;
+
+	context = epoll_context_resolve(context);
+	if (context == NULL)
+		return;
+
+	__atomic_store_n(&context->quit, 1, __ATOMIC_RELEASE);
+	(void)write(context->wakeupfd, &value, sizeof(value));
+}
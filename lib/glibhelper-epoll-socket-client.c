@@ -0,0 +1,291 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-epoll-socket-client.c
+ * @brief	unix domain socket seq packet client helper for epoll backend
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-epoll.h"
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-unix-socket-support.h"
+
+struct s_glibhelper_unix_socket_client_support {
+	int fd;
+	glibhelper_epoll_watch watch;
+	struct s_glibhelper_client_socket_operation operation;
+	GMainContext *context;
+	void *userdata;
+	int receive_budget;
+	enum glibhelper_receive_state rx_state;
+};
+
+/**
+ * Get session socket fd from client session handle.
+ *
+ * @param [in]	handle	Client session handle
+ *
+ * @return int
+ * @retval >=0 fd.
+ * @retval <0 error (Illegal handle)
+ */
+int glibhelper_client_get_fd(glibhelper_client_session_handle handle)
+{
+	if ( handle == NULL)
+		return -1;
+
+	return ((struct s_glibhelper_unix_socket_client_support*)handle)->fd;
+}
+/**
+ * Get userdata from client session handle.
+ * The userdata is set at glibhelper_connect_socket.
+ *
+ * @param [in]	handle	Client session handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_client_get_userdata(glibhelper_client_session_handle handle)
+{
+	if ( handle == NULL)
+		return NULL;
+
+	return ((struct s_glibhelper_unix_socket_client_support*)handle)->userdata;
+}
+/**
+ * Read packet from socket using glibhelper_client_session_handle.
+ *
+ * @param [in]	handle	Client session handle
+ * @param [in]	buf Pointer to read buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes read.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_client_socket_read(glibhelper_client_session_handle handle, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_client_support *helper = NULL;
+	ssize_t ret = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_client_support*)handle;
+
+	do {
+		ret = read(helper->fd, buf, count);
+	} while((ret == -1) && (errno == EINTR));
+
+	// Update drain mode state. A zero length read or EAGAIN means no more queued packet.
+	helper->rx_state = (ret > 0) ? GLIBHELPER_RX_READ : GLIBHELPER_RX_DRAINED;
+
+	return ret;
+}
+/**
+ * Write packet to socket using glibhelper_client_session_handle.
+ *
+ * @param [in]	handle	Client session handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_client_socket_write(glibhelper_client_session_handle handle, void *buf, size_t count)
+{
+	ssize_t ret = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	do {
+		ret = write(((struct s_glibhelper_unix_socket_client_support*)handle)->fd, buf, count);
+	} while((ret == -1) && (errno == EINTR));
+
+	return ret;
+}
+/**
+ * Write multiple packets to socket using glibhelper_client_session_handle.
+ * The packets are submitted by one sendmmsg call per 64 packets.
+ *
+ * @param [in]	handle	Client session handle
+ * @param [in]	packets	Array of packet descriptor.
+ * @param [in]	num	Number of packets.
+ *
+ * @return int
+ * @retval >=0 Number of packets sent. When it is less than num, errno shows the reason (EAGAIN etc.) and
+ *             the caller can resume from packets[return value].
+ * @retval <0 error, no packet was sent (refer to error no).
+ */
+int glibhelper_client_socket_write_batch(glibhelper_client_session_handle handle, glibhelper_socket_packet *packets, int num)
+{
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return glibhelper_socket_write_batch(((struct s_glibhelper_unix_socket_client_support*)handle)->fd, packets, num);
+}
+/**
+ * Client socket event.
+ *
+ * @param [in]	fd	Client socket
+ * @param [in]	events	epoll events.
+ * @param [in]	data	Client socket helper
+ *
+ * @return gboolean
+ * @retval TRUE Continue watch.
+ * @retval FALSE Receive callback requested to stop.
+ */
+static gboolean client_socket_event(int fd, uint32_t events, void *data)
+{
+	struct s_glibhelper_unix_socket_client_support *helper = (struct s_glibhelper_unix_socket_client_support*)data;
+
+	(void)fd;	// helper->fd
+
+	if ((events & EPOLLIN) != 0 && helper->operation.receive != NULL) {
+		// Queued packets are received before close. The close is reported again by level trigger.
+		// In drain mode, call receive callback until the socket queue is empty or budget is exhausted.
+		for (int i=0; i < helper->receive_budget || i == 0; i++) {
+			helper->rx_state = GLIBHELPER_RX_NOT_READ;
+			if (helper->operation.receive((glibhelper_client_session_handle)helper) == FALSE)
+				return FALSE;
+			if (helper->rx_state != GLIBHELPER_RX_READ)
+				break;
+		}
+		if ((events & (EPOLLERR | EPOLLHUP)) == 0 || helper->rx_state == GLIBHELPER_RX_READ)
+			return TRUE;
+	}
+
+	if ((events & (EPOLLERR | EPOLLHUP)) != 0) {	 //Server side socket was closed.
+		// Cleanup session
+		if (helper->operation.destroyed_session != NULL)
+			helper->operation.destroyed_session((glibhelper_client_session_handle)helper);
+
+		glibhelper_epoll_watch_remove(helper->watch);
+		close(helper->fd);
+		g_free(helper);
+	}
+
+	return TRUE;
+}
+/**
+ * Connect to server socket in epoll context.
+ * io_uring backend is not supported in the epoll backend.
+ *
+ * @param [out]	handle	Pointer to store client socket handle.
+ * @param [in]	context	epoll context. NULL = default context.
+ * @param [in]	config	Client socket configuration.
+ * @param [in]	userdata	userdata for glibhelper_client_get_userdata.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, not supported config or socket error.
+ */
+gboolean glibhelper_connect_socket(glibhelper_unix_socket_client_support *handle, GMainContext *context, glibhelper_client_socket_config *config, void* userdata)
+{
+	int clifd = -1;
+	int ret = -1;
+	int len = 0, connectlen = 0;
+	struct sockaddr_un socketinfo;
+	struct s_glibhelper_unix_socket_client_support *helper;
+
+	if (handle == NULL || config == NULL)
+		return FALSE;
+
+	if (config->uring != NULL) {
+		errno = ENOTSUP;
+		return FALSE;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_client_support*)g_malloc(sizeof(struct s_glibhelper_unix_socket_client_support));
+	if (helper == NULL)
+		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_unix_socket_client_support));
+
+	clifd = socket(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK, AF_UNIX);
+	if (clifd < 0) {
+		goto errorout;
+	}
+
+	memset(&socketinfo, 0, sizeof(socketinfo));
+	socketinfo.sun_family = AF_UNIX;
+
+	len = glibhelper_get_socket_name_type(config->socket_name);
+	if (len < 0)
+		goto errorout;
+	else if (len == 0) { //socket file
+		strncpy(socketinfo.sun_path, config->socket_name, sizeof(socketinfo.sun_path) - 1);
+		connectlen = sizeof(socketinfo);
+	} else {
+		memcpy(socketinfo.sun_path, config->socket_name, len);
+		connectlen = len + sizeof(sa_family_t);
+	}
+
+	ret = connect(clifd, (const struct sockaddr *)&socketinfo, connectlen);
+	if (ret < 0) {
+		goto errorout;
+	}
+
+	helper->operation = config->operation;
+	helper->fd = clifd;
+	helper->context = context;
+	helper->userdata = userdata;
+	helper->receive_budget = config->receive_budget;
+
+	helper->watch = glibhelper_epoll_watch_add(context, clifd, EPOLLIN, client_socket_event, helper);
+	if (helper->watch == NULL)
+		goto errorout;
+
+	(*handle) = (glibhelper_unix_socket_client_support)(helper);
+
+	return TRUE;
+
+errorout:
+
+	if (clifd >= 0)
+		close(clifd);
+
+	g_free(helper);
+
+	return FALSE;
+}
+/**
+ * Terminate client socket.
+ *
+ * @param [in]	handle	Client socket handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_client_socket(glibhelper_unix_socket_client_support handle)
+{
+	struct s_glibhelper_unix_socket_client_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_unix_socket_client_support *)handle;
+
+	glibhelper_epoll_watch_remove(helper->watch);
+	close(helper->fd);
+	g_free(helper);
+
+	return TRUE;
+}
@@ -0,0 +1,654 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-epoll-socket-server.c
+ * @brief	unix domain socket seq packet server helper for epoll backend
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "glibhelper-epoll.h"
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-unix-socket-support.h"
+
+#define SERVER_SESSION_TABLE_INITIAL (16)
+
+struct s_epoll_server_session {
+	struct s_glibhelper_unix_socket_server_support *parent;
+	int fd;
+	glibhelper_epoll_watch watch;
+	enum glibhelper_receive_state rx_state;
+	glibhelper_server_session_id id;
+	struct s_epoll_server_session *prev;	// Session list
+	struct s_epoll_server_session *next;
+};
+
+struct s_server_session_slot {
+	struct s_epoll_server_session *session;	// NULL = free slot
+	guint32 generation;
+};
+
+struct s_glibhelper_unix_socket_server_support {
+	int fd;
+	glibhelper_epoll_watch watch;
+	struct s_glibhelper_server_socket_operation operation;
+	GMainContext *context;
+	void *userdata;
+	struct s_epoll_server_session *sessions;	// Session list head
+	int socketbuf_size;
+	int receive_budget;
+	pthread_mutex_t session_lock;	// Protect session_table. Sessions are referred from other threads by session ID.
+	struct s_server_session_slot *session_table;
+	guint num_of_slot;
+};
+/**
+ * Get session socket fd from server session handle.
+ *
+ * @param [in]	handle	Server session handle
+ *
+ * @return int
+ * @retval >=0 fd.
+ * @retval <0 error (Illegal handle)
+ */
+int glibhelper_server_get_fd(glibhelper_server_session_handle handle)
+{
+	if ( handle == NULL)
+		return -1;
+
+	return ((struct s_epoll_server_session*)handle)->fd;
+}
+/**
+ * Get userdata from server session handle.
+ * The userdata is set at glibhelper_create_server_socket.
+ *
+ * @param [in]	handle	Server session handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_server_get_userdata(glibhelper_server_session_handle handle)
+{
+	if ( handle == NULL)
+		return NULL;
+
+	return ((struct s_epoll_server_session*)handle)->parent->userdata;
+}
+/**
+ * Read packet from socket using glibhelper_server_session_handle.
+ *
+ * @param [in]	handle	Server session handle
+ * @param [in]	buf Pointer to read buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes read.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_server_socket_read(glibhelper_server_session_handle handle, void *buf, size_t count)
+{
+	struct s_epoll_server_session *session = NULL;
+	ssize_t ret = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	session = (struct s_epoll_server_session*)handle;
+
+	do {
+		ret = read(session->fd, buf, count);
+	} while((ret == -1) && (errno == EINTR));
+
+	// Update drain mode state. A zero length read or EAGAIN means no more queued packet.
+	session->rx_state = (ret > 0) ? GLIBHELPER_RX_READ : GLIBHELPER_RX_DRAINED;
+
+	return ret;
+}
+/**
+ * Write packet to socket using glibhelper_server_session_handle.
+ *
+ * @param [in]	handle	Server session handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_server_socket_write(glibhelper_server_session_handle handle, void *buf, size_t count)
+{
+	ssize_t ret = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	do {
+		ret = write(((struct s_epoll_server_session*)handle)->fd, buf, count);
+	} while((ret == -1) && (errno == EINTR));
+
+	return ret;
+}
+/**
+ * Get server handle(glibhelper_unix_socket_server_support) from Server session handle.
+ *
+ * @param [in]	handle	Server session handle
+ *
+ * @return glibhelper_unix_socket_server_support
+ * @retval !NULL server handle.
+ * @retval NULL Illegal handle error.
+ */
+glibhelper_unix_socket_server_support glibhelper_server_socket_server_support_from_session_handle(glibhelper_server_session_handle handle)
+{
+	if ( handle == NULL)
+		return NULL;
+
+	return ((struct s_epoll_server_session*)handle)->parent;
+}
+/**
+ * Register session to session table and assign session ID.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	New session
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Resource allocation error.
+ */
+static gboolean server_session_register(struct s_glibhelper_unix_socket_server_support *helper, struct s_epoll_server_session *session)
+{
+	struct s_server_session_slot *table = NULL;
+	guint slot = 0;
+	guint num = 0;
+
+	pthread_mutex_lock(&helper->session_lock);
+
+	for (slot=0; slot < helper->num_of_slot; slot++) {
+		if (helper->session_table[slot].session == NULL)
+			break;
+	}
+
+	if (slot == helper->num_of_slot) {
+		num = (helper->num_of_slot == 0) ? SERVER_SESSION_TABLE_INITIAL : helper->num_of_slot * 2;
+		table = (struct s_server_session_slot*)realloc(helper->session_table, sizeof(struct s_server_session_slot) * num);
+		if (table == NULL) {
+			pthread_mutex_unlock(&helper->session_lock);
+			return FALSE;
+		}
+		memset(&table[helper->num_of_slot], 0, sizeof(struct s_server_session_slot) * (num - helper->num_of_slot));
+		helper->session_table = table;
+		helper->num_of_slot = num;
+	}
+
+	// Generation 0 is not used, ID 0 is invalid.
+	helper->session_table[slot].generation++;
+	if (helper->session_table[slot].generation == 0)
+		helper->session_table[slot].generation = 1;
+
+	helper->session_table[slot].session = session;
+	session->id = ((glibhelper_server_session_id)slot << 32) | helper->session_table[slot].generation;
+
+	pthread_mutex_unlock(&helper->session_lock);
+
+	return TRUE;
+}
+/**
+ * Lookup session by session ID. Call with session_lock.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	id	Session ID
+ *
+ * @return struct s_epoll_server_session*
+ * @retval !NULL Session.
+ * @retval NULL The session was closed.
+ */
+static struct s_epoll_server_session* server_session_lookup_locked(struct s_glibhelper_unix_socket_server_support *helper, glibhelper_server_session_id id)
+{
+	guint slot = (guint)(id >> 32);
+
+	if (slot < helper->num_of_slot && helper->session_table[slot].session != NULL
+		&& helper->session_table[slot].generation == (guint32)(id & 0xffffffffu))
+		return helper->session_table[slot].session;
+
+	return NULL;
+}
+/**
+ * Lookup session by session ID.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	id	Session ID
+ *
+ * @return struct s_epoll_server_session*
+ * @retval !NULL Session. It is valid only in the server context.
+ * @retval NULL The session was closed.
+ */
+static struct s_epoll_server_session* server_session_lookup(struct s_glibhelper_unix_socket_server_support *helper, glibhelper_server_session_id id)
+{
+	struct s_epoll_server_session *session = NULL;
+
+	pthread_mutex_lock(&helper->session_lock);
+	session = server_session_lookup_locked(helper, id);
+	pthread_mutex_unlock(&helper->session_lock);
+
+	return session;
+}
+/**
+ * Unlink session from session list and session table, then release it.
+ * After this function, the session ID becomes stale.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	Session
+ */
+static void server_session_release(struct s_glibhelper_unix_socket_server_support *helper, struct s_epoll_server_session *session)
+{
+	guint slot = (guint)(session->id >> 32);
+
+	if (session->prev != NULL)
+		session->prev->next = session->next;
+	else if (helper->sessions == session)
+		helper->sessions = session->next;
+	if (session->next != NULL)
+		session->next->prev = session->prev;
+
+	// The fd is closed under the lock, write_by_id of other threads does not write to a reused fd.
+	pthread_mutex_lock(&helper->session_lock);
+	if (session->id != 0 && slot < helper->num_of_slot && helper->session_table[slot].session == session)
+		helper->session_table[slot].session = NULL;
+	glibhelper_epoll_watch_remove(session->watch);
+	close(session->fd);
+	pthread_mutex_unlock(&helper->session_lock);
+
+	g_free(session);
+}
+/**
+ * Get session ID from server session handle.
+ * The session ID can be passed to other threads. It never matches a later session that reuses the same slot.
+ *
+ * @param [in]	handle	Server session handle
+ *
+ * @return glibhelper_server_session_id
+ * @retval !0 Session ID.
+ * @retval 0 Illegal handle error.
+ */
+glibhelper_server_session_id glibhelper_server_get_session_id(glibhelper_server_session_handle handle)
+{
+	if ( handle == NULL)
+		return 0;
+
+	return ((struct s_epoll_server_session*)handle)->id;
+}
+/**
+ * Check the session of session ID is alive. This function is thread safe.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	id	Session ID
+ *
+ * @return gboolean
+ * @retval TRUE The session is alive.
+ * @retval FALSE The session was closed or arg error.
+ */
+gboolean glibhelper_server_session_is_alive(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id)
+{
+	if ( handle == NULL || id == 0)
+		return FALSE;
+
+	if (server_session_lookup((struct s_glibhelper_unix_socket_server_support*)handle, id) == NULL)
+		return FALSE;
+
+	return TRUE;
+}
+/**
+ * Write packet to session by session ID. This function is thread safe.
+ * In the epoll backend, the packet is written by the calling thread under the session lock
+ * (the GLib backend copies it to the server context).
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	id	Session ID
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written.
+ * @retval <0 error (refer to error no). ENOTCONN means the session was closed.
+ */
+ssize_t glibhelper_server_socket_write_by_id(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = NULL;
+	struct s_epoll_server_session *session = NULL;
+	ssize_t ret = -1;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
+
+	pthread_mutex_lock(&helper->session_lock);
+	session = server_session_lookup_locked(helper, id);
+	if (session != NULL) {
+		ret = glibhelper_server_socket_write((glibhelper_server_session_handle)session, buf, count);
+	} else {
+		errno = ENOTCONN;
+	}
+	pthread_mutex_unlock(&helper->session_lock);
+
+	return ret;
+}
+/**
+ * Get server session handle from session ID. Call this function in the server context,
+ * the handle is valid until the session is destroyed.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	id	Session ID
+ *
+ * @return glibhelper_server_session_handle
+ * @retval !NULL Server session handle.
+ * @retval NULL The session was closed or arg error.
+ */
+glibhelper_server_session_handle glibhelper_server_session_from_id(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id)
+{
+	if ( handle == NULL || id == 0)
+		return NULL;
+
+	return (glibhelper_server_session_handle)server_session_lookup((struct s_glibhelper_unix_socket_server_support*)handle, id);
+}
+/**
+ * Call function for each connected session. Call this function in the server context.
+ * The sessions must not be destroyed in the function.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	func	Function to call with session handle.
+ * @param [in]	userdata	Argument of the function.
+ *
+ * @return int
+ * @retval >=0 Number of sessions.
+ * @retval <0 Arg error.
+ */
+int glibhelper_server_socket_foreach_session(glibhelper_unix_socket_server_support handle, fp_foreach_session_callback_sv func, void *userdata)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = NULL;
+	int num = 0;
+
+	if ( handle == NULL || func == NULL)
+		return -1;
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
+
+	for (struct s_epoll_server_session *session = helper->sessions; session != NULL; session = session->next) {
+		func((glibhelper_server_session_handle)session, userdata);
+		num++;
+	}
+
+	return num;
+}
+/**
+ * Write packet to all sessions.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return int
+ * @retval >=0 Number of sessions the packet was sent to.
+ * @retval <0 Arg error.
+ */
+int glibhelper_server_socket_broadcast(glibhelper_unix_socket_server_support handle, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = NULL;
+	int num_of_send = 0;
+
+	if ( handle == NULL || buf == NULL)
+		return -1;
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
+
+	for (struct s_epoll_server_session *session = helper->sessions; session != NULL; session = session->next) {
+		if (!(glibhelper_server_socket_write((glibhelper_server_session_handle)session, buf, count) < 0))
+			num_of_send++;
+	}
+
+	return num_of_send;
+}
+/**
+ * Session socket event.
+ *
+ * @param [in]	fd	Session socket
+ * @param [in]	events	epoll events.
+ * @param [in]	data	Session
+ *
+ * @return gboolean
+ * @retval TRUE Continue watch.
+ * @retval FALSE Receive callback requested to stop.
+ */
+static gboolean server_session_event(int fd, uint32_t events, void *data)
+{
+	struct s_epoll_server_session *session = (struct s_epoll_server_session*)data;
+	struct s_glibhelper_unix_socket_server_support *helper = session->parent;
+
+	(void)fd;	// session->fd
+
+	if ((events & EPOLLIN) != 0 && helper->operation.receive != NULL) {
+		// Queued packets are received before close. The close is reported again by level trigger.
+		// In drain mode, call receive callback until the socket queue is empty or budget is exhausted.
+		for (int i=0; i < helper->receive_budget || i == 0; i++) {
+			session->rx_state = GLIBHELPER_RX_NOT_READ;
+			if (helper->operation.receive((glibhelper_server_session_handle)session) == FALSE)
+				return FALSE;
+			if (session->rx_state != GLIBHELPER_RX_READ)
+				break;
+		}
+		if ((events & (EPOLLERR | EPOLLHUP)) == 0 || session->rx_state == GLIBHELPER_RX_READ)
+			return TRUE;
+	}
+
+	if ((events & (EPOLLERR | EPOLLHUP)) != 0) {	 //Client side socket was closed.
+		if (helper->operation.destroyed_session != NULL)
+			helper->operation.destroyed_session((glibhelper_server_session_handle)session);
+
+		server_session_release(helper, session);
+	}
+
+	return TRUE;
+}
+/**
+ * Listening socket event. Accept new session.
+ *
+ * @param [in]	fd	Listening socket
+ * @param [in]	events	epoll events.
+ * @param [in]	data	Server socket
+ *
+ * @return gboolean
+ * @retval TRUE Continue watch.
+ * @retval FALSE Critical error. Watch stop.
+ */
+static gboolean server_socket_event(int fd, uint32_t events, void *data)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = (struct s_glibhelper_unix_socket_server_support*)data;
+	struct s_epoll_server_session *new_session = NULL;
+	int clifd = -1;
+
+	if ((events & (EPOLLERR | EPOLLHUP)) != 0)
+		return FALSE;	// The lisning socket will not active this event. Fail safe.
+
+	// When this pass get some error, shall cloase new session and wait new connect.
+	clifd = accept4(fd, NULL, NULL, SOCK_NONBLOCK|SOCK_CLOEXEC);
+	if (clifd < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK
+			|| errno == ECONNABORTED || errno == EINTR)// Non abnormal error.
+			return TRUE;
+		else
+			return FALSE;
+	}
+
+	if (helper->socketbuf_size > 0)
+		(void)setsockopt(clifd, SOL_SOCKET, SO_SNDBUF, &helper->socketbuf_size, sizeof(helper->socketbuf_size));
+
+	new_session = (struct s_epoll_server_session*)g_malloc(sizeof(struct s_epoll_server_session));
+	if (new_session == NULL) {
+		close(clifd);
+		return TRUE;
+	}
+	memset(new_session, 0, sizeof(struct s_epoll_server_session));
+	new_session->parent = helper;
+	new_session->fd = clifd;
+
+	new_session->watch = glibhelper_epoll_watch_add(helper->context, clifd, EPOLLIN, server_session_event, new_session);
+	if (new_session->watch == NULL) {
+		close(clifd);
+		g_free(new_session);
+		return TRUE;
+	}
+
+	if (server_session_register(helper, new_session) == FALSE) {
+		server_session_release(helper, new_session);
+		return TRUE;
+	}
+
+	new_session->next = helper->sessions;
+	if (helper->sessions != NULL)
+		helper->sessions->prev = new_session;
+	helper->sessions = new_session;
+
+	if (helper->operation.get_new_session != NULL)
+		helper->operation.get_new_session((glibhelper_server_session_handle)new_session);
+
+	return TRUE;
+}
+/**
+ * Create server socket in epoll context.
+ * Offload mode and io_uring backend are not supported in the epoll backend.
+ *
+ * @param [out]	handle	Pointer to store server socket handle.
+ * @param [in]	context	epoll context. NULL = default context.
+ * @param [in]	config	Server socket configuration.
+ * @param [in]	userdata	userdata for glibhelper_server_get_userdata.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, not supported config or socket error.
+ */
+gboolean glibhelper_create_server_socket(glibhelper_unix_socket_server_support *handle, GMainContext *context, glibhelper_server_socket_config *config, void* userdata)
+{
+	int serverfd = -1;
+	int ret = -1;
+	int len = 0, bindlen = 0;
+	struct sockaddr_un socketinfo;
+	struct s_glibhelper_unix_socket_server_support *helper;
+
+	if (handle == NULL || config == NULL)
+		return FALSE;
+
+	if ((config->offload_threads > 0 && config->operation.offload != NULL) || config->uring != NULL) {
+		errno = ENOTSUP;
+		return FALSE;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)g_malloc(sizeof(struct s_glibhelper_unix_socket_server_support));
+	if (helper == NULL)
+		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_unix_socket_server_support));
+	pthread_mutex_init(&helper->session_lock, NULL);
+
+	serverfd = socket(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK, AF_UNIX);
+	if (serverfd < 0) {
+		goto errorout;
+	}
+
+	memset(&socketinfo, 0, sizeof(socketinfo));
+	socketinfo.sun_family = AF_UNIX;
+
+	len = glibhelper_get_socket_name_type(config->socket_name);
+	if (len < 0)
+		goto errorout;
+	else if (len == 0) { //socket file
+		strncpy(socketinfo.sun_path, config->socket_name, sizeof(socketinfo.sun_path) - 1);
+		unlink(socketinfo.sun_path);
+		bindlen = sizeof(socketinfo);
+	} else {
+		memcpy(socketinfo.sun_path, config->socket_name, len);
+		bindlen = len + sizeof(sa_family_t);
+	}
+
+	ret = bind(serverfd, (const struct sockaddr *) &socketinfo, bindlen);
+	if (ret < 0) {
+		goto errorout;
+	}
+
+	ret = listen(serverfd, 10);
+	if (ret < 0) {
+		goto errorout;
+	}
+
+	helper->operation = config->operation;
+	helper->fd = serverfd;
+	helper->context = context;
+	helper->userdata = userdata;
+	helper->socketbuf_size = config->socketbuf_size;
+	helper->receive_budget = config->receive_budget;
+
+	helper->watch = glibhelper_epoll_watch_add(context, serverfd, EPOLLIN, server_socket_event, helper);
+	if (helper->watch == NULL)
+		goto errorout;
+
+	(*handle) = (glibhelper_unix_socket_server_support)(helper);
+
+	return TRUE;
+
+errorout:
+
+	if (serverfd >= 0)
+		close(serverfd);
+
+	pthread_mutex_destroy(&helper->session_lock);
+	g_free(helper);
+
+	return FALSE;
+}
+/**
+ * Terminate server socket. All sessions are destroyed with destroyed_session callback.
+ *
+ * @param [in]	handle	Server socket handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_server_socket(glibhelper_unix_socket_server_support handle)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
+
+	// Destroy all session
+	while (helper->sessions != NULL) {
+		if (helper->operation.destroyed_session != NULL)
+			helper->operation.destroyed_session((glibhelper_server_session_handle)helper->sessions);
+
+		server_session_release(helper, helper->sessions);
+	}
+
+	pthread_mutex_destroy(&helper->session_lock);
+	g_free(helper->session_table);
+
+	// Destroy server socket
+	glibhelper_epoll_watch_remove(helper->watch);
+	close(helper->fd);
+	g_free(helper);
+
+	return TRUE;
+}
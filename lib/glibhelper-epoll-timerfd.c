@@ -0,0 +1,623 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-epoll-timerfd.c
+ * @brief	timerfd helper for epoll backend
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+
+#include "glibhelper-epoll.h"
+#include "glibhelper-timerfd-support.h"
+
+struct s_glibhelper_timerfd_support {
+	int fd;
+	glibhelper_epoll_watch watch;
+	struct s_glibhelper_timerfd_operation operation;
+	GMainContext *context;
+	void *userdata;
+	struct itimerspec paused;	// Remaining time at pause
+	gboolean is_paused;
+	uint64_t interval;	// ns
+	uint64_t deadline;	// Scheduled time of next expiration (ns)
+	uint64_t expirations;	// Total expirations
+	uint64_t overrun;	// Total missed expirations
+	clockid_t clockid;
+	gboolean absolute;
+	uint64_t phase;	// ns
+	uint64_t slack_grid;	// Deadlines are rounded up to multiple of this (ns). 0 = no coalescing.
+	uint64_t nominal;	// Deadline before rounding to slack grid (ns)
+	gboolean rearm;	// Re-arm one-shot at each expiration, the interval is not multiple of slack grid.
+	glibhelper_histogram jitter;	// NULL = not recorded
+};
+//-----------------------------------------------------------------------------
+static uint64_t timerfd_clock(struct s_glibhelper_timerfd_support *helper)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(helper->clockid, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+/**
+ * Round up time to slack grid.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	time	Time(ns).
+ *
+ * @return uint64_t
+ * @retval >0 Rounded time.
+ */
+static uint64_t timerfd_coalesce(struct s_glibhelper_timerfd_support *helper, uint64_t time)
+{
+	if (helper->slack_grid == 0)
+		return time;
+
+	return (time + helper->slack_grid - 1) & ~(helper->slack_grid - 1);
+}
+//-----------------------------------------------------------------------------
+/**
+ * Set timerfd with absolute deadline and interval.
+ * With slack, the deadline is rounded up to the slack grid, so timers of any owner expire at the same time
+ * within the slack and wake up the CPU once.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	timerfd	timerfd
+ * @param [in]	deadline	Time of first expiration on the clock of timer(ns).
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return int
+ * @retval 0 Success.
+ * @retval <0 error (refer to error no).
+ */
+static int timerfd_arm_at(struct s_glibhelper_timerfd_support *helper, int timerfd, uint64_t deadline, uint64_t interval)
+{
+	struct itimerspec timersetting;
+	uint64_t nominal = deadline;
+	uint64_t kernel_interval = interval;
+	gboolean rearm = FALSE;
+	int ret = -1;
+
+	memset(&timersetting, 0, sizeof(timersetting));
+
+	if (helper->slack_grid != 0) {
+		deadline = timerfd_coalesce(helper, deadline);
+		// Aligned deadline + multiple of grid stays aligned, the kernel can repeat it.
+		if ((interval % helper->slack_grid) != 0) {
+			kernel_interval = 0;
+			rearm = TRUE;
+		}
+	}
+
+	// it_value 0 disarms timerfd. Past deadline expires immediately.
+	if (deadline == 0)
+		deadline = 1;
+
+	timersetting.it_value.tv_sec = deadline / (1000 * 1000 * 1000);
+	timersetting.it_value.tv_nsec = deadline % (1000 * 1000 * 1000);
+
+	// The kernel adds interval to previous deadline, so the period does not drift.
+	timersetting.it_interval.tv_sec = kernel_interval / (1000 * 1000 *1000);
+	timersetting.it_interval.tv_nsec = kernel_interval % (1000 * 1000 * 1000);
+
+	ret = timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &timersetting, NULL);
+	if (ret == 0) {
+		helper->interval = interval;
+		helper->deadline = deadline;
+		helper->nominal = nominal;
+		helper->rearm = rearm;
+	}
+
+	return ret;
+}
+/**
+ * Get first deadline at or after start that is aligned to phase + N * interval.
+ *
+ * @param [in]	start	Earliest time(ns).
+ * @param [in]	interval	Interval(ns). 0 = no alignment.
+ * @param [in]	phase	Offset from multiples of interval(ns).
+ *
+ * @return uint64_t
+ * @retval >0 Aligned deadline.
+ */
+static uint64_t timerfd_align(uint64_t start, uint64_t interval, uint64_t phase)
+{
+	uint64_t base = 0;
+
+	if (interval == 0)
+		return start;
+
+	base = phase % interval;
+	if (start <= base)
+		return base;
+
+	return base + (((start - base) + interval - 1) / interval) * interval;
+}
+/**
+ * Set timerfd with delay and interval. In absolute mode, first expiration is aligned to the phase.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	timerfd	timerfd
+ * @param [in]	initial_delay	Delay until first expiration(ns). 0 = expire immediately.
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return int
+ * @retval 0 Success.
+ * @retval <0 error (refer to error no).
+ */
+static int timerfd_arm(struct s_glibhelper_timerfd_support *helper, int timerfd, uint64_t initial_delay, uint64_t interval)
+{
+	struct itimerspec timersetting;
+	int ret = -1;
+
+	if (helper->absolute == TRUE)
+		return timerfd_arm_at(helper, timerfd,
+				timerfd_align(timerfd_clock(helper) + initial_delay, interval, helper->phase), interval);
+
+	if (helper->slack_grid != 0)
+		return timerfd_arm_at(helper, timerfd, timerfd_clock(helper) + initial_delay, interval);
+
+	memset(&timersetting, 0, sizeof(timersetting));
+
+	// it_value 0 disarms timerfd. Zero delay is 1ns.
+	if (initial_delay == 0)
+		initial_delay = 1;
+
+	timersetting.it_value.tv_sec = initial_delay / (1000 * 1000 * 1000);
+	timersetting.it_value.tv_nsec = initial_delay % (1000 * 1000 * 1000);
+
+	// Set a interval time
+	timersetting.it_interval.tv_sec = interval / (1000 * 1000 *1000);
+	timersetting.it_interval.tv_nsec = interval % (1000 * 1000 * 1000);
+
+	ret = timerfd_settime(timerfd, 0, &timersetting, NULL);
+	if (ret == 0) {
+		helper->interval = interval;
+		helper->deadline = timerfd_clock(helper) + initial_delay;
+	}
+
+	return ret;
+}
+/**
+ * Get userdata from timer handle.
+ * The userdata is set at glibhelper_create_timerfd.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_timerfd_get_userdata(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if ( handle == NULL)
+		return NULL;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+
+	return helper->userdata;
+}
+/**
+ * Re-arm timer with new initial delay and interval. The timerfd and event source are reused.
+ * It can be called in the timeout callback and for paused timer (the timer is resumed).
+ *
+ * @param [in]	handle	Timer handle
+ * @param [in]	initial_delay	Delay until first expiration(ns). 0 = expire immediately.
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or timerfd error.
+ */
+gboolean glibhelper_timerfd_rearm(glibhelper_timerfd_support_handle handle, uint64_t initial_delay, uint64_t interval)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+
+	if (timerfd_arm(helper, helper->fd, initial_delay, interval) < 0)
+		return FALSE;
+
+	helper->is_paused = FALSE;
+
+	return TRUE;
+}
+/**
+ * Pause timer. Remaining time until next expiration is kept for resume.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, already paused or timerfd error.
+ */
+gboolean glibhelper_timerfd_pause(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+	struct itimerspec timersetting;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+	if (helper->is_paused == TRUE)
+		return FALSE;
+
+	memset(&timersetting, 0, sizeof(timersetting));
+
+	// Disarm and get remaining time at once.
+	if (timerfd_settime(helper->fd, 0, &timersetting, &helper->paused) < 0)
+		return FALSE;
+
+	helper->is_paused = TRUE;
+
+	return TRUE;
+}
+/**
+ * Resume paused timer. The timer expires after the remaining time at pause.
+ * In absolute mode, the expiration is aligned to the next deadline of the phase after the remaining time.
+ * With slack, the expiration is rounded up to the slack grid.
+ * A one-shot timer that already expired before pause is not armed.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, not paused or timerfd error.
+ */
+gboolean glibhelper_timerfd_resume(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+	if (helper->is_paused == FALSE)
+		return FALSE;
+
+	if ((helper->absolute == TRUE || helper->slack_grid != 0)
+		&& (helper->paused.it_value.tv_sec != 0 || helper->paused.it_value.tv_nsec != 0)) {
+		if (timerfd_arm(helper, helper->fd,
+				(uint64_t)helper->paused.it_value.tv_sec * 1000 * 1000 * 1000 + (uint64_t)helper->paused.it_value.tv_nsec,
+				helper->interval) < 0)
+			return FALSE;
+
+		helper->is_paused = FALSE;
+
+		return TRUE;
+	}
+
+	if (timerfd_settime(helper->fd, 0, &helper->paused, NULL) < 0)
+		return FALSE;
+
+	helper->deadline = timerfd_clock(helper) + (uint64_t)helper->paused.it_value.tv_sec * 1000 * 1000 * 1000
+						+ (uint64_t)helper->paused.it_value.tv_nsec;
+	helper->is_paused = FALSE;
+
+	return TRUE;
+}
+/**
+ * Get total number of expirations of timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return uint64_t
+ * @retval >=0 Number of expirations.
+ */
+uint64_t glibhelper_timerfd_get_expirations(glibhelper_timerfd_support_handle handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return ((struct s_glibhelper_timerfd_support*)handle)->expirations;
+}
+/**
+ * Get total number of missed expirations (overrun) of timer.
+ * When the event loop is stalled longer than interval, the expirations are merged into one callback.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return uint64_t
+ * @retval >=0 Number of missed expirations.
+ */
+uint64_t glibhelper_timerfd_get_overrun(glibhelper_timerfd_support_handle handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return ((struct s_glibhelper_timerfd_support*)handle)->overrun;
+}
+/**
+ * Re-arm timer with absolute deadline on the clock of timer. It can be used in both relative and absolute mode.
+ * With slack, the deadline is rounded up to the slack grid.
+ * It can be called in the timeout callback and for paused timer (the timer is resumed).
+ *
+ * @param [in]	handle	Timer handle
+ * @param [in]	deadline	Time of first expiration(ns). Refer to glibhelper_timerfd_get_time. Past time expires immediately.
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or timerfd error.
+ */
+gboolean glibhelper_timerfd_rearm_at(glibhelper_timerfd_support_handle handle, uint64_t deadline, uint64_t interval)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+
+	if (timerfd_arm_at(helper, helper->fd, deadline, interval) < 0)
+		return FALSE;
+
+	helper->is_paused = FALSE;
+
+	return TRUE;
+}
+/**
+ * Get current time of the clock of timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return uint64_t
+ * @retval >0 Current time(ns).
+ * @retval 0 Arg error.
+ */
+uint64_t glibhelper_timerfd_get_time(glibhelper_timerfd_support_handle handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return timerfd_clock((struct s_glibhelper_timerfd_support*)handle);
+}
+/**
+ * Get wakeup jitter statistics of timer. The jitter is the lateness of each callback (negative lateness is 0).
+ * This function is not thread safe, call it in the context of timer.
+ *
+ * @param [in]	handle	Timer handle
+ * @param [out]	stats	Pointer to store statistics(ns).
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or jitter_stats is not enabled.
+ */
+gboolean glibhelper_timerfd_get_jitter(glibhelper_timerfd_support_handle handle, glibhelper_histogram_stats *stats)
+{
+	if (handle == NULL)
+		return FALSE;
+
+	return glibhelper_histogram_get_stats(((struct s_glibhelper_timerfd_support*)handle)->jitter, stats);
+}
+/**
+ * Get percentile of wakeup jitter of timer. This function is not thread safe, call it in the context of timer.
+ *
+ * @param [in]	handle	Timer handle
+ * @param [in]	percentile	Percentile (0.0 - 100.0).
+ *
+ * @return uint64_t
+ * @retval >=0 Jitter at percentile(ns). 0 when no value is recorded or jitter_stats is not enabled.
+ */
+uint64_t glibhelper_timerfd_get_jitter_percentile(glibhelper_timerfd_support_handle handle, double percentile)
+{
+	if (handle == NULL)
+		return 0;
+
+	return glibhelper_histogram_get_percentile(((struct s_glibhelper_timerfd_support*)handle)->jitter, percentile);
+}
+/**
+ * Clear wakeup jitter statistics of timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or jitter_stats is not enabled.
+ */
+gboolean glibhelper_timerfd_reset_jitter(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+	if (helper->jitter == NULL)
+		return FALSE;
+
+	glibhelper_histogram_reset(helper->jitter);
+
+	return TRUE;
+}
+/**
+ * Handle expirations and call timeout callback.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	timerfd	timerfd
+ * @param [in]	timerinfo	Number of expirations read from timerfd.
+ *
+ * @return gboolean
+ * @retval TRUE Continue timer.
+ * @retval FALSE Timeout callback requested to stop.
+ */
+static gboolean timerfd_expire(struct s_glibhelper_timerfd_support *helper, int timerfd, uint64_t timerinfo)
+{
+	gboolean ret = FALSE;
+	uint64_t latest = 0;
+	uint64_t now = 0;
+	glibhelper_timerfd_info info;
+
+	now = timerfd_clock(helper);
+	if (helper->rearm == TRUE) {
+		// One-shot per expiration. Count the missed nominal deadlines and schedule next one.
+		if (now > helper->nominal)
+			timerinfo = 1 + ((now - helper->nominal) / helper->interval);
+		latest = timerfd_coalesce(helper, helper->nominal + ((timerinfo - 1) * helper->interval));
+		(void)timerfd_arm_at(helper, timerfd, helper->nominal + (timerinfo * helper->interval), helper->interval);
+	} else {
+		// timerinfo is number of expirations since previous read.
+		latest = helper->deadline + ((timerinfo - 1) * helper->interval);
+		helper->deadline = latest + helper->interval;
+	}
+	info.expirations = timerinfo;
+	info.lateness = (int64_t)(now - latest);
+	helper->expirations += timerinfo;
+	helper->overrun += timerinfo - 1;
+	if (helper->jitter != NULL)
+		glibhelper_histogram_record(helper->jitter, (info.lateness > 0) ? (uint64_t)info.lateness : 0);
+
+	if (helper->operation.timeout_ex != NULL)
+		ret = helper->operation.timeout_ex(helper, &info);
+	else if (helper->operation.timeout != NULL)
+		ret = helper->operation.timeout(helper);
+
+	return ret;
+}
+/**
+ * timerfd event.
+ *
+ * @param [in]	fd	timerfd
+ * @param [in]	events	epoll events.
+ * @param [in]	data	Timer
+ *
+ * @return gboolean
+ * @retval TRUE Continue timer.
+ * @retval FALSE Timeout callback requested to stop or error.
+ */
+static gboolean timerfd_event(int fd, uint32_t events, void *data)
+{
+	ssize_t readret = -1;
+	uint64_t timerinfo = 0;
+
+	if ((events & EPOLLIN) != 0) {// timeout
+		readret = read(fd, &timerinfo, sizeof(timerinfo));
+		if (readret <= 0)
+			return TRUE;	// Spurious wakeup (ex. re-armed before dispatch)
+
+		return timerfd_expire((struct s_glibhelper_timerfd_support *)data, fd, timerinfo);
+	}
+
+	return FALSE;	// Undefined error -> stop callback
+}
+/**
+ * Create timer in epoll context.
+ * io_uring backend is not supported in the epoll backend.
+ *
+ * @param [out]	handle	Pointer to store timer handle.
+ * @param [in]	context	epoll context. NULL = default context.
+ * @param [in]	config	Timer configuration.
+ * @param [in]	userdata	userdata for glibhelper_timerfd_get_userdata.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, not supported config or timerfd error.
+ */
+gboolean glibhelper_create_timerfd(glibhelper_timerfd_support_handle *handle, GMainContext *context, glibhelper_timerfd_config *config, void *userdata)
+{
+	int timerfd = -1;
+	int ret = -1;
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL || config == NULL)
+		return FALSE;
+
+	if (config->uring != NULL) {
+		errno = ENOTSUP;
+		return FALSE;
+	}
+
+	helper = (struct s_glibhelper_timerfd_support*)g_malloc(sizeof(struct s_glibhelper_timerfd_support));
+	if (helper == NULL)
+		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_timerfd_support));
+
+	if (config->clock == GLIBHELPER_TIMERFD_CLOCK_REALTIME)
+		helper->clockid = CLOCK_REALTIME;
+	else if (config->clock == GLIBHELPER_TIMERFD_CLOCK_BOOTTIME)
+		helper->clockid = CLOCK_BOOTTIME;
+	else
+		helper->clockid = CLOCK_MONOTONIC;
+	helper->absolute = config->absolute;
+	helper->phase = config->phase;
+	if (config->slack > 0)
+		helper->slack_grid = UINT64_C(1) << (63 - __builtin_clzll(config->slack));	// Largest power of 2 <= slack
+
+	if (config->jitter_stats == TRUE) {
+		if (glibhelper_create_histogram(&helper->jitter) != TRUE)
+			goto errorout;
+	}
+
+	timerfd = timerfd_create(helper->clockid, (TFD_NONBLOCK | TFD_CLOEXEC));
+	if (timerfd < 0)
+		goto errorout;
+
+	ret = timerfd_arm(helper, timerfd, config->initial_delay, config->interval);
+	if (ret < 0)
+		goto errorout;
+
+	helper->operation = config->operation;
+	helper->fd = timerfd;
+	helper->context = context;
+	helper->userdata = userdata;
+
+	helper->watch = glibhelper_epoll_watch_add(context, timerfd, EPOLLIN, timerfd_event, helper);
+	if (helper->watch == NULL)
+		goto errorout;
+
+	(*handle) = (glibhelper_timerfd_support_handle)(helper);
+
+	return TRUE;
+
+errorout:
+
+	if (timerfd >= 0)
+		close(timerfd);
+
+	if (helper->jitter != NULL)
+		(void)glibhelper_terminate_histogram(helper->jitter);
+
+	g_free(helper);
+
+	return FALSE;
+}
+/**
+ * Terminate timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_timerfd(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_timerfd_support *)handle;
+
+	// Destroy timerfd
+	glibhelper_epoll_watch_remove(helper->watch);
+	close(helper->fd);
+	if (helper->jitter != NULL)
+		(void)glibhelper_terminate_histogram(helper->jitter);
+	g_free(helper);
+
+	return TRUE;
+}
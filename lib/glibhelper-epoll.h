@@ -0,0 +1,70 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-epoll.h
+ * @brief	header for GLib free epoll backend (libepoll_support)
+ *
+ * The epoll backend provides the server socket, client socket and timerfd helpers with the same glibhelper_* API
+ * without GLib. Build with -DGLIBHELPER_EPOLL, the helper headers include this header instead of glib.h and
+ * GMainContext is the epoll event loop of this header. NULL context is the default loop.
+ */
+#ifndef GLIBHELPER_EPOLL_H
+#define GLIBHELPER_EPOLL_H
+//-----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+//-----------------------------------------------------------------------------
+// Subset of GLib types used by the helper API.
+typedef int gboolean;
+typedef int gint;
+typedef unsigned int guint;
+typedef int32_t gint32;
+typedef uint32_t guint32;
+typedef int64_t gint64;
+typedef uint64_t guint64;
+typedef void* gpointer;
+
+#ifndef FALSE
+#define FALSE (0)
+#endif
+#ifndef TRUE
+#define TRUE (!FALSE)
+#endif
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define g_malloc(size) malloc(size)
+#define g_free(mem) free(mem)
+
+struct s_glibhelper_epoll_context;
+typedef struct s_glibhelper_epoll_context GMainContext;
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_epoll_watch;
+typedef struct s_glibhelper_epoll_watch *glibhelper_epoll_watch;
+
+/**
+ * fd event callback. events is EPOLLIN/EPOLLERR/EPOLLHUP etc.
+ * Return FALSE to remove the watch (same as glibhelper_epoll_watch_remove).
+ */
+typedef gboolean (*fp_epoll_watch_callback)(int fd, uint32_t events, void *userdata);
+
+//-----------------------------------------------------------------------------
+GMainContext* glibhelper_epoll_context_new(void);
+void glibhelper_epoll_context_free(GMainContext *context);
+GMainContext* glibhelper_epoll_context_default(void);
+int glibhelper_epoll_iteration(GMainContext *context, gboolean may_block);
+void glibhelper_epoll_run(GMainContext *context);
+void glibhelper_epoll_quit(GMainContext *context);
+
+glibhelper_epoll_watch glibhelper_epoll_watch_add(GMainContext *context, int fd, uint32_t events, fp_epoll_watch_callback callback, void *userdata);
+void glibhelper_epoll_watch_remove(glibhelper_epoll_watch watch);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_EPOLL_H
@@ -0,0 +1,236 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-histogram.c
+ * @brief	log-linear histogram for latency and jitter statistics
+ */
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
+#include <glib.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "glibhelper-histogram.h"
+
+// Each power of two range is split into 2^HISTOGRAM_SUB_BITS linear buckets.
+// Relative error of a bucket is less than 1/2^HISTOGRAM_SUB_BITS (6.25%).
+#define HISTOGRAM_SUB_BITS (4)
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+
+struct s_glibhelper_histogram {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+	uint64_t bucket[HISTOGRAM_BUCKETS];
+};
+/**
+ * Get bucket index of value.
+ *
+ * @param [in]	value	Value
+ *
+ * @return int
+ * @retval >=0 Bucket index.
+ */
+static int histogram_index(uint64_t value)
+{
+	int shift = 0;
+
+	if (value < HISTOGRAM_SUB_COUNT)
+		return (int)value;
+
+	// Position of MSB - sub bits
+	shift = (63 - __builtin_clzll(value)) - HISTOGRAM_SUB_BITS;
+
+	return ((shift + 1) << HISTOGRAM_SUB_BITS) + (int)((value >> shift) & (HISTOGRAM_SUB_COUNT - 1));
+}
+/**
+ * Get highest value that falls into bucket.
+ *
+ * @param [in]	index	Bucket index
+ *
+ * @return uint64_t
+ * @retval >=0 Highest value of bucket.
+ */
+static uint64_t histogram_upper(int index)
+{
+	int shift = 0;
+	uint64_t lower = 0;
+
+	if (index < HISTOGRAM_SUB_COUNT)
+		return (uint64_t)index;
+
+	shift = (index >> HISTOGRAM_SUB_BITS) - 1;
+	lower = (uint64_t)(HISTOGRAM_SUB_COUNT + (index & (HISTOGRAM_SUB_COUNT - 1))) << shift;
+
+	return lower + ((UINT64_C(1) << shift) - 1);
+}
+/**
+ * Record value to histogram. This function is not thread safe.
+ *
+ * @param [in]	handle	Histogram handle
+ * @param [in]	value	Value to record.
+ */
+void glibhelper_histogram_record(glibhelper_histogram handle, uint64_t value)
+{
+	struct s_glibhelper_histogram *histogram = NULL;
+
+	if (handle == NULL)
+		return;
+
+	histogram = (struct s_glibhelper_histogram*)handle;
+
+	if (histogram->count == 0 || value < histogram->min)
+		histogram->min = value;
+	if (value > histogram->max)
+		histogram->max = value;
+
+	histogram->count++;
+	histogram->sum += value;
+	histogram->bucket[histogram_index(value)]++;
+}
+/**
+ * Clear all recorded values.
+ *
+ * @param [in]	handle	Histogram handle
+ */
+void glibhelper_histogram_reset(glibhelper_histogram handle)
+{
+	if (handle == NULL)
+		return;
+
+	memset(handle,0,sizeof(struct s_glibhelper_histogram));
+}
+/**
+ * Get percentile of recorded values. The result is the highest value of the bucket that contains the percentile,
+ * so it is within the bucket error (<6.25%) of the exact value and is never lower than it.
+ *
+ * @param [in]	handle	Histogram handle
+ * @param [in]	percentile	Percentile (0.0 - 100.0).
+ *
+ * @return uint64_t
+ * @retval >=0 Value at percentile. 0 when no value is recorded.
+ */
+uint64_t glibhelper_histogram_get_percentile(glibhelper_histogram handle, double percentile)
+{
+	struct s_glibhelper_histogram *histogram = NULL;
+	uint64_t target = 0;
+	uint64_t total = 0;
+	uint64_t value = 0;
+
+	if (handle == NULL)
+		return 0;
+
+	histogram = (struct s_glibhelper_histogram*)handle;
+	if (histogram->count == 0)
+		return 0;
+
+	if (percentile < 0.0)
+		percentile = 0.0;
+	else if (percentile > 100.0)
+		percentile = 100.0;
+
+	// Rank of the percentile, at least the first value.
+	target = (uint64_t)((percentile / 100.0) * (double)histogram->count + 0.5);
+	if (target == 0)
+		target = 1;
+
+	for (int i=0; i < HISTOGRAM_BUCKETS; i++) {
+		total += histogram->bucket[i];
+		if (total >= target) {
+			value = histogram_upper(i);
+			break;
+		}
+	}
+
+	// Bucket bound may exceed the recorded range.
+	if (value > histogram->max)
+		value = histogram->max;
+	if (value < histogram->min)
+		value = histogram->min;
+
+	return value;
+}
+/**
+ * Get summary statistics of recorded values.
+ *
+ * @param [in]	handle	Histogram handle
+ * @param [out]	stats	Pointer to store statistics.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_histogram_get_stats(glibhelper_histogram handle, glibhelper_histogram_stats *stats)
+{
+	struct s_glibhelper_histogram *histogram = NULL;
+
+	if (handle == NULL || stats == NULL)
+		return FALSE;
+
+	histogram = (struct s_glibhelper_histogram*)handle;
+
+	memset(stats,0,sizeof(glibhelper_histogram_stats));
+	if (histogram->count == 0)
+		return TRUE;
+
+	stats->count = histogram->count;
+	stats->min = histogram->min;
+	stats->max = histogram->max;
+	stats->mean = histogram->sum / histogram->count;
+	stats->p50 = glibhelper_histogram_get_percentile(handle, 50.0);
+	stats->p90 = glibhelper_histogram_get_percentile(handle, 90.0);
+	stats->p99 = glibhelper_histogram_get_percentile(handle, 99.0);
+	stats->p999 = glibhelper_histogram_get_percentile(handle, 99.9);
+
+	return TRUE;
+}
+/**
+ * Create histogram.
+ *
+ * @param [in]	handle	Pointer to store created histogram handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_histogram(glibhelper_histogram *handle)
+{
+	struct s_glibhelper_histogram *histogram = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	histogram = (struct s_glibhelper_histogram*)g_malloc(sizeof(struct s_glibhelper_histogram));
+	if (histogram == NULL)
+		return FALSE;
+	memset(histogram,0,sizeof(struct s_glibhelper_histogram));
+
+	(*handle) = (glibhelper_histogram)(histogram);
+
+	return TRUE;
+}
+/**
+ * Terminate histogram.
+ *
+ * @param [in]	handle	Histogram handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_histogram(glibhelper_histogram handle)
+{
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	g_free(handle);
+
+	return TRUE;
+}
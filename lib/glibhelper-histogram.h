@@ -0,0 +1,43 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-histogram.h
+ * @brief	header for glibhelper-histogram
+ */
+#ifndef GLIBHELPER_HISTOGRAM_H
+#define GLIBHELPER_HISTOGRAM_H
+//-----------------------------------------------------------------------------
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
+#include <glib.h>
+#endif
+
+#include <stdint.h>
+
+struct s_glibhelper_histogram;
+typedef struct s_glibhelper_histogram *glibhelper_histogram;
+
+/** glibhelper_histogram_stats.*/
+typedef struct s_glibhelper_histogram_stats {
+	uint64_t count; /**< Number of recorded values. */
+	uint64_t min; /**< Minimum value. */
+	uint64_t max; /**< Maximum value. */
+	uint64_t mean; /**< Mean value. */
+	uint64_t p50; /**< 50th percentile. */
+	uint64_t p90; /**< 90th percentile. */
+	uint64_t p99; /**< 99th percentile. */
+	uint64_t p999; /**< 99.9th percentile. */
+} glibhelper_histogram_stats;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_histogram(glibhelper_histogram *handle);
+gboolean glibhelper_terminate_histogram(glibhelper_histogram handle);
+
+void glibhelper_histogram_record(glibhelper_histogram handle, uint64_t value);
+void glibhelper_histogram_reset(glibhelper_histogram handle);
+uint64_t glibhelper_histogram_get_percentile(glibhelper_histogram handle, double percentile);
+gboolean glibhelper_histogram_get_stats(glibhelper_histogram handle, glibhelper_histogram_stats *stats);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_HISTOGRAM_H
@@ -0,0 +1,544 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-internal-distributor.c
+ * @brief	in-process job distributor to multiple worker contexts with work stealing for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+#include "glibhelper-internal-distributor.h"
+#include "glibhelper-stats.h"
+
+#define INTERNAL_DISTRIBUTOR_BUDGET_DEFAULT (64)
+
+struct s_distributor_source {
+	GSource source;
+	struct s_distributor_worker *worker;
+	gpointer fd_tag;
+};
+
+/**
+ * Worker of distributor. The job queue is a deque, owner pops from head and stealer takes from tail.
+ */
+struct s_distributor_worker {
+	struct s_glibhelper_internal_distributor *parent;
+	struct s_distributor_source *source;
+	GMutex lock;
+	GQueue queue;	// Protected by lock
+	guint64 posted;	// Protected by lock
+	guint64 executed;	// Protected by lock
+	guint64 stolen;	// Protected by lock
+	gint depth;	// Atomic copy of queue length for lock-free peek
+	gint idle;	// 1 = worker is waiting eventfd, poster shall wake it
+	int event_fd;
+	int index;
+};
+
+struct s_glibhelper_internal_distributor {
+	struct s_glibhelper_internal_distributor_operation operation;
+	struct s_distributor_worker *worker;
+	void *userdata;
+	int num_of_worker;
+	int receive_budget;
+	gboolean steal;
+	gint next;
+	glibhelper_stats_entry stats_entry;
+};
+/**
+ * Wake up worker by eventfd.
+ *
+ * @param [in]	worker	Worker
+ */
+static void distributor_wakeup(struct s_distributor_worker *worker)
+{
+	uint64_t value = 1;
+	ssize_t ret = -1;
+
+	do {
+		ret = write(worker->event_fd, &value, sizeof(value));
+	} while((ret == -1) && (errno == EINTR));
+}
+/**
+ * Wake up worker when it is idle.
+ *
+ * @param [in]	worker	Worker
+ *
+ * @return gboolean
+ * @retval TRUE Worker was idle and woken up.
+ * @retval FALSE Worker is running.
+ */
+static gboolean distributor_wakeup_if_idle(struct s_distributor_worker *worker)
+{
+	if (g_atomic_int_get(&worker->idle) == 0)
+		return FALSE;
+
+	if (g_atomic_int_compare_and_exchange(&worker->idle, 1, 0) == FALSE)
+		return FALSE;
+
+	distributor_wakeup(worker);
+
+	return TRUE;
+}
+/**
+ * Find the peer that has the longest queue.
+ *
+ * @param [in]	worker	Worker
+ *
+ * @return struct s_distributor_worker*
+ * @retval !NULL Peer worker.
+ * @retval NULL All peers are empty.
+ */
+static struct s_distributor_worker* distributor_find_victim(struct s_distributor_worker *worker)
+{
+	struct s_glibhelper_internal_distributor *dist = worker->parent;
+	struct s_distributor_worker *victim = NULL;
+	gint depth = 0;
+	gint max = 0;
+
+	for (int i=0; i < dist->num_of_worker; i++) {
+		if (i == worker->index)
+			continue;
+
+		depth = g_atomic_int_get(&dist->worker[i].depth);
+		if (depth > max) {
+			max = depth;
+			victim = &dist->worker[i];
+		}
+	}
+
+	return victim;
+}
+/**
+ * Steal half of the jobs from the tail of the longest peer queue.
+ * Two worker locks are never held at the same time.
+ *
+ * @param [in]	worker	Worker
+ *
+ * @return int
+ * @retval >0 Number of stolen jobs.
+ * @retval 0 No job to steal.
+ */
+static int distributor_steal(struct s_distributor_worker *worker)
+{
+	struct s_distributor_worker *victim = NULL;
+	GQueue stolen = G_QUEUE_INIT;
+	guint num = 0;
+
+	victim = distributor_find_victim(worker);
+	if (victim == NULL)
+		return 0;
+
+	g_mutex_lock(&victim->lock);
+	num = (victim->queue.length + 1) / 2;
+	for (guint i=0; i < num; i++)
+		g_queue_push_head(&stolen, g_queue_pop_tail(&victim->queue));
+	g_atomic_int_add(&victim->depth, -((gint)num));
+	g_mutex_unlock(&victim->lock);
+
+	if (num == 0)
+		return 0;
+
+	g_mutex_lock(&worker->lock);
+	for (GList *entry = stolen.head; entry != NULL; entry = entry->next)
+		g_queue_push_tail(&worker->queue, entry->data);
+	worker->stolen += num;
+	g_atomic_int_add(&worker->depth, (gint)num);
+	g_mutex_unlock(&worker->lock);
+
+	g_queue_clear(&stolen);
+
+	return (int)num;
+}
+/**
+ * Pop a job from own queue.
+ *
+ * @param [in]	worker	Worker
+ *
+ * @return void*
+ * @retval !NULL Job.
+ * @retval NULL Queue is empty.
+ */
+static void* distributor_pop(struct s_distributor_worker *worker)
+{
+	void *job = NULL;
+
+	if (g_atomic_int_get(&worker->depth) == 0)
+		return NULL;
+
+	g_mutex_lock(&worker->lock);
+	job = g_queue_pop_head(&worker->queue);
+	if (job != NULL) {
+		worker->executed++;
+		g_atomic_int_add(&worker->depth, -1);
+	}
+	g_mutex_unlock(&worker->lock);
+
+	return job;
+}
+/**
+ * Check pending job of worker.
+ *
+ * @param [in]	worker	Worker
+ *
+ * @return gboolean
+ * @retval TRUE Own queue or (in steal mode) peer queue has jobs.
+ * @retval FALSE No job.
+ */
+static gboolean distributor_pending(struct s_distributor_worker *worker)
+{
+	if (g_atomic_int_get(&worker->depth) > 0)
+		return TRUE;
+
+	if (worker->parent->steal == TRUE && distributor_find_victim(worker) != NULL)
+		return TRUE;
+
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean distributor_source_prepare(GSource *source, gint *timeout)
+{
+	struct s_distributor_source *distsource = (struct s_distributor_source*)source;
+	struct s_distributor_worker *worker = distsource->worker;
+
+	*timeout = -1;
+
+	if (distributor_pending(worker) == TRUE)
+		return TRUE;
+
+	// Going to idle. Poster wakes up by eventfd after this point.
+	g_atomic_int_set(&worker->idle, 1);
+
+	if (distributor_pending(worker) == TRUE) {
+		g_atomic_int_set(&worker->idle, 0);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean distributor_source_check(GSource *source)
+{
+	struct s_distributor_source *distsource = (struct s_distributor_source*)source;
+
+	if ((g_source_query_unix_fd(source, distsource->fd_tag) & G_IO_IN) != 0)
+		return TRUE;
+
+	return distributor_pending(distsource->worker);
+}
+//-----------------------------------------------------------------------------
+static gboolean distributor_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	struct s_distributor_source *distsource = (struct s_distributor_source*)source;
+	struct s_distributor_worker *worker = distsource->worker;
+	struct s_glibhelper_internal_distributor *dist = worker->parent;
+	uint64_t value = 0;
+	void *job = NULL;
+
+	if ((g_source_query_unix_fd(source, distsource->fd_tag) & G_IO_IN) != 0)
+		(void)read(worker->event_fd, &value, sizeof(value));	// Clear wakeup
+
+	g_atomic_int_set(&worker->idle, 0);
+
+	for (int i=0; i < dist->receive_budget; i++) {
+		job = distributor_pop(worker);
+		if (job == NULL) {
+			if (dist->steal == FALSE || distributor_steal(worker) == 0)
+				break;
+			job = distributor_pop(worker);
+			if (job == NULL)
+				break;
+		}
+
+		if (dist->operation.job != NULL)
+			dist->operation.job((glibhelper_distributor_worker_handle)worker, job);
+		else if (dist->operation.release != NULL)
+			dist->operation.release(job);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static GSourceFuncs distributor_source_funcs = {
+	.prepare = distributor_source_prepare,
+	.check = distributor_source_check,
+	.dispatch = distributor_source_dispatch,
+	.finalize = NULL,
+};
+/**
+ * Get userdata from worker handle.
+ * The userdata is set at glibhelper_create_internal_distributor.
+ *
+ * @param [in]	worker	Worker handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_internal_distributor_get_userdata(glibhelper_distributor_worker_handle worker)
+{
+	if ( worker == NULL)
+		return NULL;
+
+	return ((struct s_distributor_worker*)worker)->parent->userdata;
+}
+/**
+ * Get index of worker from worker handle. It is the index of worker_context at create.
+ *
+ * @param [in]	worker	Worker handle
+ *
+ * @return int
+ * @retval >=0 Index of worker.
+ * @retval <0 Illegal handle error.
+ */
+int glibhelper_internal_distributor_get_worker_index(glibhelper_distributor_worker_handle worker)
+{
+	if ( worker == NULL)
+		return -1;
+
+	return ((struct s_distributor_worker*)worker)->index;
+}
+/**
+ * Get total number of queued jobs in distributor. It can be used as scaling metric of worker pool.
+ *
+ * @param [in]	handle	Distributor handle
+ *
+ * @return int
+ * @retval >=0 Number of queued jobs.
+ * @retval <0 Illegal handle error.
+ */
+int glibhelper_internal_distributor_get_queue_depth(glibhelper_internal_distributor handle)
+{
+	struct s_glibhelper_internal_distributor *dist = NULL;
+	int depth = 0;
+
+	if ( handle == NULL)
+		return -1;
+
+	dist = (struct s_glibhelper_internal_distributor*)handle;
+
+	for (int i=0; i < dist->num_of_worker; i++)
+		depth += g_atomic_int_get(&dist->worker[i].depth);
+
+	return depth;
+}
+/**
+ * Get statistics of a worker. This function can be called from any thread.
+ *
+ * @param [in]	handle	Distributor handle
+ * @param [in]	index	Index of worker
+ * @param [out]	stats	Pointer to store statistics.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_internal_distributor_get_worker_stats(glibhelper_internal_distributor handle, int index, glibhelper_distributor_worker_stats *stats)
+{
+	struct s_glibhelper_internal_distributor *dist = NULL;
+	struct s_distributor_worker *worker = NULL;
+
+	if ( handle == NULL || stats == NULL)
+		return FALSE;
+
+	dist = (struct s_glibhelper_internal_distributor*)handle;
+	if (index < 0 || index >= dist->num_of_worker)
+		return FALSE;
+
+	worker = &dist->worker[index];
+
+	g_mutex_lock(&worker->lock);
+	stats->queue_depth = (int)worker->queue.length;
+	stats->posted = worker->posted;
+	stats->executed = worker->executed;
+	stats->stolen = worker->stolen;
+	g_mutex_unlock(&worker->lock);
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void distributor_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_internal_distributor *dist = (struct s_glibhelper_internal_distributor*)userdata;
+	glibhelper_distributor_worker_stats stats;
+
+	for (int i=0; i < dist->num_of_worker; i++) {
+		if (glibhelper_internal_distributor_get_worker_stats(dist, i, &stats) == TRUE)
+			glibhelper_stats_print(fd, "  worker[%d] depth=%d posted=%lu executed=%lu stolen=%lu\n", i, stats.queue_depth,
+					(unsigned long)stats.posted, (unsigned long)stats.executed, (unsigned long)stats.stolen);
+	}
+}
+/**
+ * Post job to distributor. The job is queued to a worker by round robin, and
+ * the job callback is called in the worker context. This function is thread safe.
+ * When the selected worker is busy, an idle worker is woken up to steal the job.
+ *
+ * @param [in]	handle	Distributor handle
+ * @param [in]	job	Job data. It shall not be NULL.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_internal_distributor_post(glibhelper_internal_distributor handle, void *job)
+{
+	struct s_glibhelper_internal_distributor *dist = NULL;
+	struct s_distributor_worker *worker = NULL;
+	int index = 0;
+
+	if ( handle == NULL || job == NULL)
+		return FALSE;
+
+	dist = (struct s_glibhelper_internal_distributor*)handle;
+
+	index = (int)((guint)g_atomic_int_add(&dist->next, 1) % (guint)dist->num_of_worker);
+	worker = &dist->worker[index];
+
+	g_mutex_lock(&worker->lock);
+	g_queue_push_tail(&worker->queue, job);
+	worker->posted++;
+	g_atomic_int_add(&worker->depth, 1);
+	g_mutex_unlock(&worker->lock);
+
+	if (distributor_wakeup_if_idle(worker) == TRUE || dist->steal == FALSE)
+		return TRUE;
+
+	// Selected worker is busy. Let one idle peer steal it.
+	for (int i=1; i < dist->num_of_worker; i++) {
+		if (distributor_wakeup_if_idle(&dist->worker[(index + i) % dist->num_of_worker]) == TRUE)
+			break;
+	}
+
+	return TRUE;
+}
+/**
+ * Create distributor channel. One job source is attached to each worker context.
+ * Each worker context shall be run by its own thread.
+ *
+ * @param [in]	handle	Pointer to store created distributor handle.
+ * @param [in]	worker_context	Array of worker context (num_of_worker entries). NULL entry is default context.
+ * @param [in]	config	Distributor configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_internal_distributor(glibhelper_internal_distributor *handle, GMainContext **worker_context,
+	glibhelper_internal_distributor_config *config, void* userdata)
+{
+	struct s_glibhelper_internal_distributor *dist = NULL;
+	struct s_distributor_worker *worker = NULL;
+	int num = 0;
+
+	if (handle == NULL || worker_context == NULL || config == NULL || config->num_of_worker <= 0)
+		return FALSE;
+
+	dist = (struct s_glibhelper_internal_distributor*)g_malloc(sizeof(struct s_glibhelper_internal_distributor));
+	if (dist == NULL)
+		return FALSE;
+	memset(dist,0,sizeof(struct s_glibhelper_internal_distributor));
+
+	dist->worker = (struct s_distributor_worker*)g_malloc(sizeof(struct s_distributor_worker) * config->num_of_worker);
+	if (dist->worker == NULL)
+		goto errorout;
+	memset(dist->worker,0,sizeof(struct s_distributor_worker) * config->num_of_worker);
+
+	dist->operation = config->operation;
+	dist->userdata = userdata;
+	dist->num_of_worker = config->num_of_worker;
+	dist->receive_budget = (config->receive_budget > 0) ? config->receive_budget : INTERNAL_DISTRIBUTOR_BUDGET_DEFAULT;
+	dist->steal = (config->disable_steal == TRUE) ? FALSE : TRUE;
+
+	for (num=0; num < config->num_of_worker; num++) {
+		worker = &dist->worker[num];
+		worker->parent = dist;
+		worker->index = num;
+		g_mutex_init(&worker->lock);
+		g_queue_init(&worker->queue);
+
+		worker->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (worker->event_fd < 0) {
+			g_mutex_clear(&worker->lock);
+			goto errorout;
+		}
+	}
+
+	// Attach after all workers are initialized, peers are referenced by steal.
+	for (int i=0; i < dist->num_of_worker; i++) {
+		worker = &dist->worker[i];
+		worker->source = (struct s_distributor_source*)g_source_new(&distributor_source_funcs, sizeof(struct s_distributor_source));
+		worker->source->worker = worker;
+		worker->source->fd_tag = g_source_add_unix_fd((GSource*)worker->source, worker->event_fd, G_IO_IN);
+		(void)g_source_attach((GSource*)worker->source, worker_context[i]);
+	}
+
+	dist->stats_entry = glibhelper_stats_register("distributor", distributor_stats_dump, dist);
+
+	(*handle) = (glibhelper_internal_distributor)(dist);
+
+	return TRUE;
+
+errorout:
+	if (dist->worker != NULL) {
+		for (int i=0; i < num; i++) {
+			(void)close(dist->worker[i].event_fd);
+			g_mutex_clear(&dist->worker[i].lock);
+		}
+	}
+	g_free(dist->worker);
+	g_free(dist);
+
+	return FALSE;
+}
+/**
+ * Terminate distributor channel. Not executed jobs are passed to release callback.
+ * Stop all worker loops before this function, job callbacks shall not be running.
+ *
+ * @param [in]	handle	Distributor handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_internal_distributor(glibhelper_internal_distributor handle)
+{
+	struct s_glibhelper_internal_distributor *dist = NULL;
+	struct s_distributor_worker *worker = NULL;
+	void *job = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	dist = (struct s_glibhelper_internal_distributor*)handle;
+
+	glibhelper_stats_unregister(dist->stats_entry);
+
+	for (int i=0; i < dist->num_of_worker; i++) {
+		worker = &dist->worker[i];
+
+		g_source_destroy((GSource*)worker->source);
+		g_source_unref((GSource*)worker->source);
+
+		while ((job = g_queue_pop_head(&worker->queue)) != NULL) {
+			if (dist->operation.release != NULL)
+				dist->operation.release(job);
+		}
+
+		(void)close(worker->event_fd);
+		g_mutex_clear(&worker->lock);
+	}
+
+	g_free(dist->worker);
+	g_free(dist);
+
+	return TRUE;
+}
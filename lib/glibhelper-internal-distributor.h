@@ -0,0 +1,54 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-internal-distributor.h
+ * @brief	header for glibhelper-internal-distributor
+ */
+#ifndef GLIBHELPER_INTERNAL_DISTRIBUTOR_H
+#define GLIBHELPER_INTERNAL_DISTRIBUTOR_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_internal_distributor;
+typedef struct s_glibhelper_internal_distributor *glibhelper_internal_distributor;
+
+typedef void* glibhelper_distributor_worker_handle;
+
+typedef void (*fp_job_callback_dist)(glibhelper_distributor_worker_handle worker, void *job);
+typedef void (*fp_release_callback_dist)(void *job);
+
+struct s_glibhelper_internal_distributor_operation {
+	fp_job_callback_dist job; /**< Callbuck for job execution in worker context. */
+	fp_release_callback_dist release; /**< Callbuck for not executed job at terminate. It may be NULL. */
+};
+
+/** glibhelper_internal_distributor_config.*/
+typedef struct s_glibhelper_internal_distributor_config {
+	struct s_glibhelper_internal_distributor_operation operation; /**< distributor event handler. */
+	int num_of_worker; /**< number of worker context. */
+	int receive_budget; /**< max job callbacks per dispatch. 0 = default (64). */
+	gboolean disable_steal; /**< TRUE = idle worker does not steal jobs from busy peers. */
+} glibhelper_internal_distributor_config;
+
+/** glibhelper_distributor_worker_stats.*/
+typedef struct s_glibhelper_distributor_worker_stats {
+	int queue_depth; /**< number of queued jobs. */
+	guint64 posted; /**< number of jobs posted to this worker. */
+	guint64 executed; /**< number of jobs executed by this worker. */
+	guint64 stolen; /**< number of jobs this worker stole from peers. */
+} glibhelper_distributor_worker_stats;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_internal_distributor(glibhelper_internal_distributor *handle, GMainContext **worker_context,
+	glibhelper_internal_distributor_config *config, void* userdata);
+gboolean glibhelper_terminate_internal_distributor(glibhelper_internal_distributor handle);
+void* glibhelper_internal_distributor_get_userdata(glibhelper_distributor_worker_handle worker);
+int glibhelper_internal_distributor_get_worker_index(glibhelper_distributor_worker_handle worker);
+int glibhelper_internal_distributor_get_queue_depth(glibhelper_internal_distributor handle);
+gboolean glibhelper_internal_distributor_get_worker_stats(glibhelper_internal_distributor handle, int index, glibhelper_distributor_worker_stats *stats);
+gboolean glibhelper_internal_distributor_post(glibhelper_internal_distributor handle, void *job);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_INTERNAL_DISTRIBUTOR_H
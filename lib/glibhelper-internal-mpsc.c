@@ -0,0 +1,412 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-internal-mpsc.c
+ * @brief	in-process multi producer single consumer internal channel for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-internal-mpsc.h"
+#include "glibhelper-stats.h"
+
+#define INTERNAL_MPSC_CACHELINE (64)
+#define INTERNAL_MPSC_BUDGET_DEFAULT (64)
+
+/**
+ * Slot of bounded queue. The sequence shows the slot state for position pos.
+ * sequence == pos : free for producer, sequence == pos + 1 : published for consumer.
+ */
+struct s_internal_mpsc_slot {
+	gint sequence;
+	size_t size;
+	uint8_t data[];
+};
+
+struct s_internal_mpsc_source {
+	GSource source;
+	struct s_glibhelper_internal_mpsc *helper;
+	gpointer fd_tag;
+};
+
+struct s_glibhelper_internal_mpsc {
+	gint tail;	// Claimed by producers
+	uint8_t pad0[INTERNAL_MPSC_CACHELINE - sizeof(gint)];
+	gint consumer_idle;	// 1 = consumer is waiting eventfd, producer shall wake it
+	uint8_t pad1[INTERNAL_MPSC_CACHELINE - sizeof(gint)];
+	guint head;	// Consumer only
+	guint mask;
+	size_t slot_size;
+	size_t packet_max_size;
+	uint8_t *slots;
+	int event_fd;
+	struct s_internal_mpsc_source *source;
+	struct s_glibhelper_internal_mpsc_operation operation;
+	GMainContext *context;
+	void *userdata;
+	int receive_budget;
+	enum glibhelper_receive_state rx_state;
+	// Statistics. Atomic, they are updated by producers and read by glibhelper_stats_dump in other threads.
+	guint64 wakeups;	// eventfd writes to wake up the consumer
+	guint64 full;	// Writes rejected by full queue
+	glibhelper_stats_entry stats_entry;
+};
+/**
+ * Get slot by position.
+ *
+ * @param [in]	helper	MPSC channel
+ * @param [in]	pos	Position.
+ *
+ * @return struct s_internal_mpsc_slot*
+ */
+static inline struct s_internal_mpsc_slot* internal_mpsc_slot(struct s_glibhelper_internal_mpsc *helper, guint pos)
+{
+	return (struct s_internal_mpsc_slot*)(helper->slots + (helper->slot_size * (pos & helper->mask)));
+}
+/**
+ * Check published packet for consumer.
+ *
+ * @param [in]	helper	MPSC channel
+ *
+ * @return gboolean
+ * @retval TRUE Some packets are published.
+ * @retval FALSE Queue is empty.
+ */
+static gboolean internal_mpsc_pending(struct s_glibhelper_internal_mpsc *helper)
+{
+	struct s_internal_mpsc_slot *slot = internal_mpsc_slot(helper, helper->head);
+
+	return ((guint)g_atomic_int_get(&slot->sequence) == helper->head + 1) ? TRUE : FALSE;
+}
+/**
+ * Get userdata from mpsc session handle.
+ * The userdata is set at glibhelper_create_internal_mpsc.
+ *
+ * @param [in]	handle	MPSC session handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_internal_mpsc_get_userdata(glibhelper_internal_session_handle handle)
+{
+	struct s_glibhelper_internal_mpsc *helper = NULL;
+
+	if ( handle == NULL)
+		return NULL;
+
+	helper = (struct s_glibhelper_internal_mpsc*)handle;
+
+	return helper->userdata;
+}
+/**
+ * Read packet from mpsc channel. This function shall be called from the consumer context thread.
+ * When the buffer is smaller than the packet, the packet is truncated.
+ *
+ * @param [in]	handle	MPSC session handle
+ * @param [in]	buf Pointer to read buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes read.
+ * @retval <0 error (refer to error no). EAGAIN means no packet.
+ */
+ssize_t glibhelper_internal_mpsc_read(glibhelper_internal_session_handle handle, void *buf, size_t count)
+{
+	struct s_glibhelper_internal_mpsc *helper = NULL;
+	struct s_internal_mpsc_slot *slot = NULL;
+	size_t size = 0;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_internal_mpsc*)handle;
+
+	slot = internal_mpsc_slot(helper, helper->head);
+	if ((guint)g_atomic_int_get(&slot->sequence) != helper->head + 1) {
+		helper->rx_state = GLIBHELPER_RX_DRAINED;
+		errno = EAGAIN;
+		return -1;
+	}
+
+	size = (slot->size < count) ? slot->size : count;
+	memcpy(buf, slot->data, size);
+
+	// Release slot for the producer of next lap.
+	g_atomic_int_set(&slot->sequence, (gint)(helper->head + helper->mask + 1));
+	helper->head++;
+
+	helper->rx_state = GLIBHELPER_RX_READ;
+
+	return (ssize_t)size;
+}
+/**
+ * Write packet to mpsc channel. This function can be called from any thread at the same time.
+ * The consumer context is woken up by eventfd only when it is idle, so the wakeups of
+ * many producers are batched to one.
+ *
+ * @param [in]	handle	MPSC channel handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written.
+ * @retval <0 error (refer to error no). EAGAIN means queue is full.
+ */
+ssize_t glibhelper_internal_mpsc_write(glibhelper_internal_mpsc handle, void *buf, size_t count)
+{
+	struct s_glibhelper_internal_mpsc *helper = NULL;
+	struct s_internal_mpsc_slot *slot = NULL;
+	uint64_t value = 1;
+	guint pos = 0;
+	gint diff = 0;
+	ssize_t ret = -1;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_internal_mpsc*)handle;
+
+	if (count > helper->packet_max_size) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+
+	// Claim a slot.
+	pos = (guint)g_atomic_int_get(&helper->tail);
+	for (;;) {
+		slot = internal_mpsc_slot(helper, pos);
+		diff = (gint)((guint)g_atomic_int_get(&slot->sequence) - pos);
+
+		if (diff == 0) {
+			if (g_atomic_int_compare_and_exchange(&helper->tail, (gint)pos, (gint)(pos + 1)) == TRUE)
+				break;
+		} else if (diff < 0) {
+			__atomic_fetch_add(&helper->full, 1, __ATOMIC_RELAXED);
+			errno = EAGAIN;	// Queue is full
+			return -1;
+		}
+
+		pos = (guint)g_atomic_int_get(&helper->tail);
+	}
+
+	slot->size = count;
+	memcpy(slot->data, buf, count);
+
+	g_atomic_int_set(&slot->sequence, (gint)(pos + 1));	// Publish slot to consumer
+
+	// Wake up consumer only when it is idle. Only one producer wins and writes eventfd.
+	if (g_atomic_int_get(&helper->consumer_idle) != 0) {
+		if (g_atomic_int_compare_and_exchange(&helper->consumer_idle, 1, 0) == TRUE) {
+			do {
+				ret = write(helper->event_fd, &value, sizeof(value));
+			} while((ret == -1) && (errno == EINTR));
+			__atomic_fetch_add(&helper->wakeups, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return (ssize_t)count;
+}
+//-----------------------------------------------------------------------------
+static gboolean internal_mpsc_source_prepare(GSource *source, gint *timeout)
+{
+	struct s_internal_mpsc_source *mpscsource = (struct s_internal_mpsc_source*)source;
+	struct s_glibhelper_internal_mpsc *helper = mpscsource->helper;
+
+	*timeout = -1;
+
+	if (internal_mpsc_pending(helper) == TRUE)
+		return TRUE;
+
+	// Going to idle. Producers wake up by eventfd after this point.
+	g_atomic_int_set(&helper->consumer_idle, 1);
+
+	if (internal_mpsc_pending(helper) == TRUE) {
+		g_atomic_int_set(&helper->consumer_idle, 0);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean internal_mpsc_source_check(GSource *source)
+{
+	struct s_internal_mpsc_source *mpscsource = (struct s_internal_mpsc_source*)source;
+
+	if ((g_source_query_unix_fd(source, mpscsource->fd_tag) & G_IO_IN) != 0)
+		return TRUE;
+
+	return internal_mpsc_pending(mpscsource->helper);
+}
+//-----------------------------------------------------------------------------
+static gboolean internal_mpsc_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	struct s_internal_mpsc_source *mpscsource = (struct s_internal_mpsc_source*)source;
+	struct s_glibhelper_internal_mpsc *helper = mpscsource->helper;
+	uint64_t value = 0;
+	uint8_t discard = 0;
+	gboolean bret = TRUE;
+
+	if ((g_source_query_unix_fd(source, mpscsource->fd_tag) & G_IO_IN) != 0)
+		(void)read(helper->event_fd, &value, sizeof(value));	// Clear wakeup
+
+	g_atomic_int_set(&helper->consumer_idle, 0);
+
+	for (int i=0; i < helper->receive_budget; i++) {
+		if (internal_mpsc_pending(helper) == FALSE)
+			break;
+
+		if (helper->operation.receive == NULL) {
+			(void)glibhelper_internal_mpsc_read((glibhelper_internal_session_handle)helper, &discard, sizeof(discard));
+			continue;
+		}
+
+		helper->rx_state = GLIBHELPER_RX_NOT_READ;
+		bret = helper->operation.receive((glibhelper_internal_session_handle)helper);
+		if (bret == FALSE)
+			return G_SOURCE_REMOVE;	// When this event return FALSE, this event watch is disabled
+		if (helper->rx_state == GLIBHELPER_RX_NOT_READ)
+			break;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static GSourceFuncs internal_mpsc_source_funcs = {
+	.prepare = internal_mpsc_source_prepare,
+	.check = internal_mpsc_source_check,
+	.dispatch = internal_mpsc_source_dispatch,
+	.finalize = NULL,
+};
+//-----------------------------------------------------------------------------
+static void internal_mpsc_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_internal_mpsc *helper = (struct s_glibhelper_internal_mpsc*)userdata;
+
+	glibhelper_stats_print(fd, "  capacity=%u wakeups=%lu full=%lu\n", helper->mask + 1,
+			(unsigned long)__atomic_load_n(&helper->wakeups, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&helper->full, __ATOMIC_RELAXED));
+}
+/**
+ * Create multi producer single consumer internal channel.
+ * Any number of threads can write to the channel, and the receive callback is called in the consumer context.
+ *
+ * @param [in]	handle	Pointer to store created mpsc channel handle.
+ * @param [in]	context	Consumer event loop context. NULL is default context.
+ * @param [in]	config	MPSC channel configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_internal_mpsc(glibhelper_internal_mpsc *handle, GMainContext *context, glibhelper_internal_mpsc_config *config, void* userdata)
+{
+	struct s_glibhelper_internal_mpsc *helper = NULL;
+	struct s_internal_mpsc_source *mpscsource = NULL;
+	guint num = 1;
+
+	if (handle == NULL || config == NULL)
+		return FALSE;
+
+	if (config->packet_max_size <= 0 || config->packet_max_num <= 0)
+		return FALSE;
+
+	helper = (struct s_glibhelper_internal_mpsc*)g_malloc(sizeof(struct s_glibhelper_internal_mpsc));
+	if (helper == NULL)
+		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_internal_mpsc));
+	helper->event_fd = -1;
+
+	while (num < (guint)config->packet_max_num && num < (1u << 30))
+		num = num << 1;
+
+	helper->mask = num - 1;
+	helper->packet_max_size = (size_t)config->packet_max_size;
+	helper->slot_size = sizeof(struct s_internal_mpsc_slot) + helper->packet_max_size;
+	helper->slot_size = (helper->slot_size + 7u) & ~((size_t)7u);
+
+	helper->slots = (uint8_t*)g_malloc(helper->slot_size * num);
+	if (helper->slots == NULL)
+		goto errorout;
+
+	for (guint i=0; i < num; i++)
+		internal_mpsc_slot(helper, i)->sequence = (gint)i;
+
+	helper->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (helper->event_fd < 0)
+		goto errorout;
+
+	mpscsource = (struct s_internal_mpsc_source*)g_source_new(&internal_mpsc_source_funcs, sizeof(struct s_internal_mpsc_source));
+	if (mpscsource == NULL)
+		goto errorout;
+
+	mpscsource->helper = helper;
+	mpscsource->fd_tag = g_source_add_unix_fd((GSource*)mpscsource, helper->event_fd, G_IO_IN);
+
+	helper->source = mpscsource;	// Keep reference until terminate
+	helper->operation = config->operation;
+	helper->context = context;
+	helper->userdata = userdata;
+	helper->receive_budget = (config->receive_budget > 0) ? config->receive_budget : INTERNAL_MPSC_BUDGET_DEFAULT;
+
+	(void)g_source_attach((GSource*)mpscsource, context);
+
+	helper->stats_entry = glibhelper_stats_register("internal_mpsc", internal_mpsc_stats_dump, helper);
+
+	(*handle) = (glibhelper_internal_mpsc)(helper);
+
+	return TRUE;
+
+errorout:
+	if (helper->event_fd >= 0)
+		(void)close(helper->event_fd);
+
+	g_free(helper->slots);
+	g_free(helper);
+
+	return FALSE;
+}
+/**
+ * Terminate mpsc channel. Queued packets are discarded.
+ * All producer threads shall stop writing before this function.
+ *
+ * @param [in]	handle	MPSC channel handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_internal_mpsc(glibhelper_internal_mpsc handle)
+{
+	struct s_glibhelper_internal_mpsc *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_internal_mpsc*)handle;
+
+	glibhelper_stats_unregister(helper->stats_entry);
+
+	g_source_destroy((GSource*)helper->source);
+	g_source_unref((GSource*)helper->source);
+
+	(void)close(helper->event_fd);
+	g_free(helper->slots);
+	g_free(helper);
+
+	return TRUE;
+}
@@ -0,0 +1,39 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-internal-mpsc.h
+ * @brief	header for glibhelper-internal-mpsc
+ */
+#ifndef GLIBHELPER_INTERNAL_MPSC_H
+#define GLIBHELPER_INTERNAL_MPSC_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "glibhelper-unix-socket-support.h"
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_internal_mpsc;
+typedef struct s_glibhelper_internal_mpsc *glibhelper_internal_mpsc;
+
+struct s_glibhelper_internal_mpsc_operation {
+	fp_receive_callback_in receive; /**< Callbuck for packet receive in consumer context. */
+};
+
+/** glibhelper_internal_mpsc_config.*/
+typedef struct s_glibhelper_internal_mpsc_config {
+	struct s_glibhelper_internal_mpsc_operation operation; /**< mpsc channel event handler. */
+	int packet_max_size; /**< max bytes of packet. */
+	int packet_max_num; /**< number of queuing packet, round up to power of 2. */
+	int receive_budget; /**< max receive callbacks per dispatch. 0 = default (64). */
+} glibhelper_internal_mpsc_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_internal_mpsc(glibhelper_internal_mpsc *handle, GMainContext *context, glibhelper_internal_mpsc_config *config, void* userdata);
+gboolean glibhelper_terminate_internal_mpsc(glibhelper_internal_mpsc handle);
+void* glibhelper_internal_mpsc_get_userdata(glibhelper_internal_session_handle handle);
+ssize_t glibhelper_internal_mpsc_read(glibhelper_internal_session_handle handle, void *buf, size_t count);
+ssize_t glibhelper_internal_mpsc_write(glibhelper_internal_mpsc handle, void *buf, size_t count);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_INTERNAL_MPSC_H
@@ -0,0 +1,736 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-internal-ring.c
+ * @brief	in-process internal channel by lock-free single producer single consumer ring for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-internal-ring.h"
+#include "glibhelper-stats.h"
+
+#define INTERNAL_RING_CACHELINE (64)
+#define INTERNAL_RING_BUDGET_DEFAULT (64)
+
+enum internal_ring_side {
+	//! Primary side of ring channel
+	PRIMARY_SIDE = 0,
+
+	//! Secoundary side of ring channel
+	SECOUNDARY_SIDE = 1,
+};
+
+struct s_internal_ring_slot {
+	size_t size;
+	void *ptr;	// Pointer passing mode : !NULL
+	fp_release_callback_in release;
+	uint8_t data[];
+};
+
+/**
+ * One direction of ring channel. It is written by one producer thread and read by one consumer thread.
+ * Producer index and consumer index are placed in separate cache lines to avoid false sharing.
+ */
+struct s_internal_ring_queue {
+	gint tail;	// Written by producer
+	uint8_t pad0[INTERNAL_RING_CACHELINE - sizeof(gint)];
+	gint head;	// Written by consumer
+	uint8_t pad1[INTERNAL_RING_CACHELINE - sizeof(gint)];
+	gint consumer_idle;	// 1 = consumer is waiting eventfd, producer shall wake it
+	gint producer_closed;
+	gint consumer_closed;
+	uint8_t pad2[INTERNAL_RING_CACHELINE - (sizeof(gint) * 3)];
+	int event_fd;	// eventfd of consumer
+	guint mask;
+	size_t slot_size;
+	uint8_t *slots;
+};
+
+struct s_internal_ring_shared {
+	struct s_internal_ring_queue queue[2];	// Index is producer side. [PRIMARY_SIDE] is primary to secondary.
+	gint refcount;
+	gint secondary_leased;
+	size_t packet_max_size;
+};
+
+struct s_internal_ring_source {
+	GSource source;
+	struct s_glibhelper_internal_ring *helper;
+	gpointer fd_tag;
+};
+
+struct s_glibhelper_internal_ring {
+	struct s_internal_ring_source *source;
+	struct s_internal_ring_shared *shared;
+	struct s_internal_ring_queue *tx;
+	struct s_internal_ring_queue *rx;
+	struct s_glibhelper_internal_socket_operation operation;
+	GMainContext *context;
+	void *userdata;
+	enum internal_ring_side side;
+	int receive_budget;
+	enum glibhelper_receive_state rx_state;
+	// Statistics of tx side. Atomic, they are read by glibhelper_stats_dump in other threads.
+	guint64 wakeups;	// eventfd writes to wake up the other side
+	guint64 full;	// Writes rejected by full ring
+	glibhelper_stats_entry stats_entry;
+};
+/**
+ * Check pending event of consumer side queue.
+ *
+ * @param [in]	queue	Receive queue.
+ *
+ * @return gboolean
+ * @retval TRUE Some packets are queued or producer was closed.
+ * @retval FALSE No event.
+ */
+static gboolean internal_ring_rx_pending(struct s_internal_ring_queue *queue)
+{
+	if (g_atomic_int_get(&queue->tail) != g_atomic_int_get(&queue->head))
+		return TRUE;
+
+	if (g_atomic_int_get(&queue->producer_closed) != 0)
+		return TRUE;
+
+	return FALSE;
+}
+/**
+ * Wake up consumer by eventfd.
+ *
+ * @param [in]	queue	Queue of consumer.
+ */
+static void internal_ring_wakeup(struct s_internal_ring_queue *queue)
+{
+	uint64_t value = 1;
+	ssize_t ret = -1;
+
+	do {
+		ret = write(queue->event_fd, &value, sizeof(value));
+	} while((ret == -1) && (errno == EINTR));
+}
+/**
+ * Release shared ring. When the last reference is released, the ring is freed.
+ *
+ * @param [in]	shared	Shared ring.
+ */
+static void internal_ring_shared_unref(struct s_internal_ring_shared *shared)
+{
+	struct s_internal_ring_queue *queue = NULL;
+	struct s_internal_ring_slot *slot = NULL;
+
+	if (g_atomic_int_dec_and_test(&shared->refcount) == FALSE)
+		return;
+
+	// Release objects that were passed by pointer but not received.
+	for (int i=0; i < 2; i++) {
+		queue = &shared->queue[i];
+		for (guint pos = (guint)queue->head; pos != (guint)queue->tail; pos++) {
+			slot = (struct s_internal_ring_slot*)(queue->slots + (queue->slot_size * (pos & queue->mask)));
+			if (slot->ptr != NULL && slot->release != NULL)
+				slot->release(slot->ptr);
+		}
+	}
+
+	for (int i=0; i < 2; i++) {
+		if (shared->queue[i].event_fd >= 0)
+			(void)close(shared->queue[i].event_fd);
+		g_free(shared->queue[i].slots);
+	}
+
+	g_free(shared);
+}
+/**
+ * Create shared ring.
+ *
+ * @param [in]	packet_max_size	Max bytes of packet.
+ * @param [in]	packet_max_num	Number of queuing packet per direction.
+ *
+ * @return struct s_internal_ring_shared*
+ * @retval !NULL Shared ring. Reference count is 2 (primary and not leased secondary).
+ * @retval NULL Resource allocation error.
+ */
+static struct s_internal_ring_shared* internal_ring_shared_new(int packet_max_size, int packet_max_num)
+{
+	struct s_internal_ring_shared *shared = NULL;
+	guint num = 1;
+	size_t slot_size = 0;
+
+	while (num < (guint)packet_max_num && num < (1u << 30))
+		num = num << 1;
+
+	slot_size = sizeof(struct s_internal_ring_slot) + (size_t)packet_max_size;
+	slot_size = (slot_size + 7u) & ~((size_t)7u);
+
+	shared = (struct s_internal_ring_shared*)g_malloc(sizeof(struct s_internal_ring_shared));
+	if (shared == NULL)
+		return NULL;
+	memset(shared,0,sizeof(struct s_internal_ring_shared));
+	shared->queue[0].event_fd = -1;
+	shared->queue[1].event_fd = -1;
+	shared->refcount = 2;
+	shared->packet_max_size = (size_t)packet_max_size;
+
+	for (int i=0; i < 2; i++) {
+		shared->queue[i].mask = num - 1;
+		shared->queue[i].slot_size = slot_size;
+		shared->queue[i].slots = (uint8_t*)g_malloc(slot_size * num);
+		if (shared->queue[i].slots == NULL)
+			goto errorout;
+
+		shared->queue[i].event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (shared->queue[i].event_fd < 0)
+			goto errorout;
+	}
+
+	return shared;
+
+errorout:
+	shared->refcount = 1;
+	internal_ring_shared_unref(shared);
+
+	return NULL;
+}
+/**
+ * Get userdata from internal ring session handle.
+ * The userdata is set at glibhelper_create_internal_ring or glibhelper_bind_secondary_internal_ring.
+ *
+ * @param [in]	handle	Internal ring session handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_internal_ring_get_userdata(glibhelper_internal_session_handle handle)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+
+	if ( handle == NULL)
+		return NULL;
+
+	helper = (struct s_glibhelper_internal_ring*)handle;
+
+	return helper->userdata;
+}
+/**
+ * Read packet from ring using glibhelper_internal_session_handle.
+ * It has same semantics as seq packet socket. When the buffer is smaller than the packet, the packet is truncated.
+ * This function shall be called from the thread of context bound to the handle.
+ *
+ * @param [in]	handle	Internal ring session handle
+ * @param [in]	buf Pointer to read buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >0 Number of bytes read.
+ * @retval 0 Other side was closed.
+ * @retval <0 error (refer to error no). EAGAIN means no packet.
+ */
+ssize_t glibhelper_internal_ring_read(glibhelper_internal_session_handle handle, void *buf, size_t count)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+	struct s_internal_ring_queue *queue = NULL;
+	struct s_internal_ring_slot *slot = NULL;
+	guint head = 0;
+	size_t size = 0;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_internal_ring*)handle;
+	queue = helper->rx;
+
+	head = (guint)g_atomic_int_get(&queue->head);
+	if ((guint)g_atomic_int_get(&queue->tail) == head) {
+		helper->rx_state = GLIBHELPER_RX_DRAINED;
+		if (g_atomic_int_get(&queue->producer_closed) != 0)
+			return 0;
+
+		errno = EAGAIN;
+		return -1;
+	}
+
+	slot = (struct s_internal_ring_slot*)(queue->slots + (queue->slot_size * (head & queue->mask)));
+	size = (slot->size < count) ? slot->size : count;
+
+	if (slot->ptr != NULL) {
+		// Pointer passing packet is read by copy. The object is released here.
+		memcpy(buf, slot->ptr, size);
+		if (slot->release != NULL)
+			slot->release(slot->ptr);
+	} else
+		memcpy(buf, slot->data, size);
+
+	g_atomic_int_set(&queue->head, (gint)(head + 1));	// Release slot to producer
+
+	helper->rx_state = GLIBHELPER_RX_READ;
+
+	return (ssize_t)size;
+}
+/**
+ * Write packet to ring using glibhelper_internal_session_handle.
+ * The other side is woken up by eventfd only when it is idle.
+ * This function shall be called from one thread at a time for each handle.
+ *
+ * @param [in]	handle	Internal ring session handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written.
+ * @retval <0 error (refer to error no). EAGAIN means ring is full, EPIPE means other side was closed.
+ */
+ssize_t glibhelper_internal_ring_write(glibhelper_internal_session_handle handle, void *buf, size_t count)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+	struct s_internal_ring_queue *queue = NULL;
+	struct s_internal_ring_slot *slot = NULL;
+	guint tail = 0;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_internal_ring*)handle;
+	queue = helper->tx;
+
+	if (count > helper->shared->packet_max_size) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+
+	if (g_atomic_int_get(&queue->consumer_closed) != 0) {
+		errno = EPIPE;
+		return -1;
+	}
+
+	tail = (guint)g_atomic_int_get(&queue->tail);
+	if ((tail - (guint)g_atomic_int_get(&queue->head)) > queue->mask) {
+		__atomic_fetch_add(&helper->full, 1, __ATOMIC_RELAXED);
+		errno = EAGAIN;
+		return -1;
+	}
+
+	slot = (struct s_internal_ring_slot*)(queue->slots + (queue->slot_size * (tail & queue->mask)));
+	slot->size = count;
+	slot->ptr = NULL;
+	slot->release = NULL;
+	memcpy(slot->data, buf, count);
+
+	g_atomic_int_set(&queue->tail, (gint)(tail + 1));	// Publish slot to consumer
+
+	// Wake up consumer only when it is idle. Busy consumer finds the packet without syscall.
+	if (g_atomic_int_get(&queue->consumer_idle) != 0) {
+		if (g_atomic_int_compare_and_exchange(&queue->consumer_idle, 1, 0) == TRUE) {
+			internal_ring_wakeup(queue);
+			__atomic_fetch_add(&helper->wakeups, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return (ssize_t)count;
+}
+/**
+ * Read packet by pointer passing from ring using glibhelper_internal_session_handle.
+ * The ownership of the object moves to the caller. The caller shall call release(ptr) after use.
+ * This function shall be called from the thread of context bound to the handle.
+ *
+ * @param [in]	handle	Internal ring session handle
+ * @param [out]	ptr	Pointer to store the object.
+ * @param [out]	release	Pointer to store release callback of the object. It may be NULL.
+ *
+ * @return ssize_t
+ * @retval >0 Number of bytes of the object.
+ * @retval 0 Other side was closed.
+ * @retval <0 error (refer to error no). EAGAIN means no packet, EBADMSG means next packet is not pointer passing packet.
+ */
+ssize_t glibhelper_internal_ring_read_ptr(glibhelper_internal_session_handle handle, void **ptr, fp_release_callback_in *release)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+	struct s_internal_ring_queue *queue = NULL;
+	struct s_internal_ring_slot *slot = NULL;
+	guint head = 0;
+	size_t size = 0;
+
+	if ( handle == NULL || ptr == NULL || release == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_internal_ring*)handle;
+	queue = helper->rx;
+
+	head = (guint)g_atomic_int_get(&queue->head);
+	if ((guint)g_atomic_int_get(&queue->tail) == head) {
+		helper->rx_state = GLIBHELPER_RX_DRAINED;
+		if (g_atomic_int_get(&queue->producer_closed) != 0)
+			return 0;
+
+		errno = EAGAIN;
+		return -1;
+	}
+
+	slot = (struct s_internal_ring_slot*)(queue->slots + (queue->slot_size * (head & queue->mask)));
+	if (slot->ptr == NULL) {
+		errno = EBADMSG;	// Copy packet, use glibhelper_internal_ring_read
+		return -1;
+	}
+
+	(*ptr) = slot->ptr;
+	(*release) = slot->release;
+	size = slot->size;
+
+	g_atomic_int_set(&queue->head, (gint)(head + 1));	// Release slot to producer
+
+	helper->rx_state = GLIBHELPER_RX_READ;
+
+	return (ssize_t)size;
+}
+/**
+ * Write packet by pointer passing to ring using glibhelper_internal_session_handle.
+ * The object is not copied, the ownership of the object moves to the receiver (zero copy).
+ * When the packet is not received until the channel is closed, release(ptr) is called by the library.
+ * This function shall be called from one thread at a time for each handle.
+ *
+ * @param [in]	handle	Internal ring session handle
+ * @param [in]	ptr	Pointer to the object. It shall not be NULL.
+ * @param [in]	counte Number of bytes of the object. It is not limited by packet_max_size.
+ * @param [in]	release	Release callback of the object (ex. g_free). It may be NULL.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes of the object.
+ * @retval <0 error (refer to error no). The ownership of the object is not moved.
+ */
+ssize_t glibhelper_internal_ring_write_ptr(glibhelper_internal_session_handle handle, void *ptr, size_t count, fp_release_callback_in release)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+	struct s_internal_ring_queue *queue = NULL;
+	struct s_internal_ring_slot *slot = NULL;
+	guint tail = 0;
+
+	if ( handle == NULL || ptr == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_internal_ring*)handle;
+	queue = helper->tx;
+
+	if (g_atomic_int_get(&queue->consumer_closed) != 0) {
+		errno = EPIPE;
+		return -1;
+	}
+
+	tail = (guint)g_atomic_int_get(&queue->tail);
+	if ((tail - (guint)g_atomic_int_get(&queue->head)) > queue->mask) {
+		__atomic_fetch_add(&helper->full, 1, __ATOMIC_RELAXED);
+		errno = EAGAIN;
+		return -1;
+	}
+
+	slot = (struct s_internal_ring_slot*)(queue->slots + (queue->slot_size * (tail & queue->mask)));
+	slot->size = count;
+	slot->ptr = ptr;
+	slot->release = release;
+
+	g_atomic_int_set(&queue->tail, (gint)(tail + 1));	// Publish slot to consumer
+
+	// Wake up consumer only when it is idle. Busy consumer finds the packet without syscall.
+	if (g_atomic_int_get(&queue->consumer_idle) != 0) {
+		if (g_atomic_int_compare_and_exchange(&queue->consumer_idle, 1, 0) == TRUE) {
+			internal_ring_wakeup(queue);
+			__atomic_fetch_add(&helper->wakeups, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	return (ssize_t)count;
+}
+//-----------------------------------------------------------------------------
+static void internal_ring_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_internal_ring *helper = (struct s_glibhelper_internal_ring*)userdata;
+
+	glibhelper_stats_print(fd, "  side=%s capacity=%u tx_queued=%u rx_queued=%u wakeups=%lu full=%lu\n",
+			(helper->side == PRIMARY_SIDE) ? "primary" : "secondary", helper->tx->mask + 1,
+			(guint)g_atomic_int_get(&helper->tx->tail) - (guint)g_atomic_int_get(&helper->tx->head),
+			(guint)g_atomic_int_get(&helper->rx->tail) - (guint)g_atomic_int_get(&helper->rx->head),
+			(unsigned long)__atomic_load_n(&helper->wakeups, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&helper->full, __ATOMIC_RELAXED));
+}
+/**
+ * Release internal ring session. It is used by terminate and other side close.
+ *
+ * @param [in]	helper	Internal ring
+ */
+static void internal_ring_release(struct s_glibhelper_internal_ring *helper)
+{
+	glibhelper_stats_unregister(helper->stats_entry);
+
+	// Notify close to other side.
+	g_atomic_int_set(&helper->tx->producer_closed, 1);
+	g_atomic_int_set(&helper->rx->consumer_closed, 1);
+	internal_ring_wakeup(helper->tx);
+
+	g_source_destroy((GSource*)helper->source);
+	g_source_unref((GSource*)helper->source);
+
+	internal_ring_shared_unref(helper->shared);
+	g_free(helper);
+}
+//-----------------------------------------------------------------------------
+static gboolean internal_ring_source_prepare(GSource *source, gint *timeout)
+{
+	struct s_internal_ring_source *ringsource = (struct s_internal_ring_source*)source;
+	struct s_internal_ring_queue *queue = ringsource->helper->rx;
+
+	*timeout = -1;
+
+	if (internal_ring_rx_pending(queue) == TRUE)
+		return TRUE;
+
+	// Going to idle. Producer wakes up by eventfd after this point.
+	g_atomic_int_set(&queue->consumer_idle, 1);
+
+	if (internal_ring_rx_pending(queue) == TRUE) {
+		g_atomic_int_set(&queue->consumer_idle, 0);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean internal_ring_source_check(GSource *source)
+{
+	struct s_internal_ring_source *ringsource = (struct s_internal_ring_source*)source;
+
+	if ((g_source_query_unix_fd(source, ringsource->fd_tag) & G_IO_IN) != 0)
+		return TRUE;
+
+	return internal_ring_rx_pending(ringsource->helper->rx);
+}
+//-----------------------------------------------------------------------------
+static gboolean internal_ring_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	struct s_internal_ring_source *ringsource = (struct s_internal_ring_source*)source;
+	struct s_glibhelper_internal_ring *helper = ringsource->helper;
+	struct s_internal_ring_queue *queue = helper->rx;
+	uint64_t value = 0;
+	uint8_t discard = 0;
+	gboolean bret = TRUE;
+
+	if ((g_source_query_unix_fd(source, ringsource->fd_tag) & G_IO_IN) != 0)
+		(void)read(queue->event_fd, &value, sizeof(value));	// Clear wakeup
+
+	g_atomic_int_set(&queue->consumer_idle, 0);
+
+	for (int i=0; i < helper->receive_budget; i++) {
+		if (g_atomic_int_get(&queue->tail) == g_atomic_int_get(&queue->head))
+			break;
+
+		if (helper->operation.receive == NULL) {
+			(void)glibhelper_internal_ring_read((glibhelper_internal_session_handle)helper, &discard, sizeof(discard));
+			continue;
+		}
+
+		helper->rx_state = GLIBHELPER_RX_NOT_READ;
+		bret = helper->operation.receive((glibhelper_internal_session_handle)helper);
+		if (bret == FALSE)
+			return G_SOURCE_REMOVE;	// When this event return FALSE, this event watch is disabled
+		if (helper->rx_state == GLIBHELPER_RX_NOT_READ)
+			break;
+	}
+
+	if (g_atomic_int_get(&queue->producer_closed) != 0
+		&& g_atomic_int_get(&queue->tail) == g_atomic_int_get(&queue->head)) {
+		// Other side was closed and all packets were received. Cleanup session.
+		if (helper->operation.destroyed_session != NULL)
+			helper->operation.destroyed_session((glibhelper_internal_session_handle)helper);
+
+		if (helper->side == PRIMARY_SIDE) {
+			if (g_atomic_int_compare_and_exchange(&helper->shared->secondary_leased, 0, 1) == TRUE)
+				internal_ring_shared_unref(helper->shared);	// Release reference of not leased secondary
+		}
+
+		internal_ring_release(helper);
+
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static GSourceFuncs internal_ring_source_funcs = {
+	.prepare = internal_ring_source_prepare,
+	.check = internal_ring_source_check,
+	.dispatch = internal_ring_source_dispatch,
+	.finalize = NULL,
+};
+/**
+ * Create internal ring session and attach it to the context.
+ *
+ * @param [in]	shared	Shared ring
+ * @param [in]	side	Side of session
+ * @param [in]	context	Event loop context
+ * @param [in]	config	Internal ring configuration
+ * @param [in]	userdata	User data for callbacks
+ *
+ * @return struct s_glibhelper_internal_ring*
+ * @retval !NULL Internal ring session.
+ * @retval NULL Resource allocation error.
+ */
+static struct s_glibhelper_internal_ring* internal_ring_new(struct s_internal_ring_shared *shared, enum internal_ring_side side,
+	GMainContext *context, glibhelper_internal_ring_config *config, void* userdata)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+	struct s_internal_ring_source *ringsource = NULL;
+
+	helper = (struct s_glibhelper_internal_ring*)g_malloc(sizeof(struct s_glibhelper_internal_ring));
+	if (helper == NULL)
+		return NULL;
+	memset(helper,0,sizeof(struct s_glibhelper_internal_ring));
+
+	helper->shared = shared;
+	helper->side = side;
+	helper->tx = &shared->queue[side];
+	helper->rx = &shared->queue[(side == PRIMARY_SIDE) ? SECOUNDARY_SIDE : PRIMARY_SIDE];
+	helper->operation = config->operation;
+	helper->context = context;
+	helper->userdata = userdata;
+	helper->receive_budget = (config->receive_budget > 0) ? config->receive_budget : INTERNAL_RING_BUDGET_DEFAULT;
+
+	ringsource = (struct s_internal_ring_source*)g_source_new(&internal_ring_source_funcs, sizeof(struct s_internal_ring_source));
+	if (ringsource == NULL) {
+		g_free(helper);
+		return NULL;
+	}
+
+	ringsource->helper = helper;
+	ringsource->fd_tag = g_source_add_unix_fd((GSource*)ringsource, helper->rx->event_fd, G_IO_IN);
+	helper->source = ringsource;	// Keep reference until terminate
+
+	(void)g_source_attach((GSource*)ringsource, context);
+
+	helper->stats_entry = glibhelper_stats_register("internal_ring", internal_ring_stats_dump, helper);
+
+	return helper;
+}
+/**
+ * Create primary side of internal ring channel.
+ * It is an in-process replacement of glibhelper_create_internal_socket. Packets are copied into
+ * a lock-free single producer single consumer ring, and eventfd wakeup is used only when the other side is idle.
+ *
+ * @param [in]	handle	Pointer to store created internal ring handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Internal ring configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_internal_ring(glibhelper_internal_ring *handle, GMainContext *context, glibhelper_internal_ring_config *config, void* userdata)
+{
+	struct s_internal_ring_shared *shared = NULL;
+	struct s_glibhelper_internal_ring *helper = NULL;
+
+	if (handle == NULL || config == NULL)
+		return FALSE;
+
+	if (config->packet_max_size <= 0 || config->packet_max_num <= 0)
+		return FALSE;
+
+	shared = internal_ring_shared_new(config->packet_max_size, config->packet_max_num);
+	if (shared == NULL)
+		return FALSE;
+
+	helper = internal_ring_new(shared, PRIMARY_SIDE, context, config, userdata);
+	if (helper == NULL) {
+		shared->refcount = 1;
+		internal_ring_shared_unref(shared);
+		return FALSE;
+	}
+
+	(*handle) = (glibhelper_internal_ring)(helper);
+
+	return TRUE;
+}
+/**
+ * Bind secondary side of internal ring channel to the context.
+ * The packet_max_size and packet_max_num of config are ignored, they are decided by primary side.
+ *
+ * @param [in]	secondary_handle	Pointer to store created internal ring handle.
+ * @param [in]	primary_handle	Primary side handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Internal ring configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, already bound or resource allocation error.
+ */
+gboolean glibhelper_bind_secondary_internal_ring(glibhelper_internal_ring *secondary_handle, glibhelper_internal_ring primary_handle,
+	GMainContext *context, glibhelper_internal_ring_config *config, void* userdata)
+{
+	struct s_glibhelper_internal_ring *primary_helper = NULL;
+	struct s_glibhelper_internal_ring *secondary_helper = NULL;
+
+	if (secondary_handle == NULL || primary_handle == NULL || config == NULL)
+		return FALSE;
+
+	primary_helper = (struct s_glibhelper_internal_ring*)primary_handle;
+
+	if (primary_helper->side != PRIMARY_SIDE)
+		return FALSE;
+
+	if (g_atomic_int_compare_and_exchange(&primary_helper->shared->secondary_leased, 0, 1) == FALSE)
+		return FALSE;
+
+	secondary_helper = internal_ring_new(primary_helper->shared, SECOUNDARY_SIDE, context, config, userdata);
+	if (secondary_helper == NULL) {
+		g_atomic_int_set(&primary_helper->shared->secondary_leased, 0);
+		return FALSE;
+	}
+
+	(*secondary_handle) = (glibhelper_internal_ring)(secondary_helper);
+
+	return TRUE;
+}
+/**
+ * Terminate internal ring session. The other side detects close after it receives all queued packets.
+ * Do not call this function in callbacks of the same handle, and after destroyed_session callback.
+ *
+ * @param [in]	handle	Internal ring handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_internal_ring(glibhelper_internal_ring handle)
+{
+	struct s_glibhelper_internal_ring *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_internal_ring*)handle;
+
+	if (helper->side == PRIMARY_SIDE) {
+		if (g_atomic_int_compare_and_exchange(&helper->shared->secondary_leased, 0, 1) == TRUE)
+			internal_ring_shared_unref(helper->shared);	// Release reference of not leased secondary
+	}
+
+	internal_ring_release(helper);
+
+	return TRUE;
+}
@@ -0,0 +1,41 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-internal-ring.h
+ * @brief	header for glibhelper-internal-ring
+ */
+#ifndef GLIBHELPER_INTERNAL_RING_H
+#define GLIBHELPER_INTERNAL_RING_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "glibhelper-unix-socket-support.h"
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_internal_ring;
+typedef struct s_glibhelper_internal_ring *glibhelper_internal_ring;
+
+typedef void (*fp_release_callback_in)(void *ptr);
+
+/** glibhelper_internal_ring_config.*/
+typedef struct s_glibhelper_internal_ring_config {
+	struct s_glibhelper_internal_socket_operation operation; /**< internal channel event handler. Same as internal socket. */
+	int packet_max_size; /**< max bytes of packet. Primary side only. */
+	int packet_max_num; /**< number of queuing packet per direction, round up to power of 2. Primary side only. */
+	int receive_budget; /**< max receive callbacks per dispatch. 0 = default (64). */
+} glibhelper_internal_ring_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_internal_ring(glibhelper_internal_ring *handle, GMainContext *context, glibhelper_internal_ring_config *config, void* userdata);
+gboolean glibhelper_bind_secondary_internal_ring(glibhelper_internal_ring *secondary_handle, glibhelper_internal_ring primary_handle, 
+	GMainContext *context, glibhelper_internal_ring_config *config, void* userdata);
+gboolean glibhelper_terminate_internal_ring(glibhelper_internal_ring handle);
+void* glibhelper_internal_ring_get_userdata(glibhelper_internal_session_handle handle);
+ssize_t glibhelper_internal_ring_read(glibhelper_internal_session_handle handle, void *buf, size_t count);
+ssize_t glibhelper_internal_ring_write(glibhelper_internal_session_handle handle, void *buf, size_t count);
+ssize_t glibhelper_internal_ring_read_ptr(glibhelper_internal_session_handle handle, void **ptr, fp_release_callback_in *release);
+ssize_t glibhelper_internal_ring_write_ptr(glibhelper_internal_session_handle handle, void *ptr, size_t count, fp_release_callback_in release);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_INTERNAL_RING_H
@@ -0,0 +1,475 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-invoker.c
+ * @brief	batched cross context function call for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+#include "glibhelper-invoker.h"
+#include "glibhelper-stats.h"
+
+#define INVOKER_BUDGET_DEFAULT (256)
+#define INVOKER_POOL_DEFAULT (1024)
+
+struct s_invoker_closure {
+	struct s_invoker_closure *next;
+	fp_invoke_callback func;
+	fp_invoke_release_callback release;
+	void *data;
+	guint32 free_next;	// Atomic, pool index + 1 of next free closure. 0 is end of free list.
+	gboolean pooled;
+};
+
+struct s_invoker_source {
+	GSource source;
+	struct s_glibhelper_invoker *invoker;
+	gpointer fd_tag;
+};
+
+struct s_glibhelper_invoker {
+	struct s_invoker_closure *posted;	// Lock-free LIFO stack, pushed by any thread
+	struct s_invoker_closure *pending;	// FIFO list taken from posted, owned by target context
+	struct s_invoker_closure *pending_tail;
+	struct s_invoker_source *source;
+	GMainContext *context;
+	struct s_invoker_closure *pool;	// Preallocated closures
+	guint64 free_head;	// Atomic, (tag << 32) | (pool index + 1). Tag protects pop from ABA problem.
+	int event_fd;
+	int invoke_budget;
+	guint32 pool_size;
+	gint wakeup_pending;	// Atomic, eventfd was written and not yet consumed by dispatch.
+	gint wakeup_count;	// Atomic
+	gint pool_miss_count;	// Atomic
+	glibhelper_stats_entry stats_entry;
+};
+/**
+ * Get closure from free list of pool. When pool is exhausted, closure is allocated from heap.
+ * This function is thread safe.
+ *
+ * @param [in]	invoker	Invoker
+ *
+ * @return struct s_invoker_closure*
+ * @retval !NULL Closure.
+ * @retval NULL Resource allocation error.
+ */
+static struct s_invoker_closure* invoker_closure_get(struct s_glibhelper_invoker *invoker)
+{
+	struct s_invoker_closure *closure = NULL;
+	guint64 head = 0;
+	guint64 next = 0;
+	guint32 index = 0;
+
+	head = __atomic_load_n(&invoker->free_head, __ATOMIC_ACQUIRE);
+	do {
+		index = (guint32)head;
+		if (index == 0)
+			break;
+		// free_next may be stale when other thread popped it, then tag mismatch fails the CAS.
+		next = (((head >> 32) + 1) << 32) | (guint64)__atomic_load_n(&invoker->pool[index - 1].free_next, __ATOMIC_RELAXED);
+	} while (__atomic_compare_exchange_n(&invoker->free_head, &head, next, TRUE, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) == FALSE);
+
+	if (index != 0)
+		return &invoker->pool[index - 1];
+
+	closure = (struct s_invoker_closure*)g_malloc(sizeof(struct s_invoker_closure));
+	if (closure == NULL)
+		return NULL;
+	closure->free_next = 0;
+	closure->pooled = FALSE;
+	g_atomic_int_inc(&invoker->pool_miss_count);
+
+	return closure;
+}
+/**
+ * Return chain of pooled closures to free list. Only target context (or terminate) calls this function.
+ *
+ * @param [in]	invoker	Invoker
+ * @param [in]	first	Pool index + 1 of first closure of chain.
+ * @param [in]	last	Pool index + 1 of last closure of chain.
+ */
+static void invoker_closure_put_chain(struct s_glibhelper_invoker *invoker, guint32 first, guint32 last)
+{
+	guint64 head = 0;
+	guint64 next = 0;
+
+	head = __atomic_load_n(&invoker->free_head, __ATOMIC_RELAXED);
+	do {
+		__atomic_store_n(&invoker->pool[last - 1].free_next, (guint32)head, __ATOMIC_RELAXED);
+		next = (((head >> 32) + 1) << 32) | (guint64)first;
+	} while (__atomic_compare_exchange_n(&invoker->free_head, &head, next, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED) == FALSE);
+}
+/**
+ * Release closure after call. Pooled closure is linked to chain, it is returned to free list by invoker_closure_put_chain.
+ *
+ * @param [in]	invoker	Invoker
+ * @param [in]	closure	Closure
+ * @param [in,out]	first	Pool index + 1 of first closure of chain. 0 is empty chain.
+ * @param [in,out]	last	Pool index + 1 of last closure of chain.
+ */
+static void invoker_closure_free(struct s_glibhelper_invoker *invoker, struct s_invoker_closure *closure, guint32 *first, guint32 *last)
+{
+	guint32 index = 0;
+
+	if (closure->pooled == FALSE) {
+		g_free(closure);
+		return;
+	}
+
+	index = (guint32)(closure - invoker->pool) + 1;
+	__atomic_store_n(&closure->free_next, (*first), __ATOMIC_RELAXED);
+	if ((*first) == 0)
+		(*last) = index;
+	(*first) = index;
+}
+/**
+ * Take all posted closures and reverse them to post order.
+ *
+ * @param [in]	invoker	Invoker
+ * @param [out]	tail	Pointer to store last closure of list.
+ *
+ * @return struct s_invoker_closure*
+ * @retval !NULL FIFO list of closures.
+ * @retval NULL No closure.
+ */
+static struct s_invoker_closure* invoker_take(struct s_glibhelper_invoker *invoker, struct s_invoker_closure **tail)
+{
+	struct s_invoker_closure *list = NULL;
+	struct s_invoker_closure *fifo = NULL;
+	struct s_invoker_closure *next = NULL;
+
+	// Only push and take-all are used, so this stack is free from ABA problem.
+	do {
+		list = (struct s_invoker_closure*)g_atomic_pointer_get(&invoker->posted);
+		if (list == NULL)
+			return NULL;
+	} while (g_atomic_pointer_compare_and_exchange(&invoker->posted, list, NULL) == FALSE);
+
+	(*tail) = list;	// Newest closure becomes tail of FIFO
+	while (list != NULL) {
+		next = list->next;
+		list->next = fifo;
+		fifo = list;
+		list = next;
+	}
+
+	return fifo;
+}
+/**
+ * Check pending closures of invoker.
+ *
+ * @param [in]	invoker	Invoker
+ *
+ * @return gboolean
+ * @retval TRUE Some closures are queued.
+ * @retval FALSE No closure.
+ */
+static gboolean invoker_pending(struct s_glibhelper_invoker *invoker)
+{
+	if (invoker->pending != NULL)
+		return TRUE;
+
+	if (g_atomic_pointer_get(&invoker->posted) != NULL)
+		return TRUE;
+
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean invoker_source_prepare(GSource *source, gint *timeout)
+{
+	struct s_invoker_source *invsource = (struct s_invoker_source*)source;
+
+	*timeout = -1;
+
+	return invoker_pending(invsource->invoker);
+}
+//-----------------------------------------------------------------------------
+static gboolean invoker_source_check(GSource *source)
+{
+	struct s_invoker_source *invsource = (struct s_invoker_source*)source;
+
+	if ((g_source_query_unix_fd(source, invsource->fd_tag) & G_IO_IN) != 0)
+		return TRUE;
+
+	return invoker_pending(invsource->invoker);
+}
+//-----------------------------------------------------------------------------
+static gboolean invoker_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	struct s_invoker_source *invsource = (struct s_invoker_source*)source;
+	struct s_glibhelper_invoker *invoker = invsource->invoker;
+	struct s_invoker_closure *closure = NULL;
+	struct s_invoker_closure *list = NULL;
+	struct s_invoker_closure *tail = NULL;
+	guint32 free_first = 0;
+	guint32 free_last = 0;
+	uint64_t value = 0;
+
+	if ((g_source_query_unix_fd(source, invsource->fd_tag) & G_IO_IN) != 0)
+		(void)read(invoker->event_fd, &value, sizeof(value));	// Clear wakeup
+
+	// Clear before take. A post after this point sees no pending wakeup and writes eventfd again.
+	g_atomic_int_set(&invoker->wakeup_pending, 0);
+
+	// Keep post order, new closures go after the remaining ones.
+	list = invoker_take(invoker, &tail);
+	if (list != NULL) {
+		if (invoker->pending == NULL)
+			invoker->pending = list;
+		else
+			invoker->pending_tail->next = list;
+		invoker->pending_tail = tail;
+	}
+
+	for (int i=0; i < invoker->invoke_budget; i++) {
+		closure = invoker->pending;
+		if (closure == NULL)
+			break;
+		invoker->pending = closure->next;
+
+		closure->func(closure->data);
+		invoker_closure_free(invoker, closure, &free_first, &free_last);
+	}
+
+	if (free_first != 0)
+		invoker_closure_put_chain(invoker, free_first, free_last);
+
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static void invoker_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_invoker *invoker = (struct s_glibhelper_invoker*)userdata;
+
+	glibhelper_stats_print(fd, "  wakeups=%u pool_misses=%u posted_empty=%d\n", (guint)g_atomic_int_get(&invoker->wakeup_count),
+			(guint)g_atomic_int_get(&invoker->pool_miss_count), (g_atomic_pointer_get(&invoker->posted) == NULL) ? 1 : 0);
+}
+//-----------------------------------------------------------------------------
+static GSourceFuncs invoker_source_funcs = {
+	.prepare = invoker_source_prepare,
+	.check = invoker_source_check,
+	.dispatch = invoker_source_dispatch,
+	.finalize = NULL,
+};
+/**
+ * Release closure that was not called.
+ *
+ * @param [in]	closure	Closure
+ */
+static void invoker_discard(struct s_invoker_closure *closure)
+{
+	if (closure->release != NULL)
+		closure->release(closure->data);
+
+	if (closure->pooled == FALSE)
+		g_free(closure);
+}
+/**
+ * Post function call to the context of invoker. This function is thread safe.
+ * Unlike g_main_context_invoke, no GSource is created and no memory is allocated per call (closures come from
+ * preallocated pool), and the target context is woken up only when no wakeup is pending. Many posts in one loop
+ * iteration cost one wakeup.
+ * The functions are called in post order (per posting thread).
+ *
+ * @param [in]	handle	Invoker handle
+ * @param [in]	func	Function to call in the context of invoker.
+ * @param [in]	data	Argument of the function.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_invoker_post(glibhelper_invoker handle, fp_invoke_callback func, void *data)
+{
+	return glibhelper_invoker_post_full(handle, func, data, NULL);
+}
+/**
+ * Post function call to the context of invoker with release callback. This function is thread safe.
+ * The release callback is called instead of func when the invoker is terminated before the call.
+ *
+ * @param [in]	handle	Invoker handle
+ * @param [in]	func	Function to call in the context of invoker.
+ * @param [in]	data	Argument of the function.
+ * @param [in]	release	Function to release data of not called closure. It may be NULL.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_invoker_post_full(glibhelper_invoker handle, fp_invoke_callback func, void *data, fp_invoke_release_callback release)
+{
+	struct s_glibhelper_invoker *invoker = NULL;
+	struct s_invoker_closure *closure = NULL;
+	struct s_invoker_closure *head = NULL;
+	uint64_t value = 1;
+	ssize_t ret = -1;
+
+	if (handle == NULL || func == NULL)
+		return FALSE;
+
+	invoker = (struct s_glibhelper_invoker*)handle;
+
+	closure = invoker_closure_get(invoker);
+	if (closure == NULL)
+		return FALSE;
+	closure->func = func;
+	closure->release = release;
+	closure->data = data;
+
+	do {
+		head = (struct s_invoker_closure*)g_atomic_pointer_get(&invoker->posted);
+		closure->next = head;
+	} while (g_atomic_pointer_compare_and_exchange(&invoker->posted, head, closure) == FALSE);
+
+	// Only first poster after dispatch writes eventfd. Other posters rely on this wakeup.
+	if (g_atomic_int_get(&invoker->wakeup_pending) == 0
+			&& g_atomic_int_compare_and_exchange(&invoker->wakeup_pending, 0, 1) == TRUE) {
+		do {
+			ret = write(invoker->event_fd, &value, sizeof(value));
+		} while((ret == -1) && (errno == EINTR));
+		g_atomic_int_inc(&invoker->wakeup_count);
+	}
+
+	return TRUE;
+}
+/**
+ * Get number of wakeups of the target context by this invoker. It wraps around at 2^32.
+ *
+ * @param [in]	handle	Invoker handle
+ *
+ * @return guint
+ * @retval >=0 Number of wakeups.
+ */
+guint glibhelper_invoker_get_wakeup_count(glibhelper_invoker handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return (guint)g_atomic_int_get(&((struct s_glibhelper_invoker*)handle)->wakeup_count);
+}
+/**
+ * Create invoker. The posted functions are called in the context.
+ *
+ * @param [in]	handle	Pointer to store created invoker handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Invoker configuration. NULL is default configuration.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_invoker(glibhelper_invoker *handle, GMainContext *context, glibhelper_invoker_config *config)
+{
+	struct s_glibhelper_invoker *invoker = NULL;
+	struct s_invoker_source *invsource = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	invoker = (struct s_glibhelper_invoker*)g_malloc(sizeof(struct s_glibhelper_invoker));
+	if (invoker == NULL)
+		return FALSE;
+	memset(invoker,0,sizeof(struct s_glibhelper_invoker));
+
+	invoker->context = context;
+	invoker->invoke_budget = INVOKER_BUDGET_DEFAULT;
+	if (config != NULL && config->invoke_budget > 0)
+		invoker->invoke_budget = config->invoke_budget;
+
+	invoker->event_fd = -1;
+	invoker->pool_size = INVOKER_POOL_DEFAULT;
+	if (config != NULL && config->pool_size > 0)
+		invoker->pool_size = (guint32)config->pool_size;
+
+	invoker->pool = (struct s_invoker_closure*)g_malloc(sizeof(struct s_invoker_closure) * invoker->pool_size);
+	if (invoker->pool == NULL)
+		goto errorout;
+	memset(invoker->pool,0,sizeof(struct s_invoker_closure) * invoker->pool_size);
+
+	for (guint32 i=0; i < invoker->pool_size; i++) {
+		invoker->pool[i].pooled = TRUE;
+		invoker->pool[i].free_next = (i + 1 < invoker->pool_size) ? (i + 2) : 0;
+	}
+	invoker->free_head = 1;
+
+	invoker->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (invoker->event_fd < 0)
+		goto errorout;
+
+	invsource = (struct s_invoker_source*)g_source_new(&invoker_source_funcs, sizeof(struct s_invoker_source));
+	if (invsource == NULL)
+		goto errorout;
+
+	invsource->invoker = invoker;
+	invsource->fd_tag = g_source_add_unix_fd((GSource*)invsource, invoker->event_fd, G_IO_IN);
+	invoker->source = invsource;
+
+	(void)g_source_attach((GSource*)invsource, context);
+
+	invoker->stats_entry = glibhelper_stats_register("invoker", invoker_stats_dump, invoker);
+
+	(*handle) = (glibhelper_invoker)(invoker);
+
+	return TRUE;
+
+errorout:
+	if (invoker->event_fd >= 0)
+		(void)close(invoker->event_fd);
+	g_free(invoker->pool);
+	g_free(invoker);
+
+	return FALSE;
+}
+/**
+ * Terminate invoker. The functions not yet called are discarded and their release callbacks are called.
+ * Call this function after all posting threads stopped to post.
+ *
+ * @param [in]	handle	Invoker handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_invoker(glibhelper_invoker handle)
+{
+	struct s_glibhelper_invoker *invoker = NULL;
+	struct s_invoker_closure *closure = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	invoker = (struct s_glibhelper_invoker*)handle;
+
+	glibhelper_stats_unregister(invoker->stats_entry);
+
+	g_source_destroy((GSource*)invoker->source);
+	g_source_unref((GSource*)invoker->source);
+
+	while (invoker->pending != NULL) {
+		closure = invoker->pending;
+		invoker->pending = closure->next;
+		invoker_discard(closure);
+	}
+
+	closure = invoker_take(invoker, &invoker->pending_tail);
+	while (closure != NULL) {
+		invoker->pending = closure->next;
+		invoker_discard(closure);
+		closure = invoker->pending;
+	}
+
+	(void)close(invoker->event_fd);
+	g_free(invoker->pool);
+	g_free(invoker);
+
+	return TRUE;
+}
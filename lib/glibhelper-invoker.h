@@ -0,0 +1,34 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-invoker.h
+ * @brief	header for glibhelper-invoker
+ */
+#ifndef GLIBHELPER_INVOKER_H
+#define GLIBHELPER_INVOKER_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_invoker;
+typedef struct s_glibhelper_invoker *glibhelper_invoker;
+
+typedef void (*fp_invoke_callback)(void *data);
+typedef void (*fp_invoke_release_callback)(void *data);
+
+/** glibhelper_invoker_config.*/
+typedef struct s_glibhelper_invoker_config {
+	int invoke_budget; /**< max closure calls per dispatch. 0 = default (256). */
+	int pool_size; /**< number of preallocated closures. Posts beyond it allocate from heap. 0 = default (1024). */
+} glibhelper_invoker_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_invoker(glibhelper_invoker *handle, GMainContext *context, glibhelper_invoker_config *config);
+gboolean glibhelper_terminate_invoker(glibhelper_invoker handle);
+gboolean glibhelper_invoker_post(glibhelper_invoker handle, fp_invoke_callback func, void *data);
+gboolean glibhelper_invoker_post_full(glibhelper_invoker handle, fp_invoke_callback func, void *data, fp_invoke_release_callback release);
+guint glibhelper_invoker_get_wakeup_count(glibhelper_invoker handle);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_INVOKER_H
@@ -0,0 +1,357 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-loop-monitor.c
+ * @brief	lag and load monitor for glib event loop context
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "glibhelper-loop-monitor.h"
+#include "glibhelper-timerfd-support.h"
+#include "glibhelper-stats.h"
+
+#define LOOP_MONITOR_INTERVAL_DEFAULT (100 * 1000 * 1000)	// 100ms
+#define LOOP_MONITOR_THRESHOLD_DEFAULT (10 * 1000 * 1000)	// 10ms
+
+struct s_loop_monitor_source {
+	GSource source;
+	struct s_glibhelper_loop_monitor *monitor;
+};
+
+struct s_glibhelper_loop_monitor {
+	struct s_glibhelper_loop_monitor_operation operation;
+	GMainContext *context;
+	void *userdata;
+	uint64_t threshold;	// ns
+	uint64_t interval;	// Probe interval (ns)
+	glibhelper_timerfd_support_handle probe;	// Periodic timer, its lateness is the lag
+	struct s_loop_monitor_source *source;	// Marks start of each iteration
+	GPollFunc poll_func;	// Original poll function of the context
+	uint64_t poll_return;	// Time when poll returned in current iteration (ns). 0 = not yet.
+	gint overloaded;
+	uint64_t lag;	// Latest lag (ns)
+	glibhelper_histogram lag_histogram;
+	glibhelper_loop_monitor_stats stats;	// Written by monitored context only, lag is in lag_histogram
+	glibhelper_stats_entry stats_entry;
+};
+
+// Monitor of the iteration running in this thread. Set at prepare, used by poll function of the same iteration.
+static GPrivate loop_monitor_current = G_PRIVATE_INIT(NULL);
+//-----------------------------------------------------------------------------
+static uint64_t loop_monitor_clock(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+/**
+ * Poll function of monitored context. It counts ready fds of the iteration and records the end of poll.
+ *
+ * @param [in]	ufds	Poll fds
+ * @param [in]	nfsd	Number of poll fds
+ * @param [in]	timeout_	Timeout (ms)
+ *
+ * @return gint
+ * @retval >=0 Number of ready fds.
+ * @retval <0 Error.
+ */
+static gint loop_monitor_poll(GPollFD *ufds, guint nfsd, gint timeout_)
+{
+	struct s_glibhelper_loop_monitor *monitor = (struct s_glibhelper_loop_monitor*)g_private_get(&loop_monitor_current);
+	gint ret = 0;
+	guint64 ready = 0;
+
+	if (monitor == NULL)
+		return g_poll(ufds, nfsd, timeout_);
+
+	g_private_set(&loop_monitor_current, NULL);
+	ret = monitor->poll_func(ufds, nfsd, timeout_);
+	monitor->poll_return = loop_monitor_clock();
+
+	if (ret > 0) {
+		for (guint i=0; i < nfsd; i++) {
+			if (ufds[i].revents != 0)
+				ready++;
+		}
+		monitor->stats.ready += ready;
+		if (ready > monitor->stats.max_ready)
+			monitor->stats.max_ready = ready;
+	}
+
+	return ret;
+}
+//-----------------------------------------------------------------------------
+static gboolean loop_monitor_source_prepare(GSource *source, gint *timeout)
+{
+	struct s_glibhelper_loop_monitor *monitor = ((struct s_loop_monitor_source*)source)->monitor;
+
+	// Dispatch of previous iteration finished.
+	if (monitor->poll_return != 0)
+		monitor->stats.busy_time += loop_monitor_clock() - monitor->poll_return;
+	monitor->poll_return = 0;
+	monitor->stats.iterations++;
+	g_private_set(&loop_monitor_current, monitor);
+
+	*timeout = -1;
+
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean loop_monitor_source_check(GSource *source)
+{
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+static gboolean loop_monitor_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static GSourceFuncs loop_monitor_source_funcs = {
+	.prepare = loop_monitor_source_prepare,
+	.check = loop_monitor_source_check,
+	.dispatch = loop_monitor_source_dispatch,
+	.finalize = NULL,
+};
+/**
+ * Lag probe. The lateness of the periodic timer is the time the context was busy with other sources.
+ * A stall longer than the interval shows up as missed expirations, each of them adds one interval to the lag.
+ *
+ * @param [in]	handle	Probe timer
+ * @param [in]	info	Expiration information
+ *
+ * @return gboolean
+ * @retval TRUE Continue probe.
+ */
+static gboolean loop_monitor_probe_cb(glibhelper_timerfd_support_handle handle, const glibhelper_timerfd_info *info)
+{
+	struct s_glibhelper_loop_monitor *monitor = (struct s_glibhelper_loop_monitor*)glibhelper_timerfd_get_userdata(handle);
+	uint64_t lag = (info->lateness > 0) ? (uint64_t)info->lateness : 0;
+
+	if (info->expirations > 1)
+		lag += (info->expirations - 1) * monitor->interval;
+
+	__atomic_store_n(&monitor->lag, lag, __ATOMIC_RELAXED);
+	glibhelper_histogram_record(monitor->lag_histogram, lag);
+	monitor->stats.probes++;
+
+	// Hysteresis: enter overload above threshold, leave below half of it.
+	if (g_atomic_int_get(&monitor->overloaded) == 0 && lag > monitor->threshold) {
+		g_atomic_int_set(&monitor->overloaded, 1);
+		monitor->stats.overloads++;
+		if (monitor->operation.overload != NULL)
+			monitor->operation.overload(monitor, TRUE, lag);
+	} else if (g_atomic_int_get(&monitor->overloaded) != 0 && lag < monitor->threshold / 2) {
+		g_atomic_int_set(&monitor->overloaded, 0);
+		if (monitor->operation.overload != NULL)
+			monitor->operation.overload(monitor, FALSE, lag);
+	}
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void loop_monitor_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_loop_monitor *monitor = (struct s_glibhelper_loop_monitor*)userdata;
+	glibhelper_loop_monitor_stats stats;
+
+	(void)glibhelper_loop_monitor_get_stats(monitor, &stats);
+	glibhelper_stats_print(fd, "  overloaded=%d probes=%lu overloads=%lu iterations=%lu ready=%lu max_ready=%lu busy_time=%lu\n",
+			g_atomic_int_get(&monitor->overloaded), (unsigned long)stats.probes, (unsigned long)stats.overloads,
+			(unsigned long)stats.iterations, (unsigned long)stats.ready, (unsigned long)stats.max_ready,
+			(unsigned long)stats.busy_time);
+	glibhelper_stats_print_histogram(fd, "lag", monitor->lag_histogram);
+}
+/**
+ * Get userdata from loop monitor handle.
+ * The userdata is set at glibhelper_create_loop_monitor.
+ *
+ * @param [in]	handle	Loop monitor handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_loop_monitor_get_userdata(glibhelper_loop_monitor handle)
+{
+	if (handle == NULL)
+		return NULL;
+
+	return ((struct s_glibhelper_loop_monitor*)handle)->userdata;
+}
+/**
+ * Get overload state. This function is thread safe, it can be used for load shedding in other contexts.
+ *
+ * @param [in]	handle	Loop monitor handle
+ *
+ * @return gboolean
+ * @retval TRUE Overloaded.
+ * @retval FALSE Not overloaded or arg error.
+ */
+gboolean glibhelper_loop_monitor_is_overloaded(glibhelper_loop_monitor handle)
+{
+	if (handle == NULL)
+		return FALSE;
+
+	return (g_atomic_int_get(&((struct s_glibhelper_loop_monitor*)handle)->overloaded) != 0) ? TRUE : FALSE;
+}
+/**
+ * Get latest lag. This function is thread safe.
+ *
+ * @param [in]	handle	Loop monitor handle
+ *
+ * @return uint64_t
+ * @retval >=0 Lag of latest probe (ns). 0 = arg error.
+ */
+uint64_t glibhelper_loop_monitor_get_lag(glibhelper_loop_monitor handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return __atomic_load_n(&((struct s_glibhelper_loop_monitor*)handle)->lag, __ATOMIC_RELAXED);
+}
+/**
+ * Get monitor statistics. The counters are updated by the monitored context without lock,
+ * the values are approximate when this function is called from other thread.
+ *
+ * @param [in]	handle	Loop monitor handle
+ * @param [out]	stats	Pointer to store statistics.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_loop_monitor_get_stats(glibhelper_loop_monitor handle, glibhelper_loop_monitor_stats *stats)
+{
+	struct s_glibhelper_loop_monitor *monitor = NULL;
+
+	if (handle == NULL || stats == NULL)
+		return FALSE;
+
+	monitor = (struct s_glibhelper_loop_monitor*)handle;
+
+	(*stats) = monitor->stats;
+	if (glibhelper_histogram_get_stats(monitor->lag_histogram, &stats->lag) != TRUE)
+		memset(&stats->lag, 0, sizeof(stats->lag));
+
+	return TRUE;
+}
+/**
+ * Create loop monitor and attach it to the context. One monitor can be attached to a context.
+ * The poll function of the context is replaced to count ready fds per iteration.
+ *
+ * @param [in]	handle	Pointer to store created loop monitor handle.
+ * @param [in]	context	Monitored event loop context. NULL is default context.
+ * @param [in]	config	Loop monitor configuration. NULL is default configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_loop_monitor(glibhelper_loop_monitor *handle, GMainContext *context, glibhelper_loop_monitor_config *config, void *userdata)
+{
+	struct s_glibhelper_loop_monitor *monitor = NULL;
+	glibhelper_timerfd_config tcfg;
+
+	if (handle == NULL)
+		return FALSE;
+
+	monitor = (struct s_glibhelper_loop_monitor*)g_malloc(sizeof(struct s_glibhelper_loop_monitor));
+	if (monitor == NULL)
+		return FALSE;
+	memset(monitor,0,sizeof(struct s_glibhelper_loop_monitor));
+
+	memset(&tcfg, 0, sizeof(tcfg));
+	tcfg.interval = LOOP_MONITOR_INTERVAL_DEFAULT;
+	monitor->threshold = LOOP_MONITOR_THRESHOLD_DEFAULT;
+	if (config != NULL) {
+		monitor->operation = config->operation;
+		if (config->interval > 0)
+			tcfg.interval = config->interval;
+		if (config->threshold > 0)
+			monitor->threshold = config->threshold;
+	}
+	tcfg.initial_delay = tcfg.interval;
+	monitor->interval = tcfg.interval;
+	tcfg.operation.timeout_ex = loop_monitor_probe_cb;
+	monitor->context = context;
+	monitor->userdata = userdata;
+
+	if (glibhelper_create_histogram(&monitor->lag_histogram) != TRUE)
+		goto errorout;
+
+	if (glibhelper_create_timerfd(&monitor->probe, context, &tcfg, monitor) != TRUE)
+		goto errorout;
+
+	monitor->source = (struct s_loop_monitor_source*)g_source_new(&loop_monitor_source_funcs, sizeof(struct s_loop_monitor_source));
+	if (monitor->source == NULL)
+		goto errorout;
+	monitor->source->monitor = monitor;
+	g_source_set_priority((GSource*)monitor->source, G_PRIORITY_HIGH);	// Prepared in every iteration
+	(void)g_source_attach((GSource*)monitor->source, context);	// Keep reference until terminate
+
+	monitor->poll_func = g_main_context_get_poll_func(context);
+	g_main_context_set_poll_func(context, loop_monitor_poll);
+
+	monitor->stats_entry = glibhelper_stats_register("loop_monitor", loop_monitor_stats_dump, monitor);
+
+	(*handle) = (glibhelper_loop_monitor)(monitor);
+
+	return TRUE;
+
+errorout:
+	if (monitor->probe != NULL)
+		(void)glibhelper_terminate_timerfd(monitor->probe);
+
+	if (monitor->lag_histogram != NULL)
+		(void)glibhelper_terminate_histogram(monitor->lag_histogram);
+
+	g_free(monitor);
+
+	return FALSE;
+}
+/**
+ * Terminate loop monitor. The poll function of the context is restored.
+ * Call it in the monitored context or after the loop of the context stopped.
+ *
+ * @param [in]	handle	Loop monitor handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_loop_monitor(glibhelper_loop_monitor handle)
+{
+	struct s_glibhelper_loop_monitor *monitor = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	monitor = (struct s_glibhelper_loop_monitor*)handle;
+
+	glibhelper_stats_unregister(monitor->stats_entry);
+
+	g_main_context_set_poll_func(monitor->context, monitor->poll_func);
+	g_private_set(&loop_monitor_current, NULL);
+
+	g_source_destroy((GSource*)monitor->source);
+	g_source_unref((GSource*)monitor->source);
+
+	(void)glibhelper_terminate_timerfd(monitor->probe);
+	(void)glibhelper_terminate_histogram(monitor->lag_histogram);
+	g_free(monitor);
+
+	return TRUE;
+}
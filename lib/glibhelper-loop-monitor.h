@@ -0,0 +1,54 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-loop-monitor.h
+ * @brief	header for glibhelper-loop-monitor
+ */
+#ifndef GLIBHELPER_LOOP_MONITOR_H
+#define GLIBHELPER_LOOP_MONITOR_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+
+#include "glibhelper-histogram.h"
+
+struct s_glibhelper_loop_monitor;
+typedef struct s_glibhelper_loop_monitor *glibhelper_loop_monitor;
+
+typedef void (*fp_loop_overload_callback)(glibhelper_loop_monitor handle, gboolean overloaded, uint64_t lag);
+
+struct s_glibhelper_loop_monitor_operation {
+	fp_loop_overload_callback overload; /**< Callbuck for overload state change in monitored context. overloaded = TRUE when lag exceeds threshold,
+										FALSE when lag falls below half of threshold. lag is latest lag (ns). */
+};
+
+/** glibhelper_loop_monitor_config.*/
+typedef struct s_glibhelper_loop_monitor_config {
+	struct s_glibhelper_loop_monitor_operation operation; /**< loop monitor event handler. */
+	uint64_t interval; /**< Probe interval (ns). 0 = default (100ms). */
+	uint64_t threshold; /**< Lag limit for overload (ns). 0 = default (10ms). */
+} glibhelper_loop_monitor_config;
+
+/** glibhelper_loop_monitor_stats.*/
+typedef struct s_glibhelper_loop_monitor_stats {
+	guint64 probes; /**< number of lag probes. */
+	guint64 overloads; /**< number of transitions to overload state. */
+	guint64 iterations; /**< number of loop iterations. */
+	guint64 ready; /**< number of ready fds returned by poll (dispatched fd sources). */
+	guint64 max_ready; /**< max ready fds in one iteration. */
+	guint64 busy_time; /**< time spent in dispatch (ns). busy_time / elapsed time is loop utilization. */
+	glibhelper_histogram_stats lag; /**< lag of probes (ns). */
+} glibhelper_loop_monitor_stats;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_loop_monitor(glibhelper_loop_monitor *handle, GMainContext *context, glibhelper_loop_monitor_config *config, void *userdata);
+gboolean glibhelper_terminate_loop_monitor(glibhelper_loop_monitor handle);
+void* glibhelper_loop_monitor_get_userdata(glibhelper_loop_monitor handle);
+gboolean glibhelper_loop_monitor_is_overloaded(glibhelper_loop_monitor handle);
+uint64_t glibhelper_loop_monitor_get_lag(glibhelper_loop_monitor handle);
+gboolean glibhelper_loop_monitor_get_stats(glibhelper_loop_monitor handle, glibhelper_loop_monitor_stats *stats);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_LOOP_MONITOR_H
@@ -0,0 +1,436 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-loop-thread.c
+ * @brief	event loop thread with cpu affinity and scheduling policy
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "glibhelper-loop-thread.h"
+#include "glibhelper-stats.h"
+
+#define LOOP_THREAD_NAME_DEFAULT "glibhelper-loop"
+
+struct s_glibhelper_loop_thread {
+	GMainContext *context;
+	GThread *thread;
+	glibhelper_loop_thread_config config;
+	GMutex lock;
+	GCond cond;
+	gboolean started;	// Protected by lock
+	gboolean stopped;	// Thread was joined
+	int error;	// errno of first setting failure, 0 = all settings are applied
+	int tid;
+	gint quit;	// Set by stop request in the loop
+	uint64_t spin;	// ns. Written by any thread, read by loop thread.
+	glibhelper_loop_thread_stats stats;	// Written by loop thread only, atomic for readers in other threads
+	glibhelper_stats_entry stats_entry;
+};
+/**
+ * Apply affinity, scheduling policy and memory lock to calling thread.
+ *
+ * @param [in]	config	Loop thread configuration
+ *
+ * @return int
+ * @retval 0 Success.
+ * @retval >0 errno of first failure. Following settings are still applied.
+ */
+static int loop_thread_apply(glibhelper_loop_thread_config *config)
+{
+	cpu_set_t cpus;
+	struct sched_param param;
+	int error = 0;
+	int ret = 0;
+
+	if (config->cpu_mask != 0) {
+		CPU_ZERO(&cpus);
+		for (int i=0; i < 64; i++) {
+			if ((config->cpu_mask & (UINT64_C(1) << i)) != 0)
+				CPU_SET(i, &cpus);
+		}
+		ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if (ret != 0 && error == 0)
+			error = ret;
+	}
+
+	if (config->fifo_priority > 0) {
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = config->fifo_priority;
+		ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (ret != 0 && error == 0)
+			error = ret;
+	} else if (config->nice != 0) {
+		// On Linux, nice value is per thread.
+		if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), config->nice) < 0 && error == 0)
+			error = errno;
+	}
+
+	if (config->mlock == TRUE) {
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0 && error == 0)
+			error = errno;
+	}
+
+	return error;
+}
+//-----------------------------------------------------------------------------
+static uint64_t loop_thread_clock(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+/**
+ * Run the context in busy-poll mode. After each event the context is polled without blocking for spin time,
+ * and it blocks in poll when no event comes in the period. The spin time can be changed while running.
+ *
+ * @param [in]	lthread	Loop thread
+ */
+static void loop_thread_run_spin(struct s_glibhelper_loop_thread *lthread)
+{
+	glibhelper_loop_thread_stats *stats = &lthread->stats;
+	uint64_t last_event = loop_thread_clock();
+	uint64_t now = 0;
+	uint64_t spin = 0;
+	gboolean spinning = FALSE;
+
+	while (g_atomic_int_get(&lthread->quit) == 0) {
+		spin = __atomic_load_n(&lthread->spin, __ATOMIC_RELAXED);
+
+		if (g_main_context_iteration(lthread->context, FALSE) == TRUE) {
+			now = loop_thread_clock();
+			__atomic_fetch_add(&stats->dispatches, 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&stats->spin_hits, 1, __ATOMIC_RELAXED);
+			if (spinning == TRUE)
+				__atomic_fetch_add(&stats->spin_time, now - last_event, __ATOMIC_RELAXED);
+			last_event = now;
+			spinning = FALSE;
+			continue;
+		}
+
+		now = loop_thread_clock();
+		if (now - last_event < spin) {
+			spinning = TRUE;
+			continue;
+		}
+
+		// No event in spin time. Block until next event.
+		if (spinning == TRUE)
+			__atomic_fetch_add(&stats->spin_time, now - last_event, __ATOMIC_RELAXED);
+		spinning = FALSE;
+		__atomic_fetch_add(&stats->sleeps, 1, __ATOMIC_RELAXED);
+		if (g_main_context_iteration(lthread->context, TRUE) == TRUE)
+			__atomic_fetch_add(&stats->dispatches, 1, __ATOMIC_RELAXED);
+		last_event = loop_thread_clock();
+		__atomic_fetch_add(&stats->idle_time, last_event - now, __ATOMIC_RELAXED);	// Including dispatch time of the wakeup
+	}
+}
+/**
+ * Run the context with blocking poll at each iteration.
+ *
+ * @param [in]	lthread	Loop thread
+ */
+static void loop_thread_run_block(struct s_glibhelper_loop_thread *lthread)
+{
+	glibhelper_loop_thread_stats *stats = &lthread->stats;
+	uint64_t start = 0;
+
+	while (g_atomic_int_get(&lthread->quit) == 0) {
+		start = loop_thread_clock();
+		__atomic_fetch_add(&stats->sleeps, 1, __ATOMIC_RELAXED);
+		if (g_main_context_iteration(lthread->context, TRUE) == TRUE)
+			__atomic_fetch_add(&stats->dispatches, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&stats->idle_time, loop_thread_clock() - start, __ATOMIC_RELAXED);	// Including dispatch time
+	}
+}
+//-----------------------------------------------------------------------------
+static gpointer loop_thread_main(gpointer data)
+{
+	struct s_glibhelper_loop_thread *lthread = (struct s_glibhelper_loop_thread*)data;
+	int error = 0;
+
+	error = loop_thread_apply(&lthread->config);
+
+	g_mutex_lock(&lthread->lock);
+	lthread->error = error;
+	lthread->tid = (int)syscall(SYS_gettid);
+	lthread->started = TRUE;
+	g_cond_signal(&lthread->cond);
+	g_mutex_unlock(&lthread->lock);
+
+	if (error != 0 && lthread->config.strict == TRUE)
+		return NULL;
+
+	g_main_context_push_thread_default(lthread->context);
+	if (lthread->config.spin > 0)
+		loop_thread_run_spin(lthread);
+	else
+		loop_thread_run_block(lthread);
+	g_main_context_pop_thread_default(lthread->context);
+
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+static gboolean loop_thread_quit_cb(gpointer data)
+{
+	struct s_glibhelper_loop_thread *lthread = (struct s_glibhelper_loop_thread*)data;
+
+	g_atomic_int_set(&lthread->quit, 1);	// The loop exits after this dispatch
+
+	return G_SOURCE_REMOVE;
+}
+//-----------------------------------------------------------------------------
+static void loop_thread_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_loop_thread *lthread = (struct s_glibhelper_loop_thread*)userdata;
+	glibhelper_loop_thread_stats stats;
+
+	(void)glibhelper_loop_thread_get_stats(lthread, &stats);
+	glibhelper_stats_print(fd, "  name=%s tid=%d spin=%lu dispatches=%lu spin_hits=%lu sleeps=%lu spin_time=%lu idle_time=%lu\n",
+			lthread->config.name, lthread->tid, (unsigned long)__atomic_load_n(&lthread->spin, __ATOMIC_RELAXED),
+			(unsigned long)stats.dispatches, (unsigned long)stats.spin_hits, (unsigned long)stats.sleeps,
+			(unsigned long)stats.spin_time, (unsigned long)stats.idle_time);
+}
+/**
+ * Get event loop context of loop thread. Server, client, internal and timerfd helpers can be attached to it.
+ *
+ * @param [in]	handle	Loop thread handle
+ *
+ * @return GMainContext*
+ * @retval !NULL Context.
+ * @retval NULL Arg error.
+ */
+GMainContext* glibhelper_loop_thread_get_context(glibhelper_loop_thread handle)
+{
+	if (handle == NULL)
+		return NULL;
+
+	return ((struct s_glibhelper_loop_thread*)handle)->context;
+}
+/**
+ * Get kernel thread ID of loop thread. It can be used with external tools (ex. chrt, taskset).
+ *
+ * @param [in]	handle	Loop thread handle
+ *
+ * @return int
+ * @retval >0 Thread ID.
+ * @retval <0 Arg error.
+ */
+int glibhelper_loop_thread_get_tid(glibhelper_loop_thread handle)
+{
+	if (handle == NULL)
+		return -1;
+
+	return ((struct s_glibhelper_loop_thread*)handle)->tid;
+}
+/**
+ * Get result of thread settings. In non strict mode, the thread runs even if some settings failed.
+ *
+ * @param [in]	handle	Loop thread handle
+ *
+ * @return int
+ * @retval 0 All settings are applied.
+ * @retval >0 errno of first failed setting (ex. EPERM).
+ * @retval <0 Arg error.
+ */
+int glibhelper_loop_thread_get_error(glibhelper_loop_thread handle)
+{
+	if (handle == NULL)
+		return -1;
+
+	return ((struct s_glibhelper_loop_thread*)handle)->error;
+}
+/**
+ * Change busy-poll time of running loop thread. It is applied from next loop iteration.
+ * Busy-poll mode shall be enabled by spin in configuration, this function can not switch the mode.
+ *
+ * @param [in]	handle	Loop thread handle
+ * @param [in]	spin	Busy-poll time (ns). 0 = block at each iteration.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or busy-poll mode is not enabled.
+ */
+gboolean glibhelper_loop_thread_set_spin(glibhelper_loop_thread handle, uint64_t spin)
+{
+	struct s_glibhelper_loop_thread *lthread = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	lthread = (struct s_glibhelper_loop_thread*)handle;
+	if (lthread->config.spin == 0)
+		return FALSE;
+
+	__atomic_store_n(&lthread->spin, spin, __ATOMIC_RELAXED);
+
+	return TRUE;
+}
+/**
+ * Get loop statistics. The counters are updated by the loop thread without lock, the values are approximate
+ * while the thread runs. spin_hits and spin_time are counted in busy-poll mode only.
+ *
+ * @param [in]	handle	Loop thread handle
+ * @param [out]	stats	Pointer to store statistics.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_loop_thread_get_stats(glibhelper_loop_thread handle, glibhelper_loop_thread_stats *stats)
+{
+	struct s_glibhelper_loop_thread *lthread = NULL;
+
+	if (handle == NULL || stats == NULL)
+		return FALSE;
+
+	lthread = (struct s_glibhelper_loop_thread*)handle;
+	stats->dispatches = __atomic_load_n(&lthread->stats.dispatches, __ATOMIC_RELAXED);
+	stats->spin_hits = __atomic_load_n(&lthread->stats.spin_hits, __ATOMIC_RELAXED);
+	stats->sleeps = __atomic_load_n(&lthread->stats.sleeps, __ATOMIC_RELAXED);
+	stats->spin_time = __atomic_load_n(&lthread->stats.spin_time, __ATOMIC_RELAXED);
+	stats->idle_time = __atomic_load_n(&lthread->stats.idle_time, __ATOMIC_RELAXED);
+
+	return TRUE;
+}
+/**
+ * Create event loop thread with new context. The thread settings are applied in the new thread
+ * before the loop runs, and this function returns after that.
+ *
+ * @param [in]	handle	Pointer to store created loop thread handle.
+ * @param [in]	config	Loop thread configuration. NULL is default configuration.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, resource allocation error or setting error in strict mode.
+ */
+gboolean glibhelper_create_loop_thread(glibhelper_loop_thread *handle, glibhelper_loop_thread_config *config)
+{
+	struct s_glibhelper_loop_thread *lthread = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	lthread = (struct s_glibhelper_loop_thread*)g_malloc(sizeof(struct s_glibhelper_loop_thread));
+	if (lthread == NULL)
+		return FALSE;
+	memset(lthread,0,sizeof(struct s_glibhelper_loop_thread));
+
+	if (config != NULL)
+		lthread->config = (*config);
+	if (lthread->config.name == NULL)
+		lthread->config.name = LOOP_THREAD_NAME_DEFAULT;
+	lthread->spin = lthread->config.spin;
+
+	g_mutex_init(&lthread->lock);
+	g_cond_init(&lthread->cond);
+
+	lthread->context = g_main_context_new();
+
+	// GLib sets thread name.
+	lthread->thread = g_thread_try_new(lthread->config.name, loop_thread_main, lthread, NULL);
+	if (lthread->thread == NULL)
+		goto errorout;
+
+	g_mutex_lock(&lthread->lock);
+	while (lthread->started == FALSE)
+		g_cond_wait(&lthread->cond, &lthread->lock);
+	g_mutex_unlock(&lthread->lock);
+
+	if (lthread->error != 0 && lthread->config.strict == TRUE) {
+		(void)g_thread_join(lthread->thread);
+		goto errorout;
+	}
+
+	lthread->stats_entry = glibhelper_stats_register("loop_thread", loop_thread_stats_dump, lthread);
+
+	(*handle) = (glibhelper_loop_thread)(lthread);
+
+	return TRUE;
+
+errorout:
+	g_main_context_unref(lthread->context);
+	g_cond_clear(&lthread->cond);
+	g_mutex_clear(&lthread->lock);
+	g_free(lthread);
+
+	return FALSE;
+}
+/**
+ * Stop and join loop thread. The context is kept, so the helpers attached to the context
+ * can be terminated safely after this function (no callback runs concurrently).
+ *
+ * @param [in]	handle	Loop thread handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or already stopped.
+ */
+gboolean glibhelper_loop_thread_stop(glibhelper_loop_thread handle)
+{
+	struct s_glibhelper_loop_thread *lthread = NULL;
+	GSource *source = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	lthread = (struct s_glibhelper_loop_thread*)handle;
+	if (lthread->stopped == TRUE)
+		return FALSE;
+
+	// Quit from inside of the loop. g_main_loop_quit before g_main_loop_run starts would be lost.
+	source = g_idle_source_new();
+	g_source_set_callback(source, loop_thread_quit_cb, lthread, NULL);
+	(void)g_source_attach(source, lthread->context);
+	g_source_unref(source);
+
+	(void)g_thread_join(lthread->thread);
+	lthread->stopped = TRUE;
+
+	return TRUE;
+}
+/**
+ * Terminate loop thread and release the context. The thread is stopped when it is running.
+ * Terminate the helpers attached to the context before this function (after glibhelper_loop_thread_stop),
+ * releasing the context destroys its sources.
+ *
+ * @param [in]	handle	Loop thread handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_loop_thread(glibhelper_loop_thread handle)
+{
+	struct s_glibhelper_loop_thread *lthread = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	lthread = (struct s_glibhelper_loop_thread*)handle;
+
+	glibhelper_stats_unregister(lthread->stats_entry);
+	(void)glibhelper_loop_thread_stop(handle);
+
+	g_main_context_unref(lthread->context);
+	g_cond_clear(&lthread->cond);
+	g_mutex_clear(&lthread->lock);
+	g_free(lthread);
+
+	return TRUE;
+}
@@ -0,0 +1,49 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-loop-thread.h
+ * @brief	header for glibhelper-loop-thread
+ */
+#ifndef GLIBHELPER_LOOP_THREAD_H
+#define GLIBHELPER_LOOP_THREAD_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+
+struct s_glibhelper_loop_thread;
+typedef struct s_glibhelper_loop_thread *glibhelper_loop_thread;
+
+/** glibhelper_loop_thread_config.*/
+typedef struct s_glibhelper_loop_thread_config {
+	const char *name; /**< Thread name (up to 15 chars are visible). NULL = "glibhelper-loop". */
+	uint64_t cpu_mask; /**< CPU affinity (bit N = CPU N). 0 = not changed. */
+	int fifo_priority; /**< SCHED_FIFO priority (1 - 99). 0 = SCHED_OTHER. */
+	int nice; /**< Nice value of the thread for SCHED_OTHER (-20 - 19). 0 = not changed. */
+	gboolean mlock; /**< TRUE = lock current and future memory pages of the process (mlockall). */
+	gboolean strict; /**< TRUE = create fails when a setting can not be applied (ex. no CAP_SYS_NICE). FALSE = ignore it. */
+	uint64_t spin; /**< busy-poll mode : duration to poll the context without blocking after last event (ns). 0 = always block. */
+} glibhelper_loop_thread_config;
+
+/** glibhelper_loop_thread_stats.*/
+typedef struct s_glibhelper_loop_thread_stats {
+	guint64 dispatches; /**< number of loop iterations that dispatched sources. */
+	guint64 spin_hits; /**< busy-poll mode : dispatches found by non blocking poll (wakeup was not needed). */
+	guint64 sleeps; /**< number of blocking polls. */
+	guint64 spin_time; /**< busy-poll mode : time spent polling without event (ns). */
+	guint64 idle_time; /**< time spent in blocking polls (ns). */
+} glibhelper_loop_thread_stats;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_loop_thread(glibhelper_loop_thread *handle, glibhelper_loop_thread_config *config);
+gboolean glibhelper_terminate_loop_thread(glibhelper_loop_thread handle);
+gboolean glibhelper_loop_thread_stop(glibhelper_loop_thread handle);
+GMainContext* glibhelper_loop_thread_get_context(glibhelper_loop_thread handle);
+int glibhelper_loop_thread_get_tid(glibhelper_loop_thread handle);
+int glibhelper_loop_thread_get_error(glibhelper_loop_thread handle);
+gboolean glibhelper_loop_thread_set_spin(glibhelper_loop_thread handle, uint64_t spin);
+gboolean glibhelper_loop_thread_get_stats(glibhelper_loop_thread handle, glibhelper_loop_thread_stats *stats);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_LOOP_THREAD_H
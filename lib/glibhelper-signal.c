@@ -8,10 +8,34 @@
 #include <gio/gio.h>
 #include <glib-unix.h>
 
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <signal.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
 
 #include "glibhelper-signal.h"
+#include "glibhelper-stats.h"
+
+#define SIGNAL_MAX (65)	// _NSIG
+#define SIGNAL_READ_NUM (8)
+
+struct s_gelibhelper_io_channel {
+	GIOChannel *gio_source;
+	GSource *event_source;
+};
+
+struct s_glibhelper_signal_support {
+	struct s_gelibhelper_io_channel signal;
+	struct s_glibhelper_signal_operation operation;
+	fp_signal_callback callback[SIGNAL_MAX];	// Indexed by signal number
+	sigset_t mask;	// Signals read by signalfd
+	sigset_t blocked;	// Signals blocked by this helper
+	int dump_fd;
+	void *userdata;
+};
 
 /**
  * Callback function for SIGTERM handling
@@ -58,3 +82,273 @@ gboolean glibhelper_siganl_initialize(GMainLoop *loop)
 
 	return TRUE;
 }
+//-----------------------------------------------------------------------------
+static void signal_dump_handler(glibhelper_signal_support handle, int signo)
+{
+	(void)glibhelper_stats_dump(((struct s_glibhelper_signal_support*)handle)->dump_fd);
+}
+//-----------------------------------------------------------------------------
+static void signal_reload_handler(glibhelper_signal_support handle, int signo)
+{
+	struct s_glibhelper_signal_support *helper = (struct s_glibhelper_signal_support*)handle;
+
+	if (helper->operation.reload != NULL)
+		helper->operation.reload(handle, signo);
+}
+/**
+ * Get userdata of signal helper.
+ *
+ * @param [in]	handle	Signal helper handle
+ *
+ * @return void*
+ * @retval userdata.
+ */
+void* glibhelper_signal_get_userdata(glibhelper_signal_support handle)
+{
+	if (handle == NULL)
+		return NULL;
+
+	return ((struct s_glibhelper_signal_support*)handle)->userdata;
+}
+/**
+ * Add signal to signal helper. The callback is called in the context of signal helper.
+ * The signal is blocked in the calling thread. The signal must be blocked in all threads,
+ * so add signals before other threads are created (new threads inherit the signal mask).
+ * A signal that is already added is updated with new callback.
+ *
+ * @param [in]	handle	Signal helper handle
+ * @param [in]	signo	Signal number.
+ * @param [in]	callback	Callback for the signal.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or signalfd error.
+ */
+gboolean glibhelper_signal_add(glibhelper_signal_support handle, int signo, fp_signal_callback callback)
+{
+	struct s_glibhelper_signal_support *helper = NULL;
+	sigset_t ss;
+	sigset_t old;
+
+	if (handle == NULL || callback == NULL || signo <= 0 || signo >= SIGNAL_MAX || signo == SIGKILL || signo == SIGSTOP)
+		return FALSE;
+
+	helper = (struct s_glibhelper_signal_support*)handle;
+
+	helper->callback[signo] = callback;
+	if (sigismember(&helper->mask, signo) == 1)
+		return TRUE;
+
+	(void)sigemptyset(&ss);
+	(void)sigaddset(&ss, signo);
+	if (pthread_sigmask(SIG_BLOCK, &ss, &old) != 0)
+		goto errorout;
+	if (sigismember(&old, signo) == 0)
+		(void)sigaddset(&helper->blocked, signo);	// Unblock at terminate
+
+	(void)sigaddset(&helper->mask, signo);
+	if (signalfd(g_io_channel_unix_get_fd(helper->signal.gio_source), &helper->mask, 0) < 0) {
+		(void)sigdelset(&helper->mask, signo);
+		goto errorout;
+	}
+
+	return TRUE;
+
+errorout:
+	helper->callback[signo] = NULL;
+
+	return FALSE;
+}
+/**
+ * Remove signal from signal helper. The signal stays blocked until terminate,
+ * the signals received after this function are kept pending.
+ *
+ * @param [in]	handle	Signal helper handle
+ * @param [in]	signo	Signal number.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, not added signal or signalfd error.
+ */
+gboolean glibhelper_signal_remove(glibhelper_signal_support handle, int signo)
+{
+	struct s_glibhelper_signal_support *helper = NULL;
+
+	if (handle == NULL || signo <= 0 || signo >= SIGNAL_MAX)
+		return FALSE;
+
+	helper = (struct s_glibhelper_signal_support*)handle;
+	if (sigismember(&helper->mask, signo) != 1)
+		return FALSE;
+
+	(void)sigdelset(&helper->mask, signo);
+	helper->callback[signo] = NULL;
+
+	if (signalfd(g_io_channel_unix_get_fd(helper->signal.gio_source), &helper->mask, 0) < 0)
+		return FALSE;
+
+	return TRUE;
+}
+/**
+ * Read signals from signalfd and call callbacks.
+ *
+ * @param [in]	source	Pointor for active GIOChannel
+ * @param [in]	condition	I/O event condition.
+ * @param [in]	data	Pointer for signal helper
+ *
+ * @return gboolean
+ * @retval TRUES Success callback or non abnormal error.
+ * @retval FALSE Critical error. Callback stop.
+ */
+static gboolean signal_event (	GIOChannel *source,
+								GIOCondition condition,
+								gpointer data)
+{
+	struct s_glibhelper_signal_support *helper = NULL;
+	struct signalfd_siginfo info[SIGNAL_READ_NUM];
+	ssize_t readret = -1;
+	int signo = 0;
+
+	if (data == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_signal_support *)data;
+
+	if ((condition & G_IO_IN) == 0)
+		return FALSE;// Undefined error -> stop callback
+
+	do {
+		readret = read(g_io_channel_unix_get_fd(source), info, sizeof(info));
+		if (readret < 0 && errno == EINTR)
+			continue;
+		if (readret <= 0)
+			break;
+
+		for (int i=0; i < (int)(readret / sizeof(struct signalfd_siginfo)); i++) {
+			signo = (int)info[i].ssi_signo;
+			if (signo > 0 && signo < SIGNAL_MAX && helper->callback[signo] != NULL)
+				helper->callback[signo]((glibhelper_signal_support)helper, signo);
+		}
+	} while (readret == sizeof(info));
+
+	return TRUE;
+}
+/**
+ * Create signal helper. Signals are received by signalfd in the context, so callbacks can use any API of the context.
+ * Built-in handlers: SIGUSR1 dumps all library stats (glibhelper_stats_dump) to dump_fd, SIGHUP calls reload callback.
+ * Create it before other threads are created, refer to glibhelper_signal_add.
+ *
+ * @param [in]	handle	Pointer to store created signal helper handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Signal helper configuration. NULL is default configuration (SIGUSR1 dump to stderr).
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, signalfd error or resource allocation error.
+ */
+gboolean glibhelper_create_signal(glibhelper_signal_support *handle, GMainContext *context, glibhelper_signal_config *config, void *userdata)
+{
+	struct s_glibhelper_signal_support *helper = NULL;
+	GIOChannel *gsignalio = NULL;
+	GSource *gsignalsource = NULL;
+	int sigfd = -1;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_signal_support*)g_malloc(sizeof(struct s_glibhelper_signal_support));
+	if (helper == NULL)
+		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_signal_support));
+
+	(void)sigemptyset(&helper->mask);
+	(void)sigemptyset(&helper->blocked);
+	helper->dump_fd = STDERR_FILENO;
+	if (config != NULL) {
+		helper->operation = config->operation;
+		if (config->dump_fd != 0)
+			helper->dump_fd = config->dump_fd;
+	}
+	helper->userdata = userdata;
+
+	sigfd = signalfd(-1, &helper->mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sigfd < 0)
+		goto errorout;
+
+	gsignalio = g_io_channel_unix_new (sigfd);
+	g_io_channel_set_close_on_unref(gsignalio,TRUE);	// fd close on final unref
+	sigfd = -1; // The fd close automatically, do not close myself.
+
+	gsignalsource = g_io_create_watch(gsignalio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+	if (gsignalsource == NULL)
+		goto errorout;
+
+	g_source_set_callback(gsignalsource, (GSourceFunc)signal_event,(gpointer)helper, NULL);
+
+	(void)g_source_attach(gsignalsource, context);
+
+	g_source_unref(gsignalsource);
+
+	helper->signal.gio_source = gsignalio;
+	helper->signal.event_source = gsignalsource;
+
+	if (helper->dump_fd >= 0) {
+		if (glibhelper_signal_add(helper, SIGUSR1, signal_dump_handler) == FALSE)
+			goto errorout_destroy;
+	}
+
+	if (helper->operation.reload != NULL) {
+		if (glibhelper_signal_add(helper, SIGHUP, signal_reload_handler) == FALSE)
+			goto errorout_destroy;
+	}
+
+	(*handle) = (glibhelper_signal_support)(helper);
+
+	return TRUE;
+
+errorout_destroy:
+	(void)glibhelper_terminate_signal(helper);
+
+	return FALSE;
+
+errorout:
+
+	if (gsignalio != NULL)
+		g_io_channel_unref(gsignalio);
+
+	if (sigfd >= 0)
+		close(sigfd);
+
+	g_free(helper);
+
+	return FALSE;
+}
+/**
+ * Terminate signal helper. The signals blocked by this helper are unblocked,
+ * pending signals are delivered with their disposition.
+ *
+ * @param [in]	handle	Signal helper handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_signal(glibhelper_signal_support handle)
+{
+	struct s_glibhelper_signal_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_signal_support *)handle;
+
+	g_source_destroy(helper->signal.event_source);
+	g_io_channel_unref(helper->signal.gio_source);
+
+	(void)pthread_sigmask(SIG_UNBLOCK, &helper->blocked, NULL);
+
+	g_free(helper);
+
+	return TRUE;
+}
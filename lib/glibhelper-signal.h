@@ -10,8 +10,30 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+//-----------------------------------------------------------------------------
+struct s_glibhelper_signal_support;
+typedef struct s_glibhelper_signal_support *glibhelper_signal_support;
+
+typedef void (*fp_signal_callback)(glibhelper_signal_support handle, int signo);
+
+struct s_glibhelper_signal_operation {
+	fp_signal_callback reload; /**< Callbuck for SIGHUP (configuration reload). NULL = SIGHUP is not handled. */
+};
+
+/** glibhelper_signal_config.*/
+typedef struct s_glibhelper_signal_config {
+	struct s_glibhelper_signal_operation operation; /**< signal event handler. */
+	int dump_fd; /**< Output fd of stats dump by SIGUSR1. 0 = stderr, <0 = SIGUSR1 is not handled. */
+} glibhelper_signal_config;
+
 //-----------------------------------------------------------------------------
 gboolean glibhelper_siganl_initialize(GMainLoop *loop);
 
+gboolean glibhelper_create_signal(glibhelper_signal_support *handle, GMainContext *context, glibhelper_signal_config *config, void *userdata);
+gboolean glibhelper_terminate_signal(glibhelper_signal_support handle);
+void* glibhelper_signal_get_userdata(glibhelper_signal_support handle);
+gboolean glibhelper_signal_add(glibhelper_signal_support handle, int signo, fp_signal_callback callback);
+gboolean glibhelper_signal_remove(glibhelper_signal_support handle, int signo);
+
 //-----------------------------------------------------------------------------
 #endif //#ifndef GLIBHELPER_SIGNAL_H
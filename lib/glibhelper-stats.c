@@ -0,0 +1,143 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-stats.c
+ * @brief	process wide registry of library counters for runtime dump
+ */
+#include <glib.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-stats.h"
+
+struct s_glibhelper_stats_entry {
+	const char *name;
+	fp_stats_dump_callback dump;
+	void *userdata;
+};
+
+// Registered entries. The lock is kept while dumping, so unregister waits for running dump.
+G_LOCK_DEFINE_STATIC(stats_registry);
+static GList *stats_entries = NULL;
+/**
+ * Register counters of an object to stats registry. This function is thread safe.
+ * The dump callback is called in the thread of glibhelper_stats_dump, it reads the counters without lock.
+ *
+ * @param [in]	name	Object type name. It must be a static string.
+ * @param [in]	dump	Function to print counters. Use glibhelper_stats_print.
+ * @param [in]	userdata	Argument of the function.
+ *
+ * @return glibhelper_stats_entry
+ * @retval !NULL Registered entry.
+ * @retval NULL Arg error or resource allocation error.
+ */
+glibhelper_stats_entry glibhelper_stats_register(const char *name, fp_stats_dump_callback dump, void *userdata)
+{
+	struct s_glibhelper_stats_entry *entry = NULL;
+
+	if (name == NULL || dump == NULL)
+		return NULL;
+
+	entry = (struct s_glibhelper_stats_entry*)g_malloc(sizeof(struct s_glibhelper_stats_entry));
+	if (entry == NULL)
+		return NULL;
+	entry->name = name;
+	entry->dump = dump;
+	entry->userdata = userdata;
+
+	G_LOCK(stats_registry);
+	stats_entries = g_list_append(stats_entries, entry);
+	G_UNLOCK(stats_registry);
+
+	return (glibhelper_stats_entry)entry;
+}
+/**
+ * Unregister entry from stats registry. This function is thread safe.
+ * After this function, the dump callback is never called.
+ *
+ * @param [in]	entry	Registered entry. NULL is ignored.
+ */
+void glibhelper_stats_unregister(glibhelper_stats_entry entry)
+{
+	if (entry == NULL)
+		return;
+
+	G_LOCK(stats_registry);
+	stats_entries = g_list_remove(stats_entries, entry);
+	G_UNLOCK(stats_registry);
+
+	g_free(entry);
+}
+/**
+ * Print formatted text to fd for dump callback.
+ *
+ * @param [in]	fd	Output fd.
+ * @param [in]	format	printf format.
+ */
+void glibhelper_stats_print(int fd, const char *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	(void)vdprintf(fd, format, ap);
+	va_end(ap);
+}
+/**
+ * Print summary of histogram to fd for dump callback.
+ *
+ * @param [in]	fd	Output fd.
+ * @param [in]	label	Label of histogram.
+ * @param [in]	histogram	Histogram handle. NULL is ignored.
+ */
+void glibhelper_stats_print_histogram(int fd, const char *label, glibhelper_histogram histogram)
+{
+	glibhelper_histogram_stats stats;
+
+	if (histogram == NULL)
+		return;
+
+	if (glibhelper_histogram_get_stats(histogram, &stats) != TRUE)
+		return;
+
+	glibhelper_stats_print(fd, "  %s: count=%lu min=%lu mean=%lu p50=%lu p90=%lu p99=%lu p99.9=%lu max=%lu\n",
+			label, (unsigned long)stats.count, (unsigned long)stats.min, (unsigned long)stats.mean,
+			(unsigned long)stats.p50, (unsigned long)stats.p90, (unsigned long)stats.p99,
+			(unsigned long)stats.p999, (unsigned long)stats.max);
+}
+/**
+ * Dump counters of all registered objects to fd. This function is thread safe.
+ *
+ * @param [in]	fd	Output fd.
+ *
+ * @return int
+ * @retval >=0 Number of dumped objects.
+ * @retval <0 Arg error.
+ */
+int glibhelper_stats_dump(int fd)
+{
+	struct s_glibhelper_stats_entry *entry = NULL;
+	int num = 0;
+
+	if (fd < 0)
+		return -1;
+
+	G_LOCK(stats_registry);
+
+	glibhelper_stats_print(fd, "# glibhelper stats pid=%d time=%ld\n", (int)getpid(), (long)g_get_monotonic_time());
+	for (GList *listptr = g_list_first(stats_entries); listptr != NULL; listptr = g_list_next(listptr)) {
+		entry = (struct s_glibhelper_stats_entry*)listptr->data;
+		glibhelper_stats_print(fd, "%s %p\n", entry->name, entry->userdata);
+		entry->dump(fd, entry->userdata);
+		num++;
+	}
+
+	G_UNLOCK(stats_registry);
+
+	return num;
+}
@@ -0,0 +1,27 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-stats.h
+ * @brief	header for glibhelper-stats
+ */
+#ifndef GLIBHELPER_STATS_H
+#define GLIBHELPER_STATS_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+
+#include "glibhelper-histogram.h"
+
+struct s_glibhelper_stats_entry;
+typedef struct s_glibhelper_stats_entry *glibhelper_stats_entry;
+
+typedef void (*fp_stats_dump_callback)(int fd, void *userdata);
+
+//-----------------------------------------------------------------------------
+glibhelper_stats_entry glibhelper_stats_register(const char *name, fp_stats_dump_callback dump, void *userdata);
+void glibhelper_stats_unregister(glibhelper_stats_entry entry);
+int glibhelper_stats_dump(int fd);
+void glibhelper_stats_print(int fd, const char *format, ...) G_GNUC_PRINTF(2, 3);
+void glibhelper_stats_print_histogram(int fd, const char *label, glibhelper_histogram histogram);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_STATS_H
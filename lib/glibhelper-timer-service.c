@@ -0,0 +1,695 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-timer-service.c
+ * @brief	multiplexed timers on one timerfd by hierarchical timer wheel for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/timerfd.h>
+
+#include "glibhelper-timer-service.h"
+#include "glibhelper-stats.h"
+
+#define TIMER_WHEEL_LEVEL (4)
+#define TIMER_WHEEL_BITS (8)
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+// Max distance of slot from current tick. The top level slot never wraps to current slot.
+#define TIMER_WHEEL_MAX_DELTA ((UINT64_C(1) << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVEL)) - (UINT64_C(1) << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVEL - 1))))
+#define TIMER_SERVICE_TICK_DEFAULT (1000 * 1000)
+#define TIMER_RUNNING_LEVEL (-1)
+
+enum timer_state {
+	TIMER_IDLE = 0,
+	TIMER_ARMED,
+	TIMER_FIRING,
+};
+
+struct s_timer_list {
+	struct s_glibhelper_timer *head;
+};
+
+struct s_glibhelper_timer {
+	struct s_glibhelper_timer *prev;
+	struct s_glibhelper_timer *next;
+	struct s_timer_list *list;	// Linked list, NULL = not linked
+	struct s_glibhelper_timer *all_prev;	// List of all timers in service
+	struct s_glibhelper_timer *all_next;
+	struct s_glibhelper_timer_service *service;
+	fp_timer_callback callback;
+	void *userdata;
+	uint64_t expire;	// Expiration (tick)
+	uint64_t interval;	// Interval (tick), 0 = one-shot
+	int level;
+	enum timer_state state;
+	gboolean removed;
+};
+
+struct s_gelibhelper_io_channel {
+	GIOChannel *gio_source;
+	GSource *event_source;
+};
+
+struct s_glibhelper_timer_service {
+	struct s_gelibhelper_io_channel timer;
+	struct s_timer_list wheel[TIMER_WHEEL_LEVEL][TIMER_WHEEL_SIZE];
+	int count[TIMER_WHEEL_LEVEL];	// Number of timers in each level
+	struct s_timer_list running;	// Expired timers in current tick
+	struct s_glibhelper_timer *all;	// All timers include not armed timers
+	GMainContext *context;
+	uint64_t base;	// Clock (ns) of tick 0
+	uint64_t tick;	// ns per tick
+	uint64_t now;	// Next tick to process. All ticks before it were processed.
+	uint64_t armed;	// Tick set to timerfd, 0 = disarmed
+	int num_of_timer;
+	gboolean dispatching;
+	glibhelper_stats_entry stats_entry;
+};
+//-----------------------------------------------------------------------------
+static uint64_t timer_service_clock(void)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+static uint64_t timer_service_current_tick(struct s_glibhelper_timer_service *service)
+{
+	return (timer_service_clock() - service->base) / service->tick;
+}
+//-----------------------------------------------------------------------------
+static void timer_list_add(struct s_timer_list *list, struct s_glibhelper_timer *timer)
+{
+	timer->prev = NULL;
+	timer->next = list->head;
+	if (list->head != NULL)
+		list->head->prev = timer;
+	list->head = timer;
+	timer->list = list;
+}
+//-----------------------------------------------------------------------------
+static void timer_list_del(struct s_glibhelper_timer *timer)
+{
+	if (timer->prev != NULL)
+		timer->prev->next = timer->next;
+	else
+		timer->list->head = timer->next;
+
+	if (timer->next != NULL)
+		timer->next->prev = timer->prev;
+
+	timer->prev = NULL;
+	timer->next = NULL;
+	timer->list = NULL;
+}
+/**
+ * Unlink timer from wheel or running list. O(1).
+ *
+ * @param [in]	timer	Timer
+ */
+static void timer_wheel_unlink(struct s_glibhelper_timer *timer)
+{
+	if (timer->list == NULL)
+		return;
+
+	if (timer->level >= 0)
+		timer->service->count[timer->level]--;
+
+	timer_list_del(timer);
+}
+/**
+ * Link timer to the wheel slot of its expiration. O(1).
+ * The level is selected by distance from current tick, and the slot by the expiration bits of the level.
+ *
+ * @param [in]	service	Timer service
+ * @param [in]	timer	Timer
+ */
+static void timer_wheel_insert(struct s_glibhelper_timer_service *service, struct s_glibhelper_timer *timer)
+{
+	uint64_t expire = 0;
+	uint64_t delta = 0;
+	int level = 0;
+	int index = 0;
+
+	if (timer->expire < service->now)
+		timer->expire = service->now;
+
+	expire = timer->expire;
+	delta = expire - service->now;
+	if (delta > TIMER_WHEEL_MAX_DELTA) {
+		// Too far. It is placed at the furthest slot and inserted again when the slot expires.
+		delta = TIMER_WHEEL_MAX_DELTA;
+		expire = service->now + delta;
+	}
+
+	for (level=0; level < (TIMER_WHEEL_LEVEL - 1); level++) {
+		if (delta < (UINT64_C(1) << (TIMER_WHEEL_BITS * (level + 1))))
+			break;
+	}
+
+	index = (int)((expire >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+
+	timer_list_add(&service->wheel[level][index], timer);
+	timer->level = level;
+	service->count[level]++;
+}
+/**
+ * Move all timers of an upper level slot to lower levels.
+ *
+ * @param [in]	service	Timer service
+ * @param [in]	level	Level of slot
+ * @param [in]	index	Index of slot
+ */
+static void timer_wheel_cascade(struct s_glibhelper_timer_service *service, int level, int index)
+{
+	struct s_glibhelper_timer *timer = NULL;
+
+	while ((timer = service->wheel[level][index].head) != NULL) {
+		timer_wheel_unlink(timer);
+		timer_wheel_insert(service, timer);
+	}
+}
+/**
+ * Get next tick that the timer service shall process.
+ * For upper levels, it is the tick of cascade, that is not later than the expirations in the slot.
+ *
+ * @param [in]	service	Timer service
+ * @param [out]	next	Pointer to store the tick.
+ *
+ * @return gboolean
+ * @retval TRUE Next tick exists.
+ * @retval FALSE No timer.
+ */
+static gboolean timer_wheel_next(struct s_glibhelper_timer_service *service, uint64_t *next)
+{
+	uint64_t candidate = 0;
+	uint64_t best = 0;
+	gboolean found = FALSE;
+	int shift = 0;
+	int current = 0;
+	int start = 0;
+
+	for (int level=0; level < TIMER_WHEEL_LEVEL; level++) {
+		if (service->count[level] == 0)
+			continue;
+
+		shift = TIMER_WHEEL_BITS * level;
+		current = (int)((service->now >> shift) & TIMER_WHEEL_MASK);
+
+		// Current slot of upper level is not cascaded yet only when now is just on its boundary.
+		// Otherwise the current slot holds timers of next lap, it is checked at distance TIMER_WHEEL_SIZE.
+		start = ((service->now & ((UINT64_C(1) << shift) - 1)) == 0) ? 0 : 1;
+
+		for (int distance = start; distance < TIMER_WHEEL_SIZE + start; distance++) {
+			if (service->wheel[level][(current + distance) & TIMER_WHEEL_MASK].head == NULL)
+				continue;
+
+			if (level == 0)
+				candidate = service->now + (uint64_t)distance;
+			else
+				candidate = ((service->now >> shift) + (uint64_t)distance) << shift;
+
+			if (found == FALSE || candidate < best) {
+				best = candidate;
+				found = TRUE;
+			}
+			break;
+		}
+	}
+
+	if (found == TRUE)
+		(*next) = best;
+
+	return found;
+}
+/**
+ * Set timerfd to next tick of the wheel. The timerfd is updated only when the tick is changed.
+ *
+ * @param [in]	service	Timer service
+ */
+static void timer_service_arm(struct s_glibhelper_timer_service *service)
+{
+	struct itimerspec timersetting;
+	uint64_t next = 0;
+	uint64_t clock = 0;
+	int timerfd = -1;
+
+	if (timer_wheel_next(service, &next) == FALSE)
+		next = 0;
+	else if (next == 0)
+		next = 1;	// 0 means disarmed. Tick 0 and 1 are almost same.
+
+	if (next == service->armed)
+		return;
+
+	memset(&timersetting, 0, sizeof(timersetting));
+	if (next != 0) {
+		clock = service->base + (next * service->tick);
+		timersetting.it_value.tv_sec = clock / (1000 * 1000 * 1000);
+		timersetting.it_value.tv_nsec = clock % (1000 * 1000 * 1000);
+	}
+
+	timerfd = g_io_channel_unix_get_fd(service->timer.gio_source);
+	if (timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &timersetting, NULL) == 0)
+		service->armed = next;
+}
+/**
+ * Call callback of expired timer and reschedule periodic timer.
+ *
+ * @param [in]	service	Timer service
+ * @param [in]	timer	Expired timer
+ */
+static void timer_service_fire(struct s_glibhelper_timer_service *service, struct s_glibhelper_timer *timer)
+{
+	gboolean ret = FALSE;
+
+	timer->state = TIMER_FIRING;
+
+	if (timer->callback != NULL)
+		ret = timer->callback(timer);
+
+	if (timer->removed == TRUE) {
+		g_free(timer);
+		return;
+	}
+
+	if (timer->state != TIMER_FIRING)
+		return;	// Re-armed or canceled in callback
+
+	if (ret == TRUE && timer->interval > 0) {
+		// Keep phase of periodic timer. Missed expirations are skipped.
+		timer->expire += timer->interval;
+		if (timer->expire < service->now)
+			timer->expire += ((service->now - timer->expire + timer->interval - 1) / timer->interval) * timer->interval;
+		timer_wheel_insert(service, timer);
+		timer->state = TIMER_ARMED;
+	} else
+		timer->state = TIMER_IDLE;
+}
+/**
+ * Process all ticks until target tick.
+ * Empty ranges of the wheel are skipped until next cascade, so long sleep does not cost each tick.
+ *
+ * @param [in]	service	Timer service
+ * @param [in]	target	Last tick to process.
+ */
+static void timer_service_advance(struct s_glibhelper_timer_service *service, uint64_t target)
+{
+	struct s_glibhelper_timer *timer = NULL;
+	uint64_t next = 0;
+	int index = 0;
+
+	while (service->now <= target) {
+		if ((service->now & TIMER_WHEEL_MASK) == 0) {
+			for (int level=1; level < TIMER_WHEEL_LEVEL; level++) {
+				index = (int)((service->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+				timer_wheel_cascade(service, level, index);
+				if (index != 0)
+					break;
+			}
+		}
+
+		if (service->count[0] == 0) {
+			if (timer_wheel_next(service, &next) == FALSE || next > target) {
+				service->now = target + 1;
+				break;
+			}
+			if (next > service->now) {
+				service->now = next;
+				continue;
+			}
+		}
+
+		index = (int)(service->now & TIMER_WHEEL_MASK);
+		while ((timer = service->wheel[0][index].head) != NULL) {
+			timer_wheel_unlink(timer);
+			timer_list_add(&service->running, timer);
+			timer->level = TIMER_RUNNING_LEVEL;
+		}
+
+		// Timers added by callbacks expire at next tick or later.
+		service->now++;
+
+		while ((timer = service->running.head) != NULL) {
+			timer_wheel_unlink(timer);
+
+			if (timer->expire >= service->now) {
+				timer_wheel_insert(service, timer);	// Far timer placed at clamped slot
+				continue;
+			}
+
+			timer_service_fire(service, timer);
+		}
+	}
+}
+/**
+ *
+ *
+ * @param [in]	source	Pointor for active GIOChannel
+ * @param [in]	condition	I/O event condition.
+ * @param [in]	data	Pointer for timer service
+ *
+ * @return gboolean
+ * @retval TRUES Success callback or non abnormal error.
+ * @retval FALSE Critical error. Callback stop.
+ */
+static gboolean timer_service_event(GIOChannel *source,
+								GIOCondition condition,
+								gpointer data)
+{
+	struct s_glibhelper_timer_service *service = NULL;
+	uint64_t timerinfo = 0;
+
+	if (data == NULL)
+		return FALSE;// Arg error
+
+	service = (struct s_glibhelper_timer_service*)data;
+
+	if ((condition & G_IO_IN) == 0)
+		return FALSE;	// Undefined error -> stop callback
+
+	(void)read(g_io_channel_unix_get_fd(source), &timerinfo, sizeof(timerinfo));
+	service->armed = 0;
+
+	service->dispatching = TRUE;
+	timer_service_advance(service, timer_service_current_tick(service));
+	service->dispatching = FALSE;
+
+	timer_service_arm(service);
+
+	return TRUE;
+}
+/**
+ * Schedule timer.
+ *
+ * @param [in]	timer	Timer
+ * @param [in]	timeout	Time until first expiration (ns).
+ * @param [in]	interval	Interval of periodic timer (ns). 0 = one-shot.
+ */
+static void timer_service_schedule(struct s_glibhelper_timer *timer, uint64_t timeout, uint64_t interval)
+{
+	struct s_glibhelper_timer_service *service = timer->service;
+	uint64_t elapsed = 0;
+	uint64_t current = 0;
+
+	elapsed = timer_service_clock() - service->base;
+	current = elapsed / service->tick;
+	if (service->dispatching == FALSE && current > service->now
+		&& service->count[0] == 0 && service->count[1] == 0 && service->count[2] == 0 && service->count[3] == 0)
+		service->now = current;	// Wheel is empty, skip idle ticks.
+
+	// Round up, the timer never expires before timeout.
+	timer->expire = (elapsed + timeout + service->tick - 1) / service->tick;
+	timer->interval = (interval + service->tick - 1) / service->tick;
+	timer->state = TIMER_ARMED;
+	timer_wheel_insert(service, timer);
+
+	if (service->dispatching == FALSE)
+		timer_service_arm(service);
+}
+/**
+ * Add timer to timer service. It shall be called in the context of timer service.
+ *
+ * @param [in]	handle	Timer service handle
+ * @param [in]	timeout	Time until first expiration (ns).
+ * @param [in]	interval	Interval of periodic timer (ns). 0 = one-shot.
+ * @param [in]	callback	Callback for timeout. Return FALSE to stop periodic timer.
+ * @param [in]	userdata	User data for callback.
+ *
+ * @return glibhelper_timer
+ * @retval !NULL Timer handle. It is valid until glibhelper_timer_service_remove.
+ * @retval NULL Arg error or resource allocation error.
+ */
+glibhelper_timer glibhelper_timer_service_add(glibhelper_timer_service handle, uint64_t timeout, uint64_t interval, fp_timer_callback callback, void *userdata)
+{
+	struct s_glibhelper_timer_service *service = NULL;
+	struct s_glibhelper_timer *timer = NULL;
+
+	if (handle == NULL || callback == NULL)
+		return NULL;
+
+	service = (struct s_glibhelper_timer_service*)handle;
+
+	timer = (struct s_glibhelper_timer*)g_malloc(sizeof(struct s_glibhelper_timer));
+	if (timer == NULL)
+		return NULL;
+	memset(timer,0,sizeof(struct s_glibhelper_timer));
+
+	timer->service = service;
+	timer->callback = callback;
+	timer->userdata = userdata;
+
+	timer->all_next = service->all;
+	if (service->all != NULL)
+		service->all->all_prev = timer;
+	service->all = timer;
+	service->num_of_timer++;
+	timer_service_schedule(timer, timeout, interval);
+
+	return (glibhelper_timer)timer;
+}
+/**
+ * Cancel timer. The timer handle is kept and it can be re-armed. O(1).
+ *
+ * @param [in]	timer	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_timer_service_cancel(glibhelper_timer timer)
+{
+	if (timer == NULL)
+		return FALSE;
+
+	timer_wheel_unlink(timer);
+	timer->state = TIMER_IDLE;
+
+	return TRUE;
+}
+/**
+ * Re-arm timer with new timeout and interval. It can be called in the callback of the timer. O(1).
+ *
+ * @param [in]	timer	Timer handle
+ * @param [in]	timeout	Time until first expiration (ns).
+ * @param [in]	interval	Interval of periodic timer (ns). 0 = one-shot.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_timer_service_rearm(glibhelper_timer timer, uint64_t timeout, uint64_t interval)
+{
+	if (timer == NULL || timer->removed == TRUE)
+		return FALSE;
+
+	timer_wheel_unlink(timer);
+	timer_service_schedule(timer, timeout, interval);
+
+	return TRUE;
+}
+/**
+ * Remove timer from timer service and release it. It can be called in the callback of the timer.
+ *
+ * @param [in]	timer	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_timer_service_remove(glibhelper_timer timer)
+{
+	if (timer == NULL || timer->removed == TRUE)
+		return FALSE;
+
+	timer_wheel_unlink(timer);
+
+	if (timer->all_prev != NULL)
+		timer->all_prev->all_next = timer->all_next;
+	else
+		timer->service->all = timer->all_next;
+	if (timer->all_next != NULL)
+		timer->all_next->all_prev = timer->all_prev;
+	timer->service->num_of_timer--;
+
+	if (timer->state == TIMER_FIRING) {
+		timer->removed = TRUE;	// Released after callback
+		timer->state = TIMER_IDLE;
+	} else
+		g_free(timer);
+
+	return TRUE;
+}
+/**
+ * Check the timer is armed.
+ *
+ * @param [in]	timer	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Armed.
+ * @retval FALSE Not armed or arg error.
+ */
+gboolean glibhelper_timer_is_active(glibhelper_timer timer)
+{
+	if (timer == NULL)
+		return FALSE;
+
+	return (timer->state == TIMER_ARMED) ? TRUE : FALSE;
+}
+/**
+ * Get userdata from timer handle.
+ * The userdata is set at glibhelper_timer_service_add.
+ *
+ * @param [in]	timer	Timer handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_timer_get_userdata(glibhelper_timer timer)
+{
+	if (timer == NULL)
+		return NULL;
+
+	return timer->userdata;
+}
+/**
+ * Get number of timers in timer service.
+ *
+ * @param [in]	handle	Timer service handle
+ *
+ * @return int
+ * @retval >=0 Number of timers (include not armed timers).
+ * @retval <0 Illegal handle error.
+ */
+int glibhelper_timer_service_get_num(glibhelper_timer_service handle)
+{
+	if (handle == NULL)
+		return -1;
+
+	return ((struct s_glibhelper_timer_service*)handle)->num_of_timer;
+}
+//-----------------------------------------------------------------------------
+static void timer_service_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_timer_service *service = (struct s_glibhelper_timer_service*)userdata;
+
+	glibhelper_stats_print(fd, "  timers=%d tick_ns=%lu level_timers=%d,%d,%d,%d\n", service->num_of_timer,
+			(unsigned long)service->tick, service->count[0], service->count[1], service->count[2], service->count[3]);
+}
+/**
+ * Create timer service. Any number of timers share one timerfd in the context.
+ *
+ * @param [in]	handle	Pointer to store created timer service handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Timer service configuration. NULL is default configuration.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_timer_service(glibhelper_timer_service *handle, GMainContext *context, glibhelper_timer_service_config *config)
+{
+	int timerfd = -1;
+	GIOChannel *gtimerfdio = NULL;
+	GSource *gtimerfdsource = NULL;
+	struct s_glibhelper_timer_service *service = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	service = (struct s_glibhelper_timer_service*)g_malloc(sizeof(struct s_glibhelper_timer_service));
+	if (service == NULL)
+		return FALSE;
+	memset(service,0,sizeof(struct s_glibhelper_timer_service));
+
+	timerfd = timerfd_create(CLOCK_MONOTONIC, (TFD_NONBLOCK | TFD_CLOEXEC));
+	if (timerfd < 0)
+		goto errorout;
+
+	gtimerfdio = g_io_channel_unix_new (timerfd);
+	g_io_channel_set_close_on_unref(gtimerfdio,TRUE);	// fd close on final unref
+	timerfd = -1; // The fd close automatically, do not close myself.
+
+	gtimerfdsource = g_io_create_watch(gtimerfdio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+	if (gtimerfdsource == NULL)
+		goto errorout;
+
+	g_source_set_callback(gtimerfdsource, (GSourceFunc)timer_service_event,(gpointer)service, NULL);
+
+	(void)g_source_attach(gtimerfdsource, context);
+
+	g_source_unref(gtimerfdsource);
+
+	service->timer.gio_source = gtimerfdio;
+	service->timer.event_source = gtimerfdsource;
+	service->context = context;
+	service->tick = TIMER_SERVICE_TICK_DEFAULT;
+	if (config != NULL && config->tick > 0)
+		service->tick = config->tick;
+	service->base = timer_service_clock();
+	service->now = 0;
+	service->armed = 0;
+	service->stats_entry = glibhelper_stats_register("timer_service", timer_service_stats_dump, service);
+
+	(*handle) = (glibhelper_timer_service)(service);
+
+	return TRUE;
+
+errorout:
+
+	if (gtimerfdio != NULL)
+		g_io_channel_unref(gtimerfdio);
+
+	if (timerfd >= 0)
+		close(timerfd);
+
+	g_free(service);
+
+	return FALSE;
+}
+/**
+ * Terminate timer service and release all timers. All timer handles become invalid.
+ * Do not call this function in timer callbacks of the same timer service.
+ *
+ * @param [in]	handle	Timer service handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_timer_service(glibhelper_timer_service handle)
+{
+	struct s_glibhelper_timer_service *service = NULL;
+	struct s_glibhelper_timer *timer = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	service = (struct s_glibhelper_timer_service*)handle;
+
+	glibhelper_stats_unregister(service->stats_entry);
+
+	while ((timer = service->all) != NULL) {
+		service->all = timer->all_next;
+		g_free(timer);
+	}
+
+	// Destroy timerfd
+	g_source_destroy(service->timer.event_source);
+	g_io_channel_unref(service->timer.gio_source);
+	g_free(service);
+
+	return TRUE;
+}
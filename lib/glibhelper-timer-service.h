@@ -0,0 +1,41 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-timer-service.h
+ * @brief	header for glibhelper-timer-service
+ */
+#ifndef GLIBHELPER_TIMER_SERVICE_H
+#define GLIBHELPER_TIMER_SERVICE_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+
+struct s_glibhelper_timer_service;
+typedef struct s_glibhelper_timer_service *glibhelper_timer_service;
+
+struct s_glibhelper_timer;
+typedef struct s_glibhelper_timer *glibhelper_timer;
+
+typedef gboolean (*fp_timer_callback)(glibhelper_timer timer);
+
+/** glibhelper_timer_service_config.*/
+typedef struct s_glibhelper_timer_service_config {
+	uint64_t tick; /**< Resolution of timers (ns). 0 = 1ms. */
+} glibhelper_timer_service_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_timer_service(glibhelper_timer_service *handle, GMainContext *context, glibhelper_timer_service_config *config);
+gboolean glibhelper_terminate_timer_service(glibhelper_timer_service handle);
+int glibhelper_timer_service_get_num(glibhelper_timer_service handle);
+
+glibhelper_timer glibhelper_timer_service_add(glibhelper_timer_service handle, uint64_t timeout, uint64_t interval, fp_timer_callback callback, void *userdata);
+gboolean glibhelper_timer_service_remove(glibhelper_timer timer);
+gboolean glibhelper_timer_service_cancel(glibhelper_timer timer);
+gboolean glibhelper_timer_service_rearm(glibhelper_timer timer, uint64_t timeout, uint64_t interval);
+gboolean glibhelper_timer_is_active(glibhelper_timer timer);
+void* glibhelper_timer_get_userdata(glibhelper_timer timer);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_TIMER_SERVICE_H
@@ -13,9 +13,11 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/timerfd.h>
 
 #include "glibhelper-timerfd-support.h"
+#include "glibhelper-stats.h"
 
 
 struct s_gelibhelper_io_channel {
@@ -29,7 +31,180 @@ struct s_glibhelper_timerfd_support {
 	struct s_glibhelper_timerfd_operation operation;
 	GMainContext *context;
 	void *userdata;
+	struct itimerspec paused;	// Remaining time at pause
+	gboolean is_paused;
+	uint64_t interval;	// ns
+	uint64_t deadline;	// Scheduled time of next expiration (ns)
+	uint64_t expirations;	// Total expirations
+	uint64_t overrun;	// Total missed expirations
+	clockid_t clockid;
+	gboolean absolute;
+	uint64_t phase;	// ns
+	uint64_t slack_grid;	// Deadlines are rounded up to multiple of this (ns). 0 = no coalescing.
+	uint64_t nominal;	// Deadline before rounding to slack grid (ns)
+	gboolean rearm;	// Re-arm one-shot at each expiration, the interval is not multiple of slack grid.
+	glibhelper_histogram jitter;	// NULL = not recorded
+	glibhelper_stats_entry stats_entry;
+	glibhelper_uring uring;	// NULL = poll backend
+	glibhelper_uring_request rx_request;	// io_uring backend : repeated read of expiration count
 };
+//-----------------------------------------------------------------------------
+static uint64_t timerfd_clock(struct s_glibhelper_timerfd_support *helper)
+{
+	struct timespec ts;
+
+	(void)clock_gettime(helper->clockid, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+/**
+ * Round up time to slack grid.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	time	Time(ns).
+ *
+ * @return uint64_t
+ * @retval >0 Rounded time.
+ */
+static uint64_t timerfd_coalesce(struct s_glibhelper_timerfd_support *helper, uint64_t time)
+{
+	if (helper->slack_grid == 0)
+		return time;
+
+	return (time + helper->slack_grid - 1) & ~(helper->slack_grid - 1);
+}
+//-----------------------------------------------------------------------------
+static void timerfd_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_timerfd_support *helper = (struct s_glibhelper_timerfd_support*)userdata;
+
+	glibhelper_stats_print(fd, "  interval=%lu expirations=%lu overrun=%lu paused=%d\n",
+			(unsigned long)helper->interval, (unsigned long)helper->expirations,
+			(unsigned long)helper->overrun, (int)helper->is_paused);
+	glibhelper_stats_print_histogram(fd, "jitter_ns", helper->jitter);
+}
+/**
+ * Set timerfd with absolute deadline and interval.
+ * With slack, the deadline is rounded up to the slack grid, so timers of any owner expire at the same time
+ * within the slack and wake up the CPU once.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	timerfd	timerfd
+ * @param [in]	deadline	Time of first expiration on the clock of timer(ns).
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return int
+ * @retval 0 Success.
+ * @retval <0 error (refer to error no).
+ */
+static int timerfd_arm_at(struct s_glibhelper_timerfd_support *helper, int timerfd, uint64_t deadline, uint64_t interval)
+{
+	struct itimerspec timersetting;
+	uint64_t nominal = deadline;
+	uint64_t kernel_interval = interval;
+	gboolean rearm = FALSE;
+	int ret = -1;
+
+	memset(&timersetting, 0, sizeof(timersetting));
+
+	if (helper->slack_grid != 0) {
+		deadline = timerfd_coalesce(helper, deadline);
+		// Aligned deadline + multiple of grid stays aligned, the kernel can repeat it.
+		if ((interval % helper->slack_grid) != 0) {
+			kernel_interval = 0;
+			rearm = TRUE;
+		}
+	}
+
+	// it_value 0 disarms timerfd. Past deadline expires immediately.
+	if (deadline == 0)
+		deadline = 1;
+
+	timersetting.it_value.tv_sec = deadline / (1000 * 1000 * 1000);
+	timersetting.it_value.tv_nsec = deadline % (1000 * 1000 * 1000);
+
+	// The kernel adds interval to previous deadline, so the period does not drift.
+	timersetting.it_interval.tv_sec = kernel_interval / (1000 * 1000 *1000);
+	timersetting.it_interval.tv_nsec = kernel_interval % (1000 * 1000 * 1000);
+
+	ret = timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &timersetting, NULL);
+	if (ret == 0) {
+		helper->interval = interval;
+		helper->deadline = deadline;
+		helper->nominal = nominal;
+		helper->rearm = rearm;
+	}
+
+	return ret;
+}
+/**
+ * Get first deadline at or after start that is aligned to phase + N * interval.
+ *
+ * @param [in]	start	Earliest time(ns).
+ * @param [in]	interval	Interval(ns). 0 = no alignment.
+ * @param [in]	phase	Offset from multiples of interval(ns).
+ *
+ * @return uint64_t
+ * @retval >0 Aligned deadline.
+ */
+static uint64_t timerfd_align(uint64_t start, uint64_t interval, uint64_t phase)
+{
+	uint64_t base = 0;
+
+	if (interval == 0)
+		return start;
+
+	base = phase % interval;
+	if (start <= base)
+		return base;
+
+	return base + (((start - base) + interval - 1) / interval) * interval;
+}
+/**
+ * Set timerfd with delay and interval. In absolute mode, first expiration is aligned to the phase.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	timerfd	timerfd
+ * @param [in]	initial_delay	Delay until first expiration(ns). 0 = expire immediately.
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return int
+ * @retval 0 Success.
+ * @retval <0 error (refer to error no).
+ */
+static int timerfd_arm(struct s_glibhelper_timerfd_support *helper, int timerfd, uint64_t initial_delay, uint64_t interval)
+{
+	struct itimerspec timersetting;
+	int ret = -1;
+
+	if (helper->absolute == TRUE)
+		return timerfd_arm_at(helper, timerfd,
+				timerfd_align(timerfd_clock(helper) + initial_delay, interval, helper->phase), interval);
+
+	if (helper->slack_grid != 0)
+		return timerfd_arm_at(helper, timerfd, timerfd_clock(helper) + initial_delay, interval);
+
+	memset(&timersetting, 0, sizeof(timersetting));
+
+	// it_value 0 disarms timerfd. Zero delay is 1ns.
+	if (initial_delay == 0)
+		initial_delay = 1;
+
+	timersetting.it_value.tv_sec = initial_delay / (1000 * 1000 * 1000);
+	timersetting.it_value.tv_nsec = initial_delay % (1000 * 1000 * 1000);
+
+	// Set a interval time
+	timersetting.it_interval.tv_sec = interval / (1000 * 1000 *1000);
+	timersetting.it_interval.tv_nsec = interval % (1000 * 1000 * 1000);
+
+	ret = timerfd_settime(timerfd, 0, &timersetting, NULL);
+	if (ret == 0) {
+		helper->interval = interval;
+		helper->deadline = timerfd_clock(helper) + initial_delay;
+	}
+
+	return ret;
+}
 /**
  *
  *
@@ -52,6 +227,287 @@ void* glibhelper_timerfd_get_userdata(glibhelper_timerfd_support_handle handle)
 
 	return helper->userdata;
 }
+/**
+ * Re-arm timer with new initial delay and interval. The timerfd and event source are reused.
+ * It can be called in the timeout callback and for paused timer (the timer is resumed).
+ *
+ * @param [in]	handle	Timer handle
+ * @param [in]	initial_delay	Delay until first expiration(ns). 0 = expire immediately.
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or timerfd error.
+ */
+gboolean glibhelper_timerfd_rearm(glibhelper_timerfd_support_handle handle, uint64_t initial_delay, uint64_t interval)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+
+	if (timerfd_arm(helper, g_io_channel_unix_get_fd(helper->timer.gio_source), initial_delay, interval) < 0)
+		return FALSE;
+
+	helper->is_paused = FALSE;
+
+	return TRUE;
+}
+/**
+ * Pause timer. Remaining time until next expiration is kept for resume.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, already paused or timerfd error.
+ */
+gboolean glibhelper_timerfd_pause(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+	struct itimerspec timersetting;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+	if (helper->is_paused == TRUE)
+		return FALSE;
+
+	memset(&timersetting, 0, sizeof(timersetting));
+
+	// Disarm and get remaining time at once.
+	if (timerfd_settime(g_io_channel_unix_get_fd(helper->timer.gio_source), 0, &timersetting, &helper->paused) < 0)
+		return FALSE;
+
+	helper->is_paused = TRUE;
+
+	return TRUE;
+}
+/**
+ * Resume paused timer. The timer expires after the remaining time at pause.
+ * In absolute mode, the expiration is aligned to the next deadline of the phase after the remaining time.
+ * With slack, the expiration is rounded up to the slack grid.
+ * A one-shot timer that already expired before pause is not armed.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, not paused or timerfd error.
+ */
+gboolean glibhelper_timerfd_resume(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+	if (helper->is_paused == FALSE)
+		return FALSE;
+
+	if ((helper->absolute == TRUE || helper->slack_grid != 0)
+		&& (helper->paused.it_value.tv_sec != 0 || helper->paused.it_value.tv_nsec != 0)) {
+		if (timerfd_arm(helper, g_io_channel_unix_get_fd(helper->timer.gio_source),
+				(uint64_t)helper->paused.it_value.tv_sec * 1000 * 1000 * 1000 + (uint64_t)helper->paused.it_value.tv_nsec,
+				helper->interval) < 0)
+			return FALSE;
+
+		helper->is_paused = FALSE;
+
+		return TRUE;
+	}
+
+	if (timerfd_settime(g_io_channel_unix_get_fd(helper->timer.gio_source), 0, &helper->paused, NULL) < 0)
+		return FALSE;
+
+	helper->deadline = timerfd_clock(helper) + (uint64_t)helper->paused.it_value.tv_sec * 1000 * 1000 * 1000
+						+ (uint64_t)helper->paused.it_value.tv_nsec;
+	helper->is_paused = FALSE;
+
+	return TRUE;
+}
+/**
+ * Get total number of expirations of timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return uint64_t
+ * @retval >=0 Number of expirations.
+ */
+uint64_t glibhelper_timerfd_get_expirations(glibhelper_timerfd_support_handle handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return ((struct s_glibhelper_timerfd_support*)handle)->expirations;
+}
+/**
+ * Get total number of missed expirations (overrun) of timer.
+ * When the event loop is stalled longer than interval, the expirations are merged into one callback.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return uint64_t
+ * @retval >=0 Number of missed expirations.
+ */
+uint64_t glibhelper_timerfd_get_overrun(glibhelper_timerfd_support_handle handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return ((struct s_glibhelper_timerfd_support*)handle)->overrun;
+}
+/**
+ * Re-arm timer with absolute deadline on the clock of timer. It can be used in both relative and absolute mode.
+ * With slack, the deadline is rounded up to the slack grid.
+ * It can be called in the timeout callback and for paused timer (the timer is resumed).
+ *
+ * @param [in]	handle	Timer handle
+ * @param [in]	deadline	Time of first expiration(ns). Refer to glibhelper_timerfd_get_time. Past time expires immediately.
+ * @param [in]	interval	Interval for periodic timer(ns). 0 = one-shot timer.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or timerfd error.
+ */
+gboolean glibhelper_timerfd_rearm_at(glibhelper_timerfd_support_handle handle, uint64_t deadline, uint64_t interval)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+
+	if (timerfd_arm_at(helper, g_io_channel_unix_get_fd(helper->timer.gio_source), deadline, interval) < 0)
+		return FALSE;
+
+	helper->is_paused = FALSE;
+
+	return TRUE;
+}
+/**
+ * Get current time of the clock of timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return uint64_t
+ * @retval >0 Current time(ns).
+ * @retval 0 Arg error.
+ */
+uint64_t glibhelper_timerfd_get_time(glibhelper_timerfd_support_handle handle)
+{
+	if (handle == NULL)
+		return 0;
+
+	return timerfd_clock((struct s_glibhelper_timerfd_support*)handle);
+}
+/**
+ * Get wakeup jitter statistics of timer. The jitter is the lateness of each callback (negative lateness is 0).
+ * This function is not thread safe, call it in the context of timer.
+ *
+ * @param [in]	handle	Timer handle
+ * @param [out]	stats	Pointer to store statistics(ns).
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or jitter_stats is not enabled.
+ */
+gboolean glibhelper_timerfd_get_jitter(glibhelper_timerfd_support_handle handle, glibhelper_histogram_stats *stats)
+{
+	if (handle == NULL)
+		return FALSE;
+
+	return glibhelper_histogram_get_stats(((struct s_glibhelper_timerfd_support*)handle)->jitter, stats);
+}
+/**
+ * Get percentile of wakeup jitter of timer. This function is not thread safe, call it in the context of timer.
+ *
+ * @param [in]	handle	Timer handle
+ * @param [in]	percentile	Percentile (0.0 - 100.0).
+ *
+ * @return uint64_t
+ * @retval >=0 Jitter at percentile(ns). 0 when no value is recorded or jitter_stats is not enabled.
+ */
+uint64_t glibhelper_timerfd_get_jitter_percentile(glibhelper_timerfd_support_handle handle, double percentile)
+{
+	if (handle == NULL)
+		return 0;
+
+	return glibhelper_histogram_get_percentile(((struct s_glibhelper_timerfd_support*)handle)->jitter, percentile);
+}
+/**
+ * Clear wakeup jitter statistics of timer.
+ *
+ * @param [in]	handle	Timer handle
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or jitter_stats is not enabled.
+ */
+gboolean glibhelper_timerfd_reset_jitter(glibhelper_timerfd_support_handle handle)
+{
+	struct s_glibhelper_timerfd_support *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_timerfd_support*)handle;
+	if (helper->jitter == NULL)
+		return FALSE;
+
+	glibhelper_histogram_reset(helper->jitter);
+
+	return TRUE;
+}
+/**
+ * Handle expirations and call timeout callback.
+ *
+ * @param [in]	helper	Timer
+ * @param [in]	timerfd	timerfd
+ * @param [in]	timerinfo	Number of expirations read from timerfd.
+ *
+ * @return gboolean
+ * @retval TRUE Continue timer.
+ * @retval FALSE Timeout callback requested to stop.
+ */
+static gboolean timerfd_expire(struct s_glibhelper_timerfd_support *helper, int timerfd, uint64_t timerinfo)
+{
+	gboolean ret = FALSE;
+	uint64_t latest = 0;
+	uint64_t now = 0;
+	glibhelper_timerfd_info info;
+
+	now = timerfd_clock(helper);
+	if (helper->rearm == TRUE) {
+		// One-shot per expiration. Count the missed nominal deadlines and schedule next one.
+		if (now > helper->nominal)
+			timerinfo = 1 + ((now - helper->nominal) / helper->interval);
+		latest = timerfd_coalesce(helper, helper->nominal + ((timerinfo - 1) * helper->interval));
+		(void)timerfd_arm_at(helper, timerfd, helper->nominal + (timerinfo * helper->interval), helper->interval);
+	} else {
+		// timerinfo is number of expirations since previous read.
+		latest = helper->deadline + ((timerinfo - 1) * helper->interval);
+		helper->deadline = latest + helper->interval;
+	}
+	info.expirations = timerinfo;
+	info.lateness = (int64_t)(now - latest);
+	helper->expirations += timerinfo;
+	helper->overrun += timerinfo - 1;
+	if (helper->jitter != NULL)
+		glibhelper_histogram_record(helper->jitter, (info.lateness > 0) ? (uint64_t)info.lateness : 0);
+
+	if (helper->operation.timeout_ex != NULL)
+		ret = helper->operation.timeout_ex(helper, &info);
+	else if (helper->operation.timeout != NULL)
+		ret = helper->operation.timeout(helper);
+
+	return ret;
+}
 /**
  *
  *
@@ -69,24 +525,55 @@ static gboolean timerfd_event (	GIOChannel *source,
 {
 	int timerfd = -1;
 	ssize_t readret = -1;
-	gboolean ret = FALSE;
 	uint64_t timerinfo = 0;
-	struct s_glibhelper_timerfd_support *helper = NULL;
 
 	if (data == NULL)
 		return FALSE;// Arg error
 
-	helper = (struct s_glibhelper_timerfd_support *)data;
-
 	if ((condition & G_IO_IN) != 0) {// timeout
 		timerfd = g_io_channel_unix_get_fd (source);
 		readret = read(timerfd, &timerinfo, sizeof(timerinfo));
+		if (readret <= 0)
+			return TRUE;	// Spurious wakeup (ex. re-armed before dispatch)
+
+		return timerfd_expire((struct s_glibhelper_timerfd_support *)data, timerfd, timerinfo);
+	}
+
+	return FALSE;	// Undefined error -> stop callback
+}
+/**
+ * Read completion of timerfd in io_uring backend. The read is submitted again by the ring.
+ *
+ * @param [in]	request	Read request
+ * @param [in]	res	Number of bytes or -errno.
+ * @param [in]	buf	Number of expirations
+ * @param [in]	data	Timer
+ *
+ * @return gboolean
+ * @retval TRUE Continue timer.
+ * @retval FALSE Timeout callback requested to stop.
+ */
+static gboolean timerfd_uring_event(glibhelper_uring_request request, int res, void *buf, void *data)
+{
+	struct s_glibhelper_timerfd_support *helper = (struct s_glibhelper_timerfd_support *)data;
+	int timerfd = g_io_channel_unix_get_fd(helper->timer.gio_source);
+	uint64_t timerinfo = 0;
+	gboolean ret = FALSE;
 
-		if (helper->operation.timeout != NULL && readret > 0)
-			ret = helper->operation.timeout(helper);
+	if (res == -EINTR) {
+		// Interrupted read is not submitted again by the ring. Start new one.
+		glibhelper_uring_cancel(request);
+		helper->rx_request = glibhelper_uring_read(helper->uring, timerfd, sizeof(uint64_t), timerfd_uring_event, helper);
+		return TRUE;
+	} else if (res != sizeof(timerinfo)) {
+		helper->rx_request = NULL;	// Undefined error -> stop callback
+		return FALSE;
+	}
 
-	} else // Undefined error -> stop callback
-		ret = FALSE;
+	memcpy(&timerinfo, buf, sizeof(timerinfo));
+	ret = timerfd_expire(helper, timerfd, timerinfo);
+	if (ret == FALSE)
+		helper->rx_request = NULL;	// Released by the ring
 
 	return ret;
 }
@@ -110,56 +597,79 @@ gboolean glibhelper_create_timerfd(glibhelper_timerfd_support_handle *handle, GM
 	struct s_glibhelper_timerfd_support *helper = NULL;
 	guint id = 0;
 
-	struct itimerspec timersetting;
-
 	if (handle == NULL || config == NULL)
 		return FALSE;
 	
 	helper = (struct s_glibhelper_timerfd_support*)g_malloc(sizeof(struct s_glibhelper_timerfd_support));
 	if (helper == NULL)
 		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_timerfd_support));
+
+	if (config->clock == GLIBHELPER_TIMERFD_CLOCK_REALTIME)
+		helper->clockid = CLOCK_REALTIME;
+	else if (config->clock == GLIBHELPER_TIMERFD_CLOCK_BOOTTIME)
+		helper->clockid = CLOCK_BOOTTIME;
+	else
+		helper->clockid = CLOCK_MONOTONIC;
+	helper->absolute = config->absolute;
+	helper->phase = config->phase;
+	if (config->slack > 0)
+		helper->slack_grid = UINT64_C(1) << (63 - __builtin_clzll(config->slack));	// Largest power of 2 <= slack
+
+	if (config->jitter_stats == TRUE) {
+		if (glibhelper_create_histogram(&helper->jitter) != TRUE)
+			goto errorout;
+	}
 
-	timerfd = timerfd_create(CLOCK_MONOTONIC, (TFD_NONBLOCK | TFD_CLOEXEC));
+	// io_uring backend : blocking fd. On kernels without nowait read of timerfd, the ring returns -EAGAIN
+	// for non blocking fd instead of waiting the expiration in its worker.
+	if (config->uring != NULL)
+		timerfd = timerfd_create(helper->clockid, TFD_CLOEXEC);
+	else
+		timerfd = timerfd_create(helper->clockid, (TFD_NONBLOCK | TFD_CLOEXEC));
 	if (timerfd < 0)
 		goto errorout;
 
-	memset(&timersetting, 0, sizeof(timersetting));
-	
-	// Do not use initial expiration
-	timersetting.it_value.tv_sec  = 0;
-	timersetting.it_value.tv_nsec = 1;
-
-	// Set a interval time
-	timersetting.it_interval.tv_sec = config->interval / (1000 * 1000 *1000);
-	timersetting.it_interval.tv_nsec = config->interval % (1000 * 1000 * 1000);
-	
-	ret = timerfd_settime(timerfd, 0, &timersetting, NULL);
+	ret = timerfd_arm(helper, timerfd, config->initial_delay, config->interval);
 	if (ret < 0)
 		goto errorout;
 
 	gtimerfdio = g_io_channel_unix_new (timerfd);
 	g_io_channel_set_close_on_unref(gtimerfdio,TRUE);	// fd close on final unref
-	timerfd = -1; // The fd close automatically, do not close myself.
-
-	gtimerfdsource = g_io_create_watch(gtimerfdio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
-	if (gtimerfdsource == NULL)
-		goto errorout;
-
-	g_source_set_callback(gtimerfdsource, (GSourceFunc)timerfd_event,(gpointer)helper, NULL);
-
-	id = g_source_attach(gtimerfdsource, context);
-	if (id == -1) {
-		goto errorout;
-	}
-
-	g_source_unref(gtimerfdsource);
 
 	helper->operation = config->operation;
 	helper->timer.gio_source = gtimerfdio;
-	helper->timer.event_source = gtimerfdsource;
-	helper->timer.id = id;
 	helper->context = context;
 	helper->userdata = userdata;
+	helper->uring = config->uring;
+
+	if (helper->uring != NULL) {
+		// io_uring backend : expiration count is read by the ring, no separate read after wakeup.
+		helper->rx_request = glibhelper_uring_read(helper->uring, timerfd, sizeof(uint64_t), timerfd_uring_event, helper);
+		timerfd = -1; // The fd close automatically, do not close myself.
+		if (helper->rx_request == NULL)
+			goto errorout;
+	} else {
+		timerfd = -1; // The fd close automatically, do not close myself.
+
+		gtimerfdsource = g_io_create_watch(gtimerfdio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+		if (gtimerfdsource == NULL)
+			goto errorout;
+
+		g_source_set_callback(gtimerfdsource, (GSourceFunc)timerfd_event,(gpointer)helper, NULL);
+
+		id = g_source_attach(gtimerfdsource, context);
+		if (id == -1) {
+			goto errorout;
+		}
+
+		g_source_unref(gtimerfdsource);
+
+		helper->timer.event_source = gtimerfdsource;
+		helper->timer.id = id;
+	}
+
+	helper->stats_entry = glibhelper_stats_register("timerfd", timerfd_stats_dump, helper);
 
 	(*handle) = (glibhelper_timerfd_support_handle)(helper);
 
@@ -173,6 +683,9 @@ errorout:
 	if (timerfd >= 0)
 		close(timerfd);
 
+	if (helper->jitter != NULL)
+		(void)glibhelper_terminate_histogram(helper->jitter);
+
 	g_free(helper);
 
 	return FALSE;
@@ -197,9 +710,16 @@ gboolean glibhelper_terminate_timerfd(glibhelper_timerfd_support_handle handle)
 
 	helper = (struct s_glibhelper_timerfd_support *)handle;
 
+	glibhelper_stats_unregister(helper->stats_entry);
+
 	// Destroy timerfd
-	g_source_destroy(helper->timer.event_source);
+	if (helper->rx_request != NULL)
+		glibhelper_uring_cancel(helper->rx_request);
+	else if (helper->timer.event_source != NULL)
+		g_source_destroy(helper->timer.event_source);
 	g_io_channel_unref(helper->timer.gio_source);
+	if (helper->jitter != NULL)
+		(void)glibhelper_terminate_histogram(helper->jitter);
 	g_free(helper);
 
 	return TRUE;
@@ -7,27 +7,57 @@
 #ifndef GLIBHELPER_TIMERFD_SUPPORT_H
 #define GLIBHELPER_TIMERFD_SUPPORT_H
 //-----------------------------------------------------------------------------
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
 #include <glib.h>
 #include <gio/gio.h>
+#endif
 
 #include <stdint.h>
 
+#include "glibhelper-histogram.h"
+#include "glibhelper-uring.h"
+
 struct s_glibhelper_timerfd_support;
 typedef struct s_glibhelper_timerfd_support *glibhelper_timerfd_support_handle;
 
 //typedef void* glibhelper_server_session_handle;
 
 
+/** Expiration information for timeout_ex callback.*/
+typedef struct s_glibhelper_timerfd_info {
+	uint64_t expirations; /**< Number of expirations since previous callback. >1 means missed ticks. */
+	int64_t lateness; /**< Actual wakeup time - scheduled time of latest expiration (ns). */
+} glibhelper_timerfd_info;
+
 typedef gboolean (*fp_timeout_callback)(glibhelper_timerfd_support_handle handle); 
+typedef gboolean (*fp_timeout_ex_callback)(glibhelper_timerfd_support_handle handle, const glibhelper_timerfd_info *info); 
 
 struct s_glibhelper_timerfd_operation {
 	fp_timeout_callback timeout; /**< Callbuck for timer timeout. */
+	fp_timeout_ex_callback timeout_ex; /**< Callbuck for timer timeout with expiration information. It is used instead of timeout when it is set. */
 };
 
+/** Clock of timer.*/
+typedef enum e_glibhelper_timerfd_clock {
+	GLIBHELPER_TIMERFD_CLOCK_MONOTONIC = 0, /**< CLOCK_MONOTONIC (default). */
+	GLIBHELPER_TIMERFD_CLOCK_REALTIME, /**< CLOCK_REALTIME. Absolute deadlines follow wall clock changes. */
+	GLIBHELPER_TIMERFD_CLOCK_BOOTTIME, /**< CLOCK_BOOTTIME. Includes system suspend time. */
+} glibhelper_timerfd_clock;
+
 /** glibhelper_server_socket_config.*/
 typedef struct s_glibhelper_timerfd_config {
 	struct s_glibhelper_timerfd_operation operation;
-	uint64_t interval; /**< Interval for periodic timer(ns). */
+	uint64_t interval; /**< Interval for periodic timer(ns). 0 = one-shot timer. */
+	uint64_t initial_delay; /**< Delay until first expiration(ns). 0 = expire immediately. */
+	glibhelper_timerfd_clock clock; /**< Clock of timer. */
+	gboolean absolute; /**< TRUE = expirations are aligned to absolute deadlines (phase + N * interval) on the clock. */
+	uint64_t phase; /**< Offset of deadlines from multiples of interval (ns). Used with absolute. */
+	gboolean jitter_stats; /**< TRUE = record wakeup jitter of each callback to histogram. */
+	uint64_t slack; /**< Allowed delay of expirations (ns). Deadlines are rounded up to multiple of largest power of 2 <= slack
+						on the clock, so timers with slack expire together and wake up the CPU once. 0 = no coalescing. */
+	glibhelper_uring uring; /**< io_uring backend : ring in the timer context. NULL = poll backend. */
 } glibhelper_timerfd_config;
 
 //-----------------------------------------------------------------------------
@@ -35,6 +65,16 @@ gboolean glibhelper_create_timerfd(glibhelper_timerfd_support_handle *handle, GM
 gboolean glibhelper_terminate_timerfd(glibhelper_timerfd_support_handle handle);
 
 void* glibhelper_timerfd_get_userdata(glibhelper_timerfd_support_handle handle);
+gboolean glibhelper_timerfd_rearm(glibhelper_timerfd_support_handle handle, uint64_t initial_delay, uint64_t interval);
+gboolean glibhelper_timerfd_pause(glibhelper_timerfd_support_handle handle);
+gboolean glibhelper_timerfd_resume(glibhelper_timerfd_support_handle handle);
+uint64_t glibhelper_timerfd_get_expirations(glibhelper_timerfd_support_handle handle);
+uint64_t glibhelper_timerfd_get_overrun(glibhelper_timerfd_support_handle handle);
+gboolean glibhelper_timerfd_rearm_at(glibhelper_timerfd_support_handle handle, uint64_t deadline, uint64_t interval);
+uint64_t glibhelper_timerfd_get_time(glibhelper_timerfd_support_handle handle);
+gboolean glibhelper_timerfd_get_jitter(glibhelper_timerfd_support_handle handle, glibhelper_histogram_stats *stats);
+uint64_t glibhelper_timerfd_get_jitter_percentile(glibhelper_timerfd_support_handle handle, double percentile);
+gboolean glibhelper_timerfd_reset_jitter(glibhelper_timerfd_support_handle handle);
 
 //-----------------------------------------------------------------------------
 #endif //#ifndef GLIBHELPER_TIMERFD_SUPPORT_H
@@ -0,0 +1,402 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-unix-socket-support-client-pool.c
+ * @brief	pooled unix domain socket seq packet client for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-unix-socket-support-managed-client.h"
+#include "glibhelper-unix-socket-support-client-pool.h"
+#include "glibhelper-stats.h"
+
+struct s_client_pool_member {
+	struct s_glibhelper_unix_socket_client_pool *parent;
+	glibhelper_unix_socket_managed_client client;
+	int outstanding;
+};
+
+struct s_glibhelper_unix_socket_client_pool {
+	struct s_glibhelper_client_pool_operation operation;
+	GMainContext *context;
+	void *userdata;
+	enum glibhelper_client_pool_policy policy;
+	struct s_client_pool_member *member;
+	int num_of_member;
+	int next;
+	// Statistics. Atomic, they are read by glibhelper_stats_dump in other threads. Connections are dumped as managed_client.
+	guint64 writes;	// Packets written or buffered
+	guint64 retries;	// Selected connection was busy and another one was tried
+	guint64 unconnected;	// Packets buffered while no connection was available
+	glibhelper_stats_entry stats_entry;
+};
+//-----------------------------------------------------------------------------
+static void client_pool_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_unix_socket_client_pool *pool = (struct s_glibhelper_unix_socket_client_pool*)userdata;
+
+	glibhelper_stats_print(fd, "  connections=%d policy=%d writes=%lu retries=%lu unconnected=%lu\n",
+			pool->num_of_member, (int)pool->policy, (unsigned long)__atomic_load_n(&pool->writes, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&pool->retries, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&pool->unconnected, __ATOMIC_RELAXED));
+}
+/**
+ * Get userdata from pool session handle.
+ * The userdata is set at glibhelper_create_client_pool.
+ *
+ * @param [in]	handle	Pool session handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_client_pool_get_userdata(glibhelper_pool_session_handle handle)
+{
+	struct s_client_pool_member *member = NULL;
+
+	if ( handle == NULL)
+		return NULL;
+
+	member = (struct s_client_pool_member*)handle;
+
+	return member->parent->userdata;
+}
+/**
+ * Get client pool handle from pool session handle.
+ *
+ * @param [in]	handle	Pool session handle
+ *
+ * @return glibhelper_unix_socket_client_pool
+ * @retval !NULL client pool handle.
+ * @retval NULL Illegal handle error.
+ */
+glibhelper_unix_socket_client_pool glibhelper_client_pool_from_session_handle(glibhelper_pool_session_handle handle)
+{
+	struct s_client_pool_member *member = NULL;
+
+	if ( handle == NULL)
+		return NULL;
+
+	member = (struct s_client_pool_member*)handle;
+
+	return member->parent;
+}
+/**
+ * Get number of outstanding requests of a pooled connection.
+ *
+ * @param [in]	handle	Pool session handle
+ *
+ * @return int
+ * @retval >=0 Number of written packets not yet answered.
+ * @retval <0 Illegal handle error.
+ */
+int glibhelper_client_pool_get_outstanding(glibhelper_pool_session_handle handle)
+{
+	struct s_client_pool_member *member = NULL;
+
+	if ( handle == NULL)
+		return -1;
+
+	member = (struct s_client_pool_member*)handle;
+
+	return member->outstanding;
+}
+/**
+ * Get number of connected connections in client pool.
+ *
+ * @param [in]	handle	Client pool handle
+ *
+ * @return int
+ * @retval >=0 Number of connected connections.
+ * @retval <0 Illegal handle error.
+ */
+int glibhelper_client_pool_get_connected_num(glibhelper_unix_socket_client_pool handle)
+{
+	struct s_glibhelper_unix_socket_client_pool *pool = NULL;
+	int num = 0;
+
+	if ( handle == NULL)
+		return -1;
+
+	pool = (struct s_glibhelper_unix_socket_client_pool*)handle;
+
+	for (int i=0; i < pool->num_of_member; i++) {
+		if (glibhelper_managed_client_is_connected(pool->member[i].client) == TRUE)
+			num++;
+	}
+
+	return num;
+}
+/**
+ * Read packet from pooled connection using glibhelper_pool_session_handle.
+ * A successful read completes one outstanding request of the connection.
+ *
+ * @param [in]	handle	Pool session handle
+ * @param [in]	buf Pointer to read buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes read.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_client_pool_socket_read(glibhelper_pool_session_handle handle, void *buf, size_t count)
+{
+	struct s_client_pool_member *member = NULL;
+	ssize_t ret = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	member = (struct s_client_pool_member*)handle;
+
+	ret = glibhelper_managed_client_socket_read(member->client, buf, count);
+	if (ret > 0 && member->outstanding > 0)
+		member->outstanding--;
+
+	return ret;
+}
+/**
+ * Select a pooled connection by write distribution policy.
+ *
+ * @param [in]	pool	Client pool
+ * @param [in]	skip	Already tried connection (-1 = none).
+ *
+ * @return int
+ * @retval >=0 Index of selected connection.
+ * @retval <0 No connected connection.
+ */
+static int client_pool_select(struct s_glibhelper_unix_socket_client_pool *pool, int skip)
+{
+	int selected = -1;
+	int index = 0;
+
+	for (int i=0; i < pool->num_of_member; i++) {
+		index = (pool->next + i) % pool->num_of_member;
+
+		if (index == skip)
+			continue;
+
+		if (glibhelper_managed_client_is_connected(pool->member[index].client) == FALSE)
+			continue;
+
+		if (pool->policy == GLIBHELPER_POOL_ROUND_ROBIN) {
+			selected = index;
+			break;
+		}
+
+		if (selected < 0 || pool->member[index].outstanding < pool->member[selected].outstanding)
+			selected = index;
+	}
+
+	if (selected >= 0)
+		pool->next = (selected + 1) % pool->num_of_member;
+
+	return selected;
+}
+/**
+ * Write packet to one of pooled connections.
+ * When selected connection can not accept the packet, other connection is tried.
+ * When no connection is established, the packet is buffered by round robin connection (sendqueue_max).
+ *
+ * @param [in]	handle	Client pool handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written or buffered.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_client_pool_socket_write(glibhelper_unix_socket_client_pool handle, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_client_pool *pool = NULL;
+	ssize_t ret = -1;
+	int index = -1;
+	int first = -1;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pool = (struct s_glibhelper_unix_socket_client_pool*)handle;
+
+	index = client_pool_select(pool, -1);
+	if (index < 0) {
+		// No connection. Buffer to a connection for reconnect.
+		index = pool->next;
+		pool->next = (pool->next + 1) % pool->num_of_member;
+
+		ret = glibhelper_managed_client_socket_write(pool->member[index].client, buf, count);
+		if (ret >= 0) {
+			pool->member[index].outstanding++;
+			__atomic_fetch_add(&pool->unconnected, 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&pool->writes, 1, __ATOMIC_RELAXED);
+		}
+
+		return ret;
+	}
+	first = index;
+
+	ret = glibhelper_managed_client_socket_write(pool->member[index].client, buf, count);
+	if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)) {
+		// Selected connection is busy, try another one.
+		__atomic_fetch_add(&pool->retries, 1, __ATOMIC_RELAXED);
+		index = client_pool_select(pool, first);
+		if (index >= 0)
+			ret = glibhelper_managed_client_socket_write(pool->member[index].client, buf, count);
+	}
+
+	if (ret >= 0) {
+		pool->member[index].outstanding++;
+		__atomic_fetch_add(&pool->writes, 1, __ATOMIC_RELAXED);
+	}
+
+	return ret;
+}
+//-----------------------------------------------------------------------------
+static void client_pool_connected_cb(glibhelper_managed_session_handle session)
+{
+	struct s_client_pool_member *member = NULL;
+
+	member = (struct s_client_pool_member*)glibhelper_managed_client_get_userdata(session);
+
+	if (member->parent->operation.connected != NULL)
+		member->parent->operation.connected((glibhelper_pool_session_handle)member);
+}
+//-----------------------------------------------------------------------------
+static gboolean client_pool_receive_cb(glibhelper_managed_session_handle session)
+{
+	struct s_client_pool_member *member = NULL;
+	gboolean bret = TRUE;
+
+	member = (struct s_client_pool_member*)glibhelper_managed_client_get_userdata(session);
+
+	if (member->parent->operation.receive != NULL)
+		bret = member->parent->operation.receive((glibhelper_pool_session_handle)member);
+
+	return bret;
+}
+//-----------------------------------------------------------------------------
+static void client_pool_disconnected_cb(glibhelper_managed_session_handle session)
+{
+	struct s_client_pool_member *member = NULL;
+
+	member = (struct s_client_pool_member*)glibhelper_managed_client_get_userdata(session);
+
+	// Responses for outstanding requests will not come.
+	member->outstanding = 0;
+
+	if (member->parent->operation.disconnected != NULL)
+		member->parent->operation.disconnected((glibhelper_pool_session_handle)member);
+}
+/**
+ * Create client pool. It opens num_of_connection managed connections to the same server.
+ * All connections share one set of callbacks, and each connection reconnects automatically.
+ *
+ * @param [in]	handle	Pointer to store created client pool handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Client pool configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_client_pool(glibhelper_unix_socket_client_pool *handle, GMainContext *context, glibhelper_client_pool_config *config, void* userdata)
+{
+	struct s_glibhelper_unix_socket_client_pool *pool = NULL;
+	glibhelper_managed_client_config mcfg;
+	gboolean bret = FALSE;
+
+	if (handle == NULL || config == NULL || config->num_of_connection <= 0)
+		return FALSE;
+
+	pool = (struct s_glibhelper_unix_socket_client_pool*)g_malloc(sizeof(struct s_glibhelper_unix_socket_client_pool));
+	if (pool == NULL)
+		return FALSE;
+	memset(pool,0,sizeof(struct s_glibhelper_unix_socket_client_pool));
+
+	pool->member = (struct s_client_pool_member*)g_malloc(sizeof(struct s_client_pool_member) * config->num_of_connection);
+	if (pool->member == NULL)
+		goto errorout;
+	memset(pool->member,0,sizeof(struct s_client_pool_member) * config->num_of_connection);
+
+	memset(&mcfg, 0, sizeof(mcfg));
+	mcfg.operation.connected = client_pool_connected_cb;
+	mcfg.operation.receive = client_pool_receive_cb;
+	mcfg.operation.disconnected = client_pool_disconnected_cb;
+	memcpy(mcfg.socket_name, config->socket_name, sizeof(mcfg.socket_name));
+	mcfg.receive_budget = config->receive_budget;
+	mcfg.backoff_initial = config->backoff_initial;
+	mcfg.backoff_max = config->backoff_max;
+	mcfg.sendqueue_max = config->sendqueue_max;
+
+	for (int i=0; i < config->num_of_connection; i++) {
+		pool->member[i].parent = pool;
+		bret = glibhelper_create_managed_client(&pool->member[i].client, context, &mcfg, &pool->member[i]);
+		if (bret == FALSE)
+			goto errorout;
+		pool->num_of_member++;
+	}
+
+	pool->operation = config->operation;
+	pool->context = context;
+	pool->userdata = userdata;
+	pool->policy = config->policy;
+	pool->next = 0;
+
+	pool->stats_entry = glibhelper_stats_register("client_pool", client_pool_stats_dump, pool);
+
+	(*handle) = (glibhelper_unix_socket_client_pool)(pool);
+
+	return TRUE;
+
+errorout:
+	for (int i=0; i < pool->num_of_member; i++)
+		(void)glibhelper_terminate_managed_client(pool->member[i].client);
+
+	g_free(pool->member);
+	g_free(pool);
+
+	return FALSE;
+}
+/**
+ * Terminate client pool and all pooled connections.
+ * Do not call this function in callbacks of the same client pool.
+ *
+ * @param [in]	handle	Client pool handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_client_pool(glibhelper_unix_socket_client_pool handle)
+{
+	struct s_glibhelper_unix_socket_client_pool *pool = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	pool = (struct s_glibhelper_unix_socket_client_pool*)handle;
+
+	glibhelper_stats_unregister(pool->stats_entry);
+
+	for (int i=0; i < pool->num_of_member; i++)
+		(void)glibhelper_terminate_managed_client(pool->member[i].client);
+
+	g_free(pool->member);
+	g_free(pool);
+
+	return TRUE;
+}
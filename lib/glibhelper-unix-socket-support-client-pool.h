@@ -0,0 +1,64 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-unix-socket-support-client-pool.h
+ * @brief	header for glibhelper-unix-socket-support-client-pool
+ */
+#ifndef GLIBHELPER_UINX_SOCKET_SUPPORT_CLIENT_POOL_H
+#define GLIBHELPER_UINX_SOCKET_SUPPORT_CLIENT_POOL_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_unix_socket_client_pool;
+typedef struct s_glibhelper_unix_socket_client_pool *glibhelper_unix_socket_client_pool;
+
+typedef void* glibhelper_pool_session_handle;
+
+
+typedef void (*fp_connected_callback_pool)(glibhelper_pool_session_handle session); 
+typedef gboolean (*fp_receive_callback_pool)(glibhelper_pool_session_handle session); 
+typedef void (*fp_disconnected_callback_pool)(glibhelper_pool_session_handle session); 
+
+struct s_glibhelper_client_pool_operation {
+	fp_connected_callback_pool connected; /**< Callbuck for one pooled connection established. */
+	fp_receive_callback_pool receive; /**< Callbuck for packet receive from any pooled connection. */
+	fp_disconnected_callback_pool disconnected; /**< Callbuck for one pooled connection lost. It reconnects automatically. */
+};
+
+/** Write distribution policy of client pool. */
+enum glibhelper_client_pool_policy {
+	//! Use connections in turn.
+	GLIBHELPER_POOL_ROUND_ROBIN = 0,
+
+	//! Use the connection with the fewest outstanding requests (written packets not yet answered by a read).
+	GLIBHELPER_POOL_LEAST_OUTSTANDING = 1,
+};
+
+/** glibhelper_client_pool_config.*/
+typedef struct s_glibhelper_client_pool_config {
+	struct s_glibhelper_client_pool_operation operation; /**< client pool event handler. */
+	char socket_name[92]; /**< server socket name. abs name or socket file name. */
+	int num_of_connection; /**< number of connections to the server. */
+	enum glibhelper_client_pool_policy policy; /**< write distribution policy. */
+	int receive_budget; /**< drain mode : max receive callbacks per wakeup (0 or 1 = one callback per wakeup). */
+	uint32_t backoff_initial; /**< first reconnect delay (ms). 0 = default. */
+	uint32_t backoff_max; /**< upper limit of reconnect delay (ms). 0 = default. */
+	int sendqueue_max; /**< max number of packets buffered per connection. 0 = no buffering. */
+} glibhelper_client_pool_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_client_pool(glibhelper_unix_socket_client_pool *handle, GMainContext *context, glibhelper_client_pool_config *config, void* userdata);
+gboolean glibhelper_terminate_client_pool(glibhelper_unix_socket_client_pool handle);
+int glibhelper_client_pool_get_connected_num(glibhelper_unix_socket_client_pool handle);
+int glibhelper_client_pool_get_outstanding(glibhelper_pool_session_handle handle);
+void* glibhelper_client_pool_get_userdata(glibhelper_pool_session_handle handle);
+glibhelper_unix_socket_client_pool glibhelper_client_pool_from_session_handle(glibhelper_pool_session_handle handle);
+ssize_t glibhelper_client_pool_socket_read(glibhelper_pool_session_handle handle, void *buf, size_t count);
+ssize_t glibhelper_client_pool_socket_write(glibhelper_unix_socket_client_pool handle, void *buf, size_t count);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_UINX_SOCKET_SUPPORT_CLIENT_POOL_H
@@ -18,6 +18,7 @@
 
 #include "glibhelper-unix-socket-support-util.h"
 #include "glibhelper-unix-socket-support.h"
+#include "glibhelper-stats.h"
 
 struct s_gelibhelper_io_channel {
 	struct s_glibhelper_unix_socket_client_support *parent;
@@ -30,7 +31,23 @@ struct s_glibhelper_unix_socket_client_support {
 	struct s_glibhelper_client_socket_operation operation;
 	GMainContext *context;
 	void *userdata;
+	int receive_budget;
+	enum glibhelper_receive_state rx_state;
+	glibhelper_uring uring;	// NULL = poll backend
+	glibhelper_uring_request rx_request;	// io_uring backend : multishot receive
+	const void *rx_packet;	// io_uring backend : received packet not yet read in receive callback
+	size_t rx_count;
+	guint64 receives;	// Statistics : receive callbacks. Atomic, read by glibhelper_stats_dump in other threads.
+	glibhelper_stats_entry stats_entry;
 };
+//-----------------------------------------------------------------------------
+static void client_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_unix_socket_client_support *helper = (struct s_glibhelper_unix_socket_client_support*)userdata;
+
+	glibhelper_stats_print(fd, "  backend=%s fd=%d receives=%lu\n", (helper->uring != NULL) ? "io_uring" : "poll",
+			g_io_channel_unix_get_fd(helper->cli.gio_source), (unsigned long)__atomic_load_n(&helper->receives, __ATOMIC_RELAXED));
+}
 
 /**
  * Get session socket fd from client session handle.
@@ -98,6 +115,21 @@ ssize_t glibhelper_client_socket_read(glibhelper_client_session_handle handle, v
 		return -1;
 	}
 
+	helper = (struct s_glibhelper_unix_socket_client_support*)handle;
+	if (helper->uring != NULL) {
+		// io_uring backend. The packet was received by the kernel before the receive callback.
+		if (helper->rx_packet == NULL) {
+			helper->rx_state = GLIBHELPER_RX_DRAINED;
+			errno = EAGAIN;
+			return -1;
+		}
+		ret = (ssize_t)MIN(count, helper->rx_count);
+		memcpy(buf, helper->rx_packet, (size_t)ret);
+		helper->rx_packet = NULL;
+		helper->rx_state = GLIBHELPER_RX_READ;
+		return ret;
+	}
+
 	fd = glibhelper_client_get_fd(handle);
 	if (fd < 0) {
 		errno = EINVAL;
@@ -108,6 +140,9 @@ ssize_t glibhelper_client_socket_read(glibhelper_client_session_handle handle, v
 		ret = read(fd, buf, count);
 	} while((ret == -1) && (errno == EINTR));
 
+	// Update drain mode state. A zero length read or EAGAIN means no more queued packet.
+	helper->rx_state = (ret > 0) ? GLIBHELPER_RX_READ : GLIBHELPER_RX_DRAINED;
+
 	return ret;
 }
 /**
@@ -145,7 +180,79 @@ ssize_t glibhelper_client_socket_write(glibhelper_client_session_handle handle,
 	return ret;
 
 }
+/**
+ * Write multiple packets to socket using glibhelper_client_session_handle.
+ * The packets are submitted by one sendmmsg call per 64 packets.
+ *
+ * @param [in]	handle	Client session handle
+ * @param [in]	packets	Array of packet descriptor.
+ * @param [in]	num	Number of packets.
+ *
+ * @return int
+ * @retval >=0 Number of packets sent. When it is less than num, errno shows the reason (EAGAIN etc.) and
+ *             the caller can resume from packets[return value].
+ * @retval <0 error, no packet was sent (refer to error no).
+ */
+int glibhelper_client_socket_write_batch(glibhelper_client_session_handle handle, glibhelper_socket_packet *packets, int num)
+{
+	int fd = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = glibhelper_client_get_fd(handle);
+	if (fd < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return glibhelper_socket_write_batch(fd, packets, num);
+}
+
+/**
+ * Receive completion in io_uring backend. One packet is passed to the receive callback per completion.
+ *
+ * @param [in]	request	Receive request
+ * @param [in]	res	Number of bytes, <0 = -errno.
+ * @param [in]	buf	Received packet, NULL = closed by peer.
+ * @param [in]	data	Client socket
+ *
+ * @return gboolean
+ * @retval TRUE Continue receive.
+ * @retval FALSE Receive callback requested to stop.
+ */
+static gboolean client_uring_event(glibhelper_uring_request request, int res, void *buf, void *data)
+{
+	struct s_glibhelper_unix_socket_client_support *helper = (struct s_glibhelper_unix_socket_client_support*)data;
+	gboolean bret = TRUE;
+
+	if (res < 0 || buf == NULL) {	 //Server side socket was closed or error. Zero length packet is received.
+		// Cleanup session
+		if (helper->operation.destroyed_session != NULL)
+			helper->operation.destroyed_session((glibhelper_client_session_handle)helper);
+
+		glibhelper_stats_unregister(helper->stats_entry);
+		glibhelper_uring_cancel(helper->rx_request);
+		g_io_channel_unref(helper->cli.gio_source);
+		g_free(helper);
+		return TRUE;
+	}
+
+	if (helper->operation.receive != NULL) {
+		helper->rx_packet = buf;
+		helper->rx_count = (size_t)res;
+		helper->rx_state = GLIBHELPER_RX_NOT_READ;
+		__atomic_fetch_add(&helper->receives, 1, __ATOMIC_RELAXED);
+		bret = helper->operation.receive((glibhelper_client_session_handle)helper);
+		helper->rx_packet = NULL;	// Not read packet is discarded
+	}
+	if (bret == FALSE)
+		helper->rx_request = NULL;	// Released by the ring
 
+	return bret;
+}
 /**
  *
  *
@@ -176,12 +283,21 @@ static gboolean clientchannel_socket_event (GIOChannel *source,
 		if (helper->operation.destroyed_session != NULL)
 			helper->operation.destroyed_session((glibhelper_client_session_handle)helper);
 
+		glibhelper_stats_unregister(helper->stats_entry);
 		g_source_destroy(helper->cli.event_source);
 		g_io_channel_unref(helper->cli.gio_source);
 		g_free(helper);
 	} else if ((condition & G_IO_IN) != 0) {	// receive data
-		if (helper->operation.receive != NULL)
-			bret = helper->operation.receive((glibhelper_client_session_handle)helper);
+		if (helper->operation.receive != NULL) {
+			// In drain mode, call receive callback until the socket queue is empty or budget is exhausted.
+			for (int i=0; i < helper->receive_budget || i == 0; i++) {
+				helper->rx_state = GLIBHELPER_RX_NOT_READ;
+				__atomic_fetch_add(&helper->receives, 1, __ATOMIC_RELAXED);
+				bret = helper->operation.receive((glibhelper_client_session_handle)helper);
+				if (bret == FALSE || helper->rx_state != GLIBHELPER_RX_READ)
+					break;
+			}
+		}
 	} else {	//	G_IO_NVAL or undefined
 		bret = FALSE;	// When this event return FALSE, this event watch is disabled
 	}
@@ -250,22 +366,34 @@ gboolean glibhelper_connect_socket(glibhelper_unix_socket_client_support *handle
 	g_io_channel_set_close_on_unref(gcliio,TRUE);	// fd close on final unref
 	clifd = -1; // The fd close automatically, do not close myself.
 
-	gclisource = g_io_create_watch(gcliio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
-	if (gclisource == NULL)
-		goto errorout;
-
-	g_source_set_callback(gclisource, (GSourceFunc)clientchannel_socket_event,(gpointer)helper, NULL);
-
-	id = g_source_attach(gclisource, context);
-
-	g_source_unref(gclisource);
-
 	helper->operation = config->operation;
 	helper->cli.gio_source = gcliio;
-	helper->cli.event_source = gclisource;
 	helper->cli.parent = helper;
 	helper->context = context;
 	helper->userdata = userdata;
+	helper->receive_budget = config->receive_budget;
+	helper->uring = config->uring;
+
+	if (helper->uring != NULL) {
+		// io_uring backend : multishot receive.
+		helper->rx_request = glibhelper_uring_recv(helper->uring, g_io_channel_unix_get_fd(gcliio), client_uring_event, helper);
+		if (helper->rx_request == NULL)
+			goto errorout;
+	} else {
+		gclisource = g_io_create_watch(gcliio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+		if (gclisource == NULL)
+			goto errorout;
+
+		g_source_set_callback(gclisource, (GSourceFunc)clientchannel_socket_event,(gpointer)helper, NULL);
+
+		id = g_source_attach(gclisource, context);
+
+		g_source_unref(gclisource);
+
+		helper->cli.event_source = gclisource;
+	}
+
+	helper->stats_entry = glibhelper_stats_register("client_socket", client_stats_dump, helper);
 
 	(*handle) = (glibhelper_unix_socket_client_support)(helper);
 
@@ -303,8 +431,13 @@ gboolean glibhelper_terminate_client_socket(glibhelper_unix_socket_client_suppor
 
 	helper = (struct s_glibhelper_unix_socket_client_support *)handle;
 
+	glibhelper_stats_unregister(helper->stats_entry);
+
 	// Destroy server socket
-	g_source_destroy(helper->cli.event_source);
+	if (helper->rx_request != NULL)
+		glibhelper_uring_cancel(helper->rx_request);
+	else if (helper->cli.event_source != NULL)
+		g_source_destroy(helper->cli.event_source);
 	g_io_channel_unref(helper->cli.gio_source);
 	g_free(helper);
 
@@ -43,6 +43,8 @@ struct s_glibhelper_unix_socket_internal_support {
 	int primary_fd;
 	int secondary_fd;
 	gboolean secondary_fd_leased;
+	int receive_budget;
+	enum glibhelper_receive_state rx_state;
 };
 /**
  * Get session socket fd from internal session handle.
@@ -120,6 +122,10 @@ ssize_t glibhelper_internal_socket_read(glibhelper_internal_session_handle handl
 		ret = read(fd, buf, count);
 	} while((ret == -1) && (errno == EINTR));
 
+	// Update drain mode state. A zero length read or EAGAIN means no more queued packet.
+	helper = (struct s_glibhelper_unix_socket_internal_support*)handle;
+	helper->rx_state = (ret > 0) ? GLIBHELPER_RX_READ : GLIBHELPER_RX_DRAINED;
+
 	return ret;
 }
 /**
@@ -157,6 +163,36 @@ ssize_t glibhelper_internal_socket_write(glibhelper_internal_session_handle hand
 	return ret;
 
 }
+/**
+ * Write multiple packets to socket using glibhelper_internal_session_handle.
+ * The packets are submitted by one sendmmsg call per 64 packets.
+ *
+ * @param [in]	handle	Internal session handle
+ * @param [in]	packets	Array of packet descriptor.
+ * @param [in]	num	Number of packets.
+ *
+ * @return int
+ * @retval >=0 Number of packets sent. When it is less than num, errno shows the reason (EAGAIN etc.) and
+ *             the caller can resume from packets[return value].
+ * @retval <0 error, no packet was sent (refer to error no).
+ */
+int glibhelper_internal_socket_write_batch(glibhelper_internal_session_handle handle, glibhelper_socket_packet *packets, int num)
+{
+	int fd = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = glibhelper_internal_get_fd(handle);
+	if (fd < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return glibhelper_socket_write_batch(fd, packets, num);
+}
 
 /**
  *
@@ -198,8 +234,15 @@ static gboolean internalchannel_socket_event (GIOChannel *source,
 
 		g_free(helper);
 	} else if ((condition & G_IO_IN) != 0) {	// Receive data
-		if (helper->operation.receive != NULL)
-			bret = helper->operation.receive((glibhelper_client_session_handle)helper);
+		if (helper->operation.receive != NULL) {
+			// In drain mode, call receive callback until the socket queue is empty or budget is exhausted.
+			for (int i=0; i < helper->receive_budget || i == 0; i++) {
+				helper->rx_state = GLIBHELPER_RX_NOT_READ;
+				bret = helper->operation.receive((glibhelper_client_session_handle)helper);
+				if (bret == FALSE || helper->rx_state != GLIBHELPER_RX_READ)
+					break;
+			}
+		}
 	} else {	//	G_IO_NVAL or undefined
 		bret = FALSE;	// When this event return FALSE, this event watch is disabled
 	}
@@ -271,6 +314,7 @@ gboolean glibhelper_create_internal_socket(glibhelper_unix_socket_internal_suppo
 	helper->io.parent = helper;
 	helper->context = context;
 	helper->userdata = userdata;
+	helper->receive_budget = config->receive_budget;
 	helper->socketbuf_size = config->socketbuf_size;
 	helper->side = PRIMARY_SIDE;
 
@@ -353,6 +397,7 @@ gboolean glibhelper_bind_secondary_internal_socket(glibhelper_unix_socket_intern
 	secondary_helper->io.parent = secondary_helper;
 	secondary_helper->context = context;
 	secondary_helper->userdata = userdata;
+	secondary_helper->receive_budget = config->receive_budget;
 	secondary_helper->socketbuf_size = config->socketbuf_size;
 	secondary_helper->side = SECOUNDARY_SIDE;
 
@@ -0,0 +1,842 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-unix-socket-support-managed-client.c
+ * @brief	unix domain socket seq packet client with automatic reconnect for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-unix-socket-support-managed-client.h"
+#include "glibhelper-stats.h"
+
+#define MANAGED_CLIENT_BACKOFF_INITIAL_DEFAULT (100)	// ms
+#define MANAGED_CLIENT_BACKOFF_MAX_DEFAULT (10000)	// ms
+#define MANAGED_CLIENT_RTT_WEIGHT (8)	// EWMA weight 1/8 for round trip time
+
+enum managed_client_state {
+	//! Not connected. Waiting reconnect timer.
+	MANAGED_CLIENT_DISCONNECTED = 0,
+
+	//! Connected to server.
+	MANAGED_CLIENT_CONNECTED = 1,
+};
+
+struct s_managed_client_packet {
+	size_t size;
+	uint8_t data[];
+};
+
+struct s_glibhelper_unix_socket_managed_client {
+	struct s_glibhelper_managed_client_operation operation;
+	GMainContext *context;
+	void *userdata;
+	enum managed_client_state state;
+	GIOChannel *gio_source;
+	GSource *event_source;
+	GSource *out_source;
+	GSource *retry_source;
+	GQueue *sendqueue;
+	int sendqueue_max;
+	int receive_budget;
+	enum glibhelper_receive_state rx_state;
+	uint32_t backoff_initial;
+	uint32_t backoff_max;
+	uint32_t backoff_current;
+	char endpoint[GLIBHELPER_MANAGED_CLIENT_ENDPOINT_MAX][92];
+	int64_t endpoint_rtt[GLIBHELPER_MANAGED_CLIENT_ENDPOINT_MAX];
+	int num_of_endpoint;
+	int current;
+	int failover_from;
+	gboolean prefer_lowest_rtt;
+	int64_t request_time;
+	// Statistics. Atomic, they are read by glibhelper_stats_dump in other threads.
+	guint64 connects;	// Established connections
+	guint64 disconnects;	// Connections closed by server
+	guint64 connect_failures;	// Trials of all endpoints failed, reconnect is scheduled
+	guint64 queued;	// Packets buffered in the send queue
+	guint64 queue_full;	// Packets rejected by full send queue
+	glibhelper_stats_entry stats_entry;
+};
+
+static void managed_client_schedule_reconnect(struct s_glibhelper_unix_socket_managed_client *helper);
+static gboolean managed_client_try_connect(gpointer data);
+//-----------------------------------------------------------------------------
+static void managed_client_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = (struct s_glibhelper_unix_socket_managed_client*)userdata;
+	guint64 connects = __atomic_load_n(&helper->connects, __ATOMIC_RELAXED);
+	guint64 disconnects = __atomic_load_n(&helper->disconnects, __ATOMIC_RELAXED);
+
+	glibhelper_stats_print(fd, "  endpoints=%d connected=%d connects=%lu disconnects=%lu connect_failures=%lu queued=%lu queue_full=%lu\n",
+			helper->num_of_endpoint, (connects > disconnects) ? 1 : 0, (unsigned long)connects, (unsigned long)disconnects,
+			(unsigned long)__atomic_load_n(&helper->connect_failures, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&helper->queued, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&helper->queue_full, __ATOMIC_RELAXED));
+}
+/**
+ * Get session socket fd from managed client session handle.
+ *
+ * @param [in]	handle	Managed client session handle
+ *
+ * @return int
+ * @retval >=0 fd.
+ * @retval <0 error (Illegal handle or not connected)
+ */
+int glibhelper_managed_client_get_fd(glibhelper_managed_session_handle handle)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	int fd = -1;
+
+	if ( handle == NULL)
+		return -1;
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+	if (helper->gio_source == NULL)
+		return -1;
+
+	fd = g_io_channel_unix_get_fd (helper->gio_source);
+
+	return fd;
+}
+/**
+ * Get userdata from managed client session handle.
+ * The userdata is set at glibhelper_create_managed_client.
+ *
+ * @param [in]	handle	Managed client session handle
+ *
+ * @return void*
+ * @retval !NULL userdata.
+ * @retval NULL userdata is NULL or Illegal handle error.
+ */
+void* glibhelper_managed_client_get_userdata(glibhelper_managed_session_handle handle)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+
+	if ( handle == NULL)
+		return NULL;
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+
+	return helper->userdata;
+}
+/**
+ * Get connection state of managed client.
+ *
+ * @param [in]	handle	Managed client session handle
+ *
+ * @return gboolean
+ * @retval TRUE Connected to server.
+ * @retval FALSE Not connected or Illegal handle error.
+ */
+gboolean glibhelper_managed_client_is_connected(glibhelper_managed_session_handle handle)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+
+	if ( handle == NULL)
+		return FALSE;
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+
+	return (helper->state == MANAGED_CLIENT_CONNECTED) ? TRUE : FALSE;
+}
+/**
+ * Get index of connected endpoint.
+ *
+ * @param [in]	handle	Managed client session handle
+ *
+ * @return int
+ * @retval >=0 Index of connected endpoint. When num_of_endpoint is 0, it is always 0 (socket_name).
+ * @retval <0 Not connected or Illegal handle error.
+ */
+int glibhelper_managed_client_get_endpoint(glibhelper_managed_session_handle handle)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+
+	if ( handle == NULL)
+		return -1;
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+	if (helper->state != MANAGED_CLIENT_CONNECTED)
+		return -1;
+
+	return helper->current;
+}
+/**
+ * Get measured round trip time of endpoint.
+ * Round trip time is measured from a write to the next successful read (request/response),
+ * and it is smoothed by EWMA.
+ *
+ * @param [in]	handle	Managed client session handle
+ * @param [in]	index	Index of endpoint.
+ *
+ * @return int64_t
+ * @retval >0 Round trip time (us).
+ * @retval 0 Not measured yet.
+ * @retval <0 Arg error.
+ */
+int64_t glibhelper_managed_client_get_endpoint_rtt(glibhelper_managed_session_handle handle, int index)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+
+	if ( handle == NULL)
+		return -1;
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+	if (index < 0 || index >= helper->num_of_endpoint)
+		return -1;
+
+	return helper->endpoint_rtt[index];
+}
+/**
+ * Update round trip time of connected endpoint.
+ *
+ * @param [in]	helper	Managed client
+ * @param [in]	is_read	TRUE = packet was read, FALSE = packet was written.
+ */
+static void managed_client_update_rtt(struct s_glibhelper_unix_socket_managed_client *helper, gboolean is_read)
+{
+	int64_t now = 0;
+	int64_t sample = 0;
+
+	if (helper->prefer_lowest_rtt == FALSE)
+		return;
+
+	now = g_get_monotonic_time();
+
+	if (is_read == FALSE) {
+		if (helper->request_time == 0)
+			helper->request_time = now;
+		return;
+	}
+
+	if (helper->request_time == 0)
+		return;	// Not a response (ex. broadcast from server)
+
+	sample = now - helper->request_time;
+	if (sample <= 0)
+		sample = 1;
+	helper->request_time = 0;
+
+	if (helper->endpoint_rtt[helper->current] == 0)
+		helper->endpoint_rtt[helper->current] = sample;
+	else
+		helper->endpoint_rtt[helper->current] += (sample - helper->endpoint_rtt[helper->current]) / MANAGED_CLIENT_RTT_WEIGHT;
+}
+/**
+ * Read packet from socket using glibhelper_managed_session_handle.
+ *
+ * @param [in]	handle	Managed client session handle
+ * @param [in]	buf Pointer to read buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes read.
+ * @retval <0 error (refer to error no).
+ */
+ssize_t glibhelper_managed_client_socket_read(glibhelper_managed_session_handle handle, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	ssize_t ret = -1;
+	int fd = -1;
+
+	if ( handle == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = glibhelper_managed_client_get_fd(handle);
+	if (fd < 0) {
+		errno = ENOTCONN;
+		return -1;
+	}
+
+	do {
+		ret = read(fd, buf, count);
+	} while((ret == -1) && (errno == EINTR));
+
+	// Update drain mode state. A zero length read or EAGAIN means no more queued packet.
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+	helper->rx_state = (ret > 0) ? GLIBHELPER_RX_READ : GLIBHELPER_RX_DRAINED;
+
+	if (ret > 0)
+		managed_client_update_rtt(helper, TRUE);
+
+	return ret;
+}
+/**
+ * Add packet to send queue.
+ *
+ * @param [in]	helper	Managed client
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return gboolean
+ * @retval TRUE Queued.
+ * @retval FALSE Queue is full.
+ */
+static gboolean managed_client_enqueue(struct s_glibhelper_unix_socket_managed_client *helper, void *buf, size_t count)
+{
+	struct s_managed_client_packet *packet = NULL;
+
+	if (g_queue_get_length(helper->sendqueue) >= (guint)helper->sendqueue_max)
+		return FALSE;
+
+	packet = (struct s_managed_client_packet*)g_malloc(sizeof(struct s_managed_client_packet) + count);
+	if (packet == NULL)
+		return FALSE;
+
+	packet->size = count;
+	memcpy(packet->data, buf, count);
+
+	g_queue_push_tail(helper->sendqueue, packet);
+
+	return TRUE;
+}
+/**
+ * Clear send queue.
+ *
+ * @param [in]	helper	Managed client
+ */
+static void managed_client_clear_queue(struct s_glibhelper_unix_socket_managed_client *helper)
+{
+	struct s_managed_client_packet *packet = NULL;
+
+	while ((packet = (struct s_managed_client_packet*)g_queue_pop_head(helper->sendqueue)) != NULL)
+		g_free(packet);
+}
+/**
+ * Event handler for writable socket. It flushes the send queue.
+ *
+ * @param [in]	source	Pointor for active GIOChannel
+ * @param [in]	condition	I/O event condition.
+ * @param [in]	data	Pointer for managed client
+ *
+ * @return gboolean
+ * @retval TRUE Send queue remains.
+ * @retval FALSE Send queue is empty or error. This watch is disabled.
+ */
+static gboolean managed_client_out_event (GIOChannel *source,
+								GIOCondition condition,
+								gpointer data)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	struct s_managed_client_packet *packet = NULL;
+	ssize_t ret = -1;
+	int fd = -1;
+
+	if (source == NULL || data == NULL)
+		return FALSE;// Arg error -> Stop callback Fail safe
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)data;
+	fd = g_io_channel_unix_get_fd (source);
+
+	if ((condition & G_IO_OUT) == 0) {
+		// Error and hangup are handled by receive watch.
+		helper->out_source = NULL;
+		return FALSE;
+	}
+
+	while ((packet = (struct s_managed_client_packet*)g_queue_peek_head(helper->sendqueue)) != NULL) {
+		do {
+			ret = write(fd, packet->data, packet->size);
+		} while((ret == -1) && (errno == EINTR));
+
+		if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return TRUE;	// Wait next writable event
+
+			// Connection error. Keep queue for reconnect, hangup is handled by receive watch.
+			break;
+		}
+
+		(void)g_queue_pop_head(helper->sendqueue);
+		g_free(packet);
+		managed_client_update_rtt(helper, FALSE);
+	}
+
+	helper->out_source = NULL;
+
+	return FALSE;
+}
+/**
+ * Start writable watch for send queue flush.
+ *
+ * @param [in]	helper	Managed client
+ */
+static void managed_client_start_flush(struct s_glibhelper_unix_socket_managed_client *helper)
+{
+	GSource *gout = NULL;
+
+	if (helper->out_source != NULL || helper->gio_source == NULL)
+		return;
+
+	if (g_queue_is_empty(helper->sendqueue) == TRUE)
+		return;
+
+	gout = g_io_create_watch(helper->gio_source, (G_IO_OUT | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+	if (gout == NULL)
+		return;
+
+	g_source_set_callback(gout, (GSourceFunc)managed_client_out_event, (gpointer)helper, NULL);
+	(void)g_source_attach(gout, helper->context);
+	g_source_unref(gout);
+
+	helper->out_source = gout;
+}
+/**
+ * Write packet to socket using glibhelper_managed_session_handle.
+ * When the client is disconnected or socket buffer is full, the packet is buffered up to sendqueue_max
+ * and sent in order after (re)connect.
+ *
+ * @param [in]	handle	Managed client session handle
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes written or buffered.
+ * @retval <0 error (refer to error no). ENOBUFS means send queue is full.
+ */
+ssize_t glibhelper_managed_client_socket_write(glibhelper_managed_session_handle handle, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	ssize_t ret = -1;
+	int fd = -1;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)handle;
+
+	// Keep packet order. When some packets are queued, new packet shall be queued too.
+	if (helper->state == MANAGED_CLIENT_CONNECTED && g_queue_is_empty(helper->sendqueue) == TRUE) {
+		fd = glibhelper_managed_client_get_fd(handle);
+
+		do {
+			ret = write(fd, buf, count);
+		} while((ret == -1) && (errno == EINTR));
+
+		if (ret >= 0) {
+			managed_client_update_rtt(helper, FALSE);
+			return ret;
+		}
+
+		if (!(errno == EAGAIN || errno == EWOULDBLOCK || errno == EPIPE || errno == ECONNRESET))
+			return ret;
+	}
+
+	if (managed_client_enqueue(helper, buf, count) == FALSE) {
+		__atomic_fetch_add(&helper->queue_full, 1, __ATOMIC_RELAXED);
+		errno = ENOBUFS;
+		return -1;
+	}
+	__atomic_fetch_add(&helper->queued, 1, __ATOMIC_RELAXED);
+
+	if (helper->state == MANAGED_CLIENT_CONNECTED)
+		managed_client_start_flush(helper);
+
+	return (ssize_t)count;
+}
+/**
+ * Cleanup current connection.
+ *
+ * @param [in]	helper	Managed client
+ */
+static void managed_client_close(struct s_glibhelper_unix_socket_managed_client *helper)
+{
+	if (helper->out_source != NULL) {
+		g_source_destroy(helper->out_source);
+		helper->out_source = NULL;
+	}
+
+	if (helper->event_source != NULL) {
+		g_source_destroy(helper->event_source);
+		helper->event_source = NULL;
+	}
+
+	if (helper->gio_source != NULL) {
+		g_io_channel_unref(helper->gio_source);
+		helper->gio_source = NULL;
+	}
+
+	helper->state = MANAGED_CLIENT_DISCONNECTED;
+	helper->request_time = 0;
+}
+/**
+ * Event handler for connected socket.
+ *
+ * @param [in]	source	Pointor for active GIOChannel
+ * @param [in]	condition	I/O event condition.
+ * @param [in]	data	Pointer for managed client
+ *
+ * @return gboolean
+ * @retval TRUES Success callback or non abnormal error.
+ * @retval FALSE Connection was closed or critical error. Callback stop.
+ */
+static gboolean managed_client_socket_event (GIOChannel *source,
+								GIOCondition condition,
+								gpointer data)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	gboolean bret = TRUE;
+
+	if (source == NULL || data == NULL)
+		return FALSE;// Arg error -> Stop callback Fail safe
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)data;
+
+	if ((condition & G_IO_IN) != 0) {	// receive data
+		if (helper->operation.receive != NULL) {
+			// In drain mode, call receive callback until the socket queue is empty or budget is exhausted.
+			for (int i=0; i < helper->receive_budget || i == 0; i++) {
+				helper->rx_state = GLIBHELPER_RX_NOT_READ;
+				bret = helper->operation.receive((glibhelper_managed_session_handle)helper);
+				if (bret == FALSE || helper->rx_state != GLIBHELPER_RX_READ)
+					break;
+			}
+		}
+	}
+
+	if ((condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) != 0 || bret == FALSE) {	 //Server side socket was closed.
+		managed_client_close(helper);
+		__atomic_fetch_add(&helper->disconnects, 1, __ATOMIC_RELAXED);
+
+		if (helper->operation.disconnected != NULL)
+			helper->operation.disconnected((glibhelper_managed_session_handle)helper);
+
+		// Fail over. Reconnect starts from the next endpoint of the disconnected one.
+		helper->failover_from = helper->current;
+		helper->backoff_current = 0;
+		managed_client_schedule_reconnect(helper);
+
+		return FALSE;	// This watch was destroyed in managed_client_close
+	}
+
+	return TRUE;
+}
+/**
+ * Schedule reconnect with jittered exponential backoff.
+ * The delay doubles at each failure up to backoff_max, and actual delay is randomized in [delay/2, delay]
+ * to avoid reconnect storm by many clients after server restart.
+ *
+ * @param [in]	helper	Managed client
+ */
+static void managed_client_schedule_reconnect(struct s_glibhelper_unix_socket_managed_client *helper)
+{
+	GSource *gretry = NULL;
+	uint32_t delay = 0;
+
+	if (helper->retry_source != NULL)
+		return;
+
+	if (helper->backoff_current == 0)
+		helper->backoff_current = helper->backoff_initial;
+	else if (helper->backoff_current < helper->backoff_max / 2)
+		helper->backoff_current = helper->backoff_current * 2;
+	else
+		helper->backoff_current = helper->backoff_max;
+
+	delay = helper->backoff_current / 2;
+	delay = delay + (uint32_t)g_random_int_range(0, (gint32)(helper->backoff_current - delay + 1));
+
+	gretry = g_timeout_source_new(delay);
+	if (gretry == NULL)
+		return;
+
+	g_source_set_callback(gretry, managed_client_try_connect, (gpointer)helper, NULL);
+	(void)g_source_attach(gretry, helper->context);
+	g_source_unref(gretry);
+
+	helper->retry_source = gretry;
+}
+/**
+ * Connect to an endpoint.
+ *
+ * @param [in]	helper	Managed client
+ * @param [in]	index	Index of endpoint.
+ *
+ * @return gboolean
+ * @retval TRUE Connected.
+ * @retval FALSE Connect error.
+ */
+static gboolean managed_client_connect_endpoint(struct s_glibhelper_unix_socket_managed_client *helper, int index)
+{
+	struct sockaddr_un socketinfo;
+	GIOChannel *gcliio = NULL;
+	GSource *gclisource = NULL;
+	int clifd = -1;
+	int ret = -1;
+	int len = 0, connectlen = 0;
+
+	clifd = socket(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK, AF_UNIX);
+	if (clifd < 0)
+		goto errorout;
+
+	memset(&socketinfo, 0, sizeof(socketinfo));
+	socketinfo.sun_family = AF_UNIX;
+
+	len = glibhelper_get_socket_name_type(helper->endpoint[index]);
+	if (len < 0)
+		goto errorout;
+	else if (len == 0) { //socket file
+		strncpy(socketinfo.sun_path, helper->endpoint[index], sizeof(socketinfo.sun_path) - 1);
+		connectlen = sizeof(socketinfo);
+	} else {
+		memcpy(socketinfo.sun_path, helper->endpoint[index], len);
+		connectlen = len + sizeof(sa_family_t);
+	}
+
+	// Non blocking connect. Unix domain socket do not return EINPROGRESS, EAGAIN means listen backlog is full.
+	do {
+		ret = connect(clifd, (const struct sockaddr *)&socketinfo, connectlen);
+	} while((ret == -1) && (errno == EINTR));
+	if (ret < 0)
+		goto errorout;
+
+	gcliio = g_io_channel_unix_new (clifd);	// Create gio channel by fd.
+	if (gcliio == NULL)
+		goto errorout;
+
+	g_io_channel_set_close_on_unref(gcliio,TRUE);	// fd close on final unref
+	clifd = -1; // The fd close automatically, do not close myself.
+
+	gclisource = g_io_create_watch(gcliio,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+	if (gclisource == NULL)
+		goto errorout;
+
+	g_source_set_callback(gclisource, (GSourceFunc)managed_client_socket_event,(gpointer)helper, NULL);
+	(void)g_source_attach(gclisource, helper->context);
+	g_source_unref(gclisource);
+
+	helper->gio_source = gcliio;
+	helper->event_source = gclisource;
+	helper->current = index;
+
+	return TRUE;
+
+errorout:
+	if (gcliio != NULL)
+		g_io_channel_unref(gcliio);
+
+	if (clifd >= 0)
+		close(clifd);
+
+	return FALSE;
+}
+/**
+ * Make endpoint trial order.
+ * In list order mode, it is the list order. In round trip time mode, measured endpoints are sorted
+ * by round trip time and not measured endpoints follow in list order.
+ *
+ * @param [in]	helper	Managed client
+ * @param [out]	order	Array of endpoint index.
+ */
+static void managed_client_make_order(struct s_glibhelper_unix_socket_managed_client *helper, int *order)
+{
+	int tmp = 0;
+	int64_t a = 0, b = 0;
+
+	for (int i=0; i < helper->num_of_endpoint; i++)
+		order[i] = i;
+
+	if (helper->prefer_lowest_rtt == FALSE)
+		return;
+
+	// Insertion sort, number of endpoint is small. 0 (not measured) is treated as largest.
+	for (int i=1; i < helper->num_of_endpoint; i++) {
+		for (int j=i; j > 0; j--) {
+			a = helper->endpoint_rtt[order[j-1]];
+			b = helper->endpoint_rtt[order[j]];
+			if (b == 0 || (a != 0 && a <= b))
+				break;
+			tmp = order[j-1];
+			order[j-1] = order[j];
+			order[j] = tmp;
+		}
+	}
+}
+/**
+ * Try to connect server. It is called from event loop.
+ * All endpoints are tried in order at once. After a disconnect, trial starts from the endpoint
+ * next to the disconnected one. When all endpoints fail, reconnect is scheduled with backoff.
+ *
+ * @param [in]	data	Pointer for managed client
+ *
+ * @return gboolean
+ * @retval FALSE Always. This timer source is one shot.
+ */
+static gboolean managed_client_try_connect(gpointer data)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	int order[GLIBHELPER_MANAGED_CLIENT_ENDPOINT_MAX];
+	int start = 0;
+	int index = 0;
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)data;
+	helper->retry_source = NULL;
+
+	managed_client_make_order(helper, order);
+
+	if (helper->failover_from >= 0) {
+		for (int i=0; i < helper->num_of_endpoint; i++) {
+			if (order[i] == helper->failover_from) {
+				start = (i + 1) % helper->num_of_endpoint;
+				break;
+			}
+		}
+		helper->failover_from = -1;
+	}
+
+	for (int i=0; i < helper->num_of_endpoint; i++) {
+		index = order[(start + i) % helper->num_of_endpoint];
+
+		if (managed_client_connect_endpoint(helper, index) == TRUE) {
+			helper->state = MANAGED_CLIENT_CONNECTED;
+			helper->backoff_current = 0;
+			__atomic_fetch_add(&helper->connects, 1, __ATOMIC_RELAXED);
+
+			managed_client_start_flush(helper);
+
+			if (helper->operation.connected != NULL)
+				helper->operation.connected((glibhelper_managed_session_handle)helper);
+
+			return FALSE;
+		}
+	}
+
+	__atomic_fetch_add(&helper->connect_failures, 1, __ATOMIC_RELAXED);
+	managed_client_schedule_reconnect(helper);
+
+	return FALSE;
+}
+/**
+ * Create managed client. The connection is established asynchronously in the event loop,
+ * and it is re-established automatically after disconnect.
+ * When endpoint list is set, the client fails over to the next endpoint on connect error or disconnect.
+ * This function succeeds even if the server is not running.
+ *
+ * @param [in]	handle	Pointer to store created managed client handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Managed client configuration.
+ * @param [in]	userdata	User data for callbacks.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error or resource allocation error.
+ */
+gboolean glibhelper_create_managed_client(glibhelper_unix_socket_managed_client *handle, GMainContext *context, glibhelper_managed_client_config *config, void* userdata)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+	GSource *gretry = NULL;
+
+	if (handle == NULL || config == NULL)
+		return FALSE;
+
+	if (config->num_of_endpoint < 0 || config->num_of_endpoint > GLIBHELPER_MANAGED_CLIENT_ENDPOINT_MAX)
+		return FALSE;
+
+	if (config->num_of_endpoint == 0) {
+		if (glibhelper_get_socket_name_type(config->socket_name) < 0)
+			return FALSE;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_managed_client*)g_malloc(sizeof(struct s_glibhelper_unix_socket_managed_client));
+	if (helper == NULL)
+		return FALSE;
+	memset(helper,0,sizeof(struct s_glibhelper_unix_socket_managed_client));
+
+	helper->sendqueue = g_queue_new();
+	if (helper->sendqueue == NULL)
+		goto errorout;
+
+	// First connect is done in event loop.
+	gretry = g_timeout_source_new(0);
+	if (gretry == NULL)
+		goto errorout;
+
+	g_source_set_callback(gretry, managed_client_try_connect, (gpointer)helper, NULL);
+
+	helper->operation = config->operation;
+	helper->context = context;
+	helper->userdata = userdata;
+	helper->state = MANAGED_CLIENT_DISCONNECTED;
+	helper->sendqueue_max = (config->sendqueue_max > 0) ? config->sendqueue_max : 0;
+	helper->receive_budget = config->receive_budget;
+	helper->backoff_initial = (config->backoff_initial > 0) ? config->backoff_initial : MANAGED_CLIENT_BACKOFF_INITIAL_DEFAULT;
+	helper->backoff_max = (config->backoff_max > 0) ? config->backoff_max : MANAGED_CLIENT_BACKOFF_MAX_DEFAULT;
+	if (helper->backoff_max < helper->backoff_initial)
+		helper->backoff_max = helper->backoff_initial;
+	helper->backoff_current = 0;
+
+	if (config->num_of_endpoint == 0) {
+		memcpy(helper->endpoint[0], config->socket_name, sizeof(helper->endpoint[0]));
+		helper->num_of_endpoint = 1;
+	} else {
+		memcpy(helper->endpoint, config->endpoint, sizeof(helper->endpoint[0]) * config->num_of_endpoint);
+		helper->num_of_endpoint = config->num_of_endpoint;
+	}
+	helper->current = 0;
+	helper->failover_from = -1;
+	helper->prefer_lowest_rtt = config->prefer_lowest_rtt;
+
+	(void)g_source_attach(gretry, context);
+	g_source_unref(gretry);
+	helper->retry_source = gretry;
+
+	helper->stats_entry = glibhelper_stats_register("managed_client", managed_client_stats_dump, helper);
+
+	(*handle) = (glibhelper_unix_socket_managed_client)(helper);
+
+	return TRUE;
+
+errorout:
+	if (helper->sendqueue != NULL)
+		g_queue_free(helper->sendqueue);
+
+	g_free(helper);
+
+	return FALSE;
+}
+/**
+ * Terminate managed client. Buffered packets are discarded.
+ * Do not call this function in callbacks of the same managed client.
+ *
+ * @param [in]	handle	Managed client handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_managed_client(glibhelper_unix_socket_managed_client handle)
+{
+	struct s_glibhelper_unix_socket_managed_client *helper = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	helper = (struct s_glibhelper_unix_socket_managed_client *)handle;
+
+	glibhelper_stats_unregister(helper->stats_entry);
+
+	if (helper->retry_source != NULL)
+		g_source_destroy(helper->retry_source);
+
+	managed_client_close(helper);
+	managed_client_clear_queue(helper);
+	g_queue_free(helper->sendqueue);
+	g_free(helper);
+
+	return TRUE;
+}
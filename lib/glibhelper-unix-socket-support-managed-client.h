@@ -0,0 +1,59 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-unix-socket-support-managed-client.h
+ * @brief	header for glibhelper-unix-socket-support-managed-client
+ */
+#ifndef GLIBHELPER_UINX_SOCKET_SUPPORT_MANAGED_CLIENT_H
+#define GLIBHELPER_UINX_SOCKET_SUPPORT_MANAGED_CLIENT_H
+//-----------------------------------------------------------------------------
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+struct s_glibhelper_unix_socket_managed_client;
+typedef struct s_glibhelper_unix_socket_managed_client *glibhelper_unix_socket_managed_client;
+
+typedef void* glibhelper_managed_session_handle;
+
+#define GLIBHELPER_MANAGED_CLIENT_ENDPOINT_MAX (8)
+
+
+typedef void (*fp_connected_callback_mc)(glibhelper_managed_session_handle session); 
+typedef gboolean (*fp_receive_callback_mc)(glibhelper_managed_session_handle session); 
+typedef void (*fp_disconnected_callback_mc)(glibhelper_managed_session_handle session); 
+
+struct s_glibhelper_managed_client_operation {
+	fp_connected_callback_mc connected; /**< Callbuck for connection established (include reconnect). */
+	fp_receive_callback_mc receive; /**< Callbuck for packet receive. */
+	fp_disconnected_callback_mc disconnected; /**< Callbuck for connection lost. The handle is still valid and reconnect automatically. */
+};
+
+/** glibhelper_managed_client_config.*/
+typedef struct s_glibhelper_managed_client_config {
+	struct s_glibhelper_managed_client_operation operation; /**< managed client event handler. */
+	char socket_name[92]; /**< server socket name. abs name or socket file name. */
+	int receive_budget; /**< drain mode : max receive callbacks per wakeup (0 or 1 = one callback per wakeup). */
+	uint32_t backoff_initial; /**< first reconnect delay (ms). 0 = default (100ms). */
+	uint32_t backoff_max; /**< upper limit of reconnect delay (ms). 0 = default (10s). */
+	int sendqueue_max; /**< max number of packets buffered while disconnected or socket buffer full. 0 = no buffering. */
+	int num_of_endpoint; /**< number of failover endpoints. 0 = use socket_name only. */
+	char endpoint[GLIBHELPER_MANAGED_CLIENT_ENDPOINT_MAX][92]; /**< failover server socket names in priority order. */
+	gboolean prefer_lowest_rtt; /**< TRUE = try endpoints in order of measured round trip time instead of list order. */
+} glibhelper_managed_client_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_create_managed_client(glibhelper_unix_socket_managed_client *handle, GMainContext *context, glibhelper_managed_client_config *config, void* userdata);
+gboolean glibhelper_terminate_managed_client(glibhelper_unix_socket_managed_client handle);
+gboolean glibhelper_managed_client_is_connected(glibhelper_managed_session_handle handle);
+int glibhelper_managed_client_get_fd(glibhelper_managed_session_handle handle);
+void* glibhelper_managed_client_get_userdata(glibhelper_managed_session_handle handle);
+ssize_t glibhelper_managed_client_socket_read(glibhelper_managed_session_handle handle, void *buf, size_t count);
+ssize_t glibhelper_managed_client_socket_write(glibhelper_managed_session_handle handle, void *buf, size_t count);
+int glibhelper_managed_client_get_endpoint(glibhelper_managed_session_handle handle);
+int64_t glibhelper_managed_client_get_endpoint_rtt(glibhelper_managed_session_handle handle, int index);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_UINX_SOCKET_SUPPORT_MANAGED_CLIENT_H
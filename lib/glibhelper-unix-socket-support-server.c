@@ -18,11 +18,45 @@
 
 #include "glibhelper-unix-socket-support-util.h"
 #include "glibhelper-unix-socket-support.h"
+#include "glibhelper-invoker.h"
+#include "glibhelper-stats.h"
+
+#define SERVER_SESSION_TABLE_INITIAL (16)
+#define SERVER_OFFLOAD_PACKET_DEFAULT (4096)
+#define SERVER_OFFLOAD_QUEUE_DEFAULT (64)
 
 struct s_gelibhelper_io_channel {
 	struct s_glibhelper_unix_socket_server_support *parent;
 	GIOChannel *gio_source;
 	GSource *event_source;
+	enum glibhelper_receive_state rx_state;
+	glibhelper_server_session_id id;
+	GQueue offload_queue;	// Received packets waiting for running offload of this session
+	gboolean offload_busy;	// One offload per session runs at a time to keep packet order
+	gboolean rx_paused;	// Receive is stopped until the offload queue is drained
+	glibhelper_uring_request rx_request;	// io_uring backend : multishot receive. NULL = poll backend.
+	const void *rx_packet;	// io_uring backend : received packet not yet read in receive callback
+	size_t rx_count;
+};
+
+struct s_server_session_slot {
+	struct s_gelibhelper_io_channel *session;	// NULL = free slot
+	guint32 generation;
+};
+
+struct s_server_write_request {
+	struct s_glibhelper_unix_socket_server_support *helper;
+	glibhelper_server_session_id id;
+	size_t count;
+	uint8_t data[];
+};
+
+struct s_server_offload_job {
+	struct s_glibhelper_unix_socket_server_support *helper;
+	glibhelper_server_session_id id;
+	void *result;
+	size_t count;
+	uint8_t data[];
 };
 
 struct s_glibhelper_unix_socket_server_support {
@@ -32,7 +66,36 @@ struct s_glibhelper_unix_socket_server_support {
 	void *userdata;
 	GList *clientlist;
 	int socketbuf_size;
+	int receive_budget;
+	GMutex session_lock;	// Protect session_table. Sessions are referred from other threads by session ID.
+	struct s_server_session_slot *session_table;
+	guint num_of_slot;
+	glibhelper_invoker invoker;	// Cross thread write request to the server context
+	GThreadPool *offload_pool;	// NULL = offload mode is disabled
+	int offload_packet_size;
+	guint offload_queue_limit;	// Receive of session is paused when its offload queue reaches this
+	glibhelper_uring uring;	// NULL = poll backend
+	// Statistics. Atomic, they are read by glibhelper_stats_dump in other threads.
+	guint64 accepted;	// Sessions accepted
+	guint64 closed;	// Sessions closed by client
+	guint64 write_requests;	// Write requests by session ID
+	guint64 offload_jobs;	// Packets passed to offload workers
+	guint64 rx_pauses;	// Receive paused by offload backpressure
+	glibhelper_stats_entry stats_entry;
 };
+//-----------------------------------------------------------------------------
+static void server_stats_dump(int fd, void *userdata)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = (struct s_glibhelper_unix_socket_server_support*)userdata;
+	guint64 accepted = __atomic_load_n(&helper->accepted, __ATOMIC_RELAXED);
+	guint64 closed = __atomic_load_n(&helper->closed, __ATOMIC_RELAXED);
+
+	glibhelper_stats_print(fd, "  backend=%s sessions=%lu accepted=%lu closed=%lu write_requests=%lu offload_jobs=%lu rx_pauses=%lu offload_queue_limit=%u\n",
+			(helper->uring != NULL) ? "io_uring" : "poll", (unsigned long)(accepted - closed), (unsigned long)accepted,
+			(unsigned long)closed, (unsigned long)__atomic_load_n(&helper->write_requests, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&helper->offload_jobs, __ATOMIC_RELAXED),
+			(unsigned long)__atomic_load_n(&helper->rx_pauses, __ATOMIC_RELAXED), helper->offload_queue_limit);
+}
 /**
  * Get session socket fd from server session handle.
  *
@@ -89,7 +152,7 @@ void* glibhelper_server_get_userdata(glibhelper_server_session_handle handle)
  */
 ssize_t glibhelper_server_socket_read(glibhelper_server_session_handle handle, void *buf, size_t count)
 {
-	//struct s_gelibhelper_io_channel *session = NULL;
+	struct s_gelibhelper_io_channel *session = NULL;
 	ssize_t ret = -1;
 	int fd = -1;
 
@@ -98,6 +161,21 @@ ssize_t glibhelper_server_socket_read(glibhelper_server_session_handle handle, v
 		return -1;
 	}
 
+	session = (struct s_gelibhelper_io_channel*)handle;
+	if (session->parent->uring != NULL) {
+		// io_uring backend. The packet was received by the kernel before the receive callback.
+		if (session->rx_packet == NULL) {
+			session->rx_state = GLIBHELPER_RX_DRAINED;
+			errno = EAGAIN;
+			return -1;
+		}
+		ret = (ssize_t)MIN(count, session->rx_count);
+		memcpy(buf, session->rx_packet, (size_t)ret);
+		session->rx_packet = NULL;
+		session->rx_state = GLIBHELPER_RX_READ;
+		return ret;
+	}
+
 	fd = glibhelper_server_get_fd(handle);
 	if (fd < 0) {
 		errno = EINVAL;
@@ -108,6 +186,9 @@ ssize_t glibhelper_server_socket_read(glibhelper_server_session_handle handle, v
 		ret = read(fd, buf, count);
 	} while((ret == -1) && (errno == EINTR));
 
+	// Update drain mode state. A zero length read or EAGAIN means no more queued packet.
+	session->rx_state = (ret > 0) ? GLIBHELPER_RX_READ : GLIBHELPER_RX_DRAINED;
+
 	return ret;
 }
 /**
@@ -164,6 +245,238 @@ glibhelper_unix_socket_server_support glibhelper_server_socket_server_support_fr
 
 	return session->parent;
 }
+/**
+ * Register session to session table and assign session ID.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	New session
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Resource allocation error.
+ */
+static gboolean server_session_register(struct s_glibhelper_unix_socket_server_support *helper, struct s_gelibhelper_io_channel *session)
+{
+	struct s_server_session_slot *table = NULL;
+	guint slot = 0;
+	guint num = 0;
+
+	g_mutex_lock(&helper->session_lock);
+
+	for (slot=0; slot < helper->num_of_slot; slot++) {
+		if (helper->session_table[slot].session == NULL)
+			break;
+	}
+
+	if (slot == helper->num_of_slot) {
+		num = (helper->num_of_slot == 0) ? SERVER_SESSION_TABLE_INITIAL : helper->num_of_slot * 2;
+		table = (struct s_server_session_slot*)g_realloc(helper->session_table, sizeof(struct s_server_session_slot) * num);
+		if (table == NULL) {
+			g_mutex_unlock(&helper->session_lock);
+			return FALSE;
+		}
+		memset(&table[helper->num_of_slot], 0, sizeof(struct s_server_session_slot) * (num - helper->num_of_slot));
+		helper->session_table = table;
+		helper->num_of_slot = num;
+	}
+
+	// Generation 0 is not used, ID 0 is invalid.
+	helper->session_table[slot].generation++;
+	if (helper->session_table[slot].generation == 0)
+		helper->session_table[slot].generation = 1;
+
+	helper->session_table[slot].session = session;
+	session->id = ((glibhelper_server_session_id)slot << 32) | helper->session_table[slot].generation;
+
+	g_mutex_unlock(&helper->session_lock);
+
+	return TRUE;
+}
+/**
+ * Unregister session from session table. After this function, the session ID becomes stale.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	Session
+ */
+static void server_session_unregister(struct s_glibhelper_unix_socket_server_support *helper, struct s_gelibhelper_io_channel *session)
+{
+	guint slot = (guint)(session->id >> 32);
+
+	g_mutex_lock(&helper->session_lock);
+	if (slot < helper->num_of_slot && helper->session_table[slot].session == session)
+		helper->session_table[slot].session = NULL;
+	g_mutex_unlock(&helper->session_lock);
+}
+/**
+ * Lookup session by session ID.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	id	Session ID
+ *
+ * @return struct s_gelibhelper_io_channel*
+ * @retval !NULL Session. It is valid only in the server context.
+ * @retval NULL The session was closed.
+ */
+static struct s_gelibhelper_io_channel* server_session_lookup(struct s_glibhelper_unix_socket_server_support *helper, glibhelper_server_session_id id)
+{
+	struct s_gelibhelper_io_channel *session = NULL;
+	guint slot = (guint)(id >> 32);
+
+	g_mutex_lock(&helper->session_lock);
+	if (slot < helper->num_of_slot && helper->session_table[slot].session != NULL
+		&& helper->session_table[slot].generation == (guint32)(id & 0xffffffffu))
+		session = helper->session_table[slot].session;
+	g_mutex_unlock(&helper->session_lock);
+
+	return session;
+}
+/**
+ * Get session ID from server session handle.
+ * The session ID can be passed to other threads. It never matches a later session that reuses the same slot.
+ *
+ * @param [in]	handle	Server session handle
+ *
+ * @return glibhelper_server_session_id
+ * @retval !0 Session ID.
+ * @retval 0 Illegal handle error.
+ */
+glibhelper_server_session_id glibhelper_server_get_session_id(glibhelper_server_session_handle handle)
+{
+	if ( handle == NULL)
+		return 0;
+
+	return ((struct s_gelibhelper_io_channel*)handle)->id;
+}
+/**
+ * Check the session of session ID is alive. This function is thread safe.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	id	Session ID
+ *
+ * @return gboolean
+ * @retval TRUE The session is alive.
+ * @retval FALSE The session was closed or arg error.
+ */
+gboolean glibhelper_server_session_is_alive(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id)
+{
+	if ( handle == NULL || id == 0)
+		return FALSE;
+
+	if (server_session_lookup((struct s_glibhelper_unix_socket_server_support*)handle, id) == NULL)
+		return FALSE;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void server_write_request_cb(void *data)
+{
+	struct s_server_write_request *request = (struct s_server_write_request*)data;
+	struct s_gelibhelper_io_channel *session = NULL;
+
+	// In the server context, the session is not freed during this function.
+	session = server_session_lookup(request->helper, request->id);
+	if (session != NULL)
+		(void)glibhelper_server_socket_write((glibhelper_server_session_handle)session, request->data, request->count);
+
+	g_free(request);
+}
+/**
+ * Write packet to session by session ID. This function is thread safe.
+ * The packet is copied and written in the server context. When the session is closed before that,
+ * the packet is dropped.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	id	Session ID
+ * @param [in]	buf Pointer to write data buffer.
+ * @param [in]	counte Number of bytes for buffer.
+ *
+ * @return ssize_t
+ * @retval >=0 Number of bytes queued.
+ * @retval <0 error (refer to error no). ENOTCONN means the session was closed.
+ */
+ssize_t glibhelper_server_socket_write_by_id(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id, void *buf, size_t count)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = NULL;
+	struct s_server_write_request *request = NULL;
+
+	if ( handle == NULL || buf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
+
+	if (server_session_lookup(helper, id) == NULL) {
+		errno = ENOTCONN;
+		return -1;
+	}
+
+	request = (struct s_server_write_request*)g_malloc(sizeof(struct s_server_write_request) + count);
+	if (request == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	request->helper = helper;
+	request->id = id;
+	request->count = count;
+	memcpy(request->data, buf, count);
+
+	if (glibhelper_invoker_post_full(helper->invoker, server_write_request_cb, request, g_free) == FALSE) {
+		g_free(request);
+		errno = ENOMEM;
+		return -1;
+	}
+	__atomic_fetch_add(&helper->write_requests, 1, __ATOMIC_RELAXED);
+
+	return (ssize_t)count;
+}
+/**
+ * Get server session handle from session ID. Call this function in the server context,
+ * the handle is valid until the session is destroyed.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	id	Session ID
+ *
+ * @return glibhelper_server_session_handle
+ * @retval !NULL Server session handle.
+ * @retval NULL The session was closed or arg error.
+ */
+glibhelper_server_session_handle glibhelper_server_session_from_id(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id)
+{
+	if ( handle == NULL || id == 0)
+		return NULL;
+
+	return (glibhelper_server_session_handle)server_session_lookup((struct s_glibhelper_unix_socket_server_support*)handle, id);
+}
+/**
+ * Call function for each connected session. Call this function in the server context.
+ * The sessions must not be destroyed in the function.
+ *
+ * @param [in]	handle	Server socket handle
+ * @param [in]	func	Function to call with session handle.
+ * @param [in]	userdata	Argument of the function.
+ *
+ * @return int
+ * @retval >=0 Number of sessions.
+ * @retval <0 Arg error.
+ */
+int glibhelper_server_socket_foreach_session(glibhelper_unix_socket_server_support handle, fp_foreach_session_callback_sv func, void *userdata)
+{
+	struct s_glibhelper_unix_socket_server_support *helper = NULL;
+	int num = 0;
+
+	if ( handle == NULL || func == NULL)
+		return -1;
+
+	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
+
+	for (GList *listptr = g_list_first(helper->clientlist); listptr != NULL; listptr = g_list_next(listptr)) {
+		func((glibhelper_server_session_handle)listptr->data, userdata);
+		num++;
+	}
+
+	return num;
+}
 
 /**
  *
@@ -206,6 +519,212 @@ int glibhelper_server_socket_broadcast(glibhelper_unix_socket_server_support han
 
 	return num_of_send;
 }
+static gboolean server_session_watch(struct s_glibhelper_unix_socket_server_support *helper, struct s_gelibhelper_io_channel *session);
+/**
+ * Stop receive of session. Received packets are kept in the socket buffer and the sender is throttled.
+ * It is called in the receive of the session.
+ *
+ * @param [in]	session	Session
+ */
+static void server_session_pause(struct s_gelibhelper_io_channel *session)
+{
+	if (session->rx_paused == TRUE)
+		return;
+
+	if (session->rx_request != NULL) {
+		glibhelper_uring_pause(session->rx_request);
+	} else if (session->event_source != NULL) {
+		g_source_destroy(session->event_source);
+		session->event_source = NULL;
+	}
+	session->rx_paused = TRUE;
+	__atomic_fetch_add(&session->parent->rx_pauses, 1, __ATOMIC_RELAXED);
+}
+/**
+ * Restart receive of paused session.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	Session
+ */
+static void server_session_resume(struct s_glibhelper_unix_socket_server_support *helper, struct s_gelibhelper_io_channel *session)
+{
+	if (session->rx_paused == FALSE)
+		return;
+
+	if (session->rx_request != NULL) {
+		glibhelper_uring_resume(session->rx_request);
+	} else if (server_session_watch(helper, session) == FALSE) {
+		return;	// Retried at next completion
+	}
+	session->rx_paused = FALSE;
+}
+//-----------------------------------------------------------------------------
+static void server_offload_complete_cb(void *data)
+{
+	struct s_server_offload_job *job = (struct s_server_offload_job*)data;
+	struct s_glibhelper_unix_socket_server_support *helper = job->helper;
+	struct s_gelibhelper_io_channel *session = NULL;
+	struct s_server_offload_job *next = NULL;
+
+	// Completion is checked by session ID, the session may be closed during offload.
+	session = server_session_lookup(helper, job->id);
+	if (helper->operation.offload_complete != NULL)
+		helper->operation.offload_complete((glibhelper_server_session_handle)session, job->result);
+	g_free(job);
+
+	if (session == NULL)
+		return;
+
+	next = (struct s_server_offload_job*)g_queue_pop_head(&session->offload_queue);
+	if (next != NULL) {
+		(void)g_thread_pool_push(helper->offload_pool, next, NULL);
+		__atomic_fetch_add(&helper->offload_jobs, 1, __ATOMIC_RELAXED);
+	} else {
+		session->offload_busy = FALSE;
+	}
+
+	// Backpressure : receive again when half of the queue limit is drained.
+	if (session->rx_paused == TRUE && g_queue_get_length(&session->offload_queue) <= helper->offload_queue_limit / 2)
+		server_session_resume(helper, session);
+}
+//-----------------------------------------------------------------------------
+static void server_offload_release_cb(void *data)
+{
+	struct s_server_offload_job *job = (struct s_server_offload_job*)data;
+
+	// Server is terminating, release the result.
+	if (job->helper->operation.offload_complete != NULL)
+		job->helper->operation.offload_complete(NULL, job->result);
+	g_free(job);
+}
+//-----------------------------------------------------------------------------
+static void server_offload_worker(gpointer data, gpointer user_data)
+{
+	struct s_server_offload_job *job = (struct s_server_offload_job*)data;
+	struct s_glibhelper_unix_socket_server_support *helper = (struct s_glibhelper_unix_socket_server_support*)user_data;
+
+	job->result = helper->operation.offload(job->id, job->data, job->count, helper->userdata);
+
+	if (glibhelper_invoker_post_full(helper->invoker, server_offload_complete_cb, job, server_offload_release_cb) == FALSE)
+		server_offload_release_cb(job);
+}
+/**
+ * Receive packets and pass them to offload worker threads.
+ * Packets of a session are processed one by one in receive order.
+ * When the offload queue of the session reaches the limit, receive of the session is paused.
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	Session
+ */
+static void server_offload_receive(struct s_glibhelper_unix_socket_server_support *helper, struct s_gelibhelper_io_channel *session)
+{
+	struct s_server_offload_job *job = NULL;
+	ssize_t ret = -1;
+
+	for (int i=0; i < helper->receive_budget || i == 0; i++) {
+		job = (struct s_server_offload_job*)g_malloc(sizeof(struct s_server_offload_job) + helper->offload_packet_size);
+		if (job == NULL)
+			return;
+
+		ret = glibhelper_server_socket_read((glibhelper_server_session_handle)session, job->data, helper->offload_packet_size);
+		if (ret <= 0) {
+			// EAGAIN = drained. 0 = closed by peer, HUP follows.
+			g_free(job);
+			return;
+		}
+
+		job->helper = helper;
+		job->id = session->id;
+		job->result = NULL;
+		job->count = (size_t)ret;
+
+		if (session->offload_busy == TRUE) {
+			g_queue_push_tail(&session->offload_queue, job);
+			if (g_queue_get_length(&session->offload_queue) >= helper->offload_queue_limit) {
+				server_session_pause(session);
+				return;
+			}
+		} else {
+			session->offload_busy = TRUE;
+			(void)g_thread_pool_push(helper->offload_pool, job, NULL);
+			__atomic_fetch_add(&helper->offload_jobs, 1, __ATOMIC_RELAXED);
+		}
+	}
+}
+/**
+ * Release received packets not yet passed to offload worker.
+ *
+ * @param [in]	session	Session
+ */
+static void server_offload_clear(struct s_gelibhelper_io_channel *session)
+{
+	void *job = NULL;
+
+	while ((job = g_queue_pop_head(&session->offload_queue)) != NULL)
+		g_free(job);
+}
+/**
+ * Stop receive of session and release it. The session shall be unregistered before this function.
+ *
+ * @param [in]	session	Session
+ */
+static void server_session_release(struct s_gelibhelper_io_channel *session)
+{
+	server_offload_clear(session);
+	if (session->rx_request != NULL)
+		glibhelper_uring_cancel(session->rx_request);
+	else if (session->event_source != NULL)
+		g_source_destroy(session->event_source);
+	g_io_channel_unref(session->gio_source);
+	g_free(session);
+}
+/**
+ * Receive completion of session in io_uring backend. One packet is passed to the receive callback per completion,
+ * all completions of a wakeup are dispatched together.
+ *
+ * @param [in]	request	Receive request
+ * @param [in]	res	Number of bytes, <0 = -errno.
+ * @param [in]	buf	Received packet, NULL = closed by peer.
+ * @param [in]	data	Session
+ *
+ * @return gboolean
+ * @retval TRUE Continue receive.
+ * @retval FALSE Receive callback requested to stop.
+ */
+static gboolean server_session_uring_event(glibhelper_uring_request request, int res, void *buf, void *data)
+{
+	struct s_gelibhelper_io_channel *session = (struct s_gelibhelper_io_channel*)data;
+	struct s_glibhelper_unix_socket_server_support *helper = session->parent;
+	gboolean receiveret = TRUE;
+
+	if (res < 0 || buf == NULL) {	 //Client side socket was closed or error. Zero length packet is received.
+		// Cleanup session
+		helper->clientlist = g_list_remove(helper->clientlist, session);
+		server_session_unregister(helper, session);
+		__atomic_fetch_add(&helper->closed, 1, __ATOMIC_RELAXED);
+
+		if (helper->operation.destroyed_session != NULL)
+			helper->operation.destroyed_session((glibhelper_server_session_handle)session);
+
+		server_session_release(session);
+		return TRUE;	// The request was cancelled in server_session_release
+	}
+
+	session->rx_packet = buf;
+	session->rx_count = (size_t)res;
+	if (helper->offload_pool != NULL) {
+		// offload mode
+		server_offload_receive(helper, session);
+	} else if (helper->operation.receive != NULL) {
+		session->rx_state = GLIBHELPER_RX_NOT_READ;
+		receiveret = helper->operation.receive((glibhelper_server_session_handle)session);
+	}
+	session->rx_packet = NULL;	// Not read packet is discarded
+	if (receiveret == FALSE)
+		session->rx_request = NULL;	// Released by the ring
+
+	return receiveret;
+}
 /**
  *
  *
@@ -238,19 +757,28 @@ static gboolean clientchannel_socket_event (GIOChannel *source,
 	if ((condition & (G_IO_ERR | G_IO_HUP)) != 0) {	 //Client side socket was closed.
 		// Cleanup session
 		helper->clientlist = g_list_remove(helper->clientlist, session);
+		server_session_unregister(helper, session);
+		__atomic_fetch_add(&helper->closed, 1, __ATOMIC_RELAXED);
 
 		if (helper->operation.destroyed_session != NULL)
 			helper->operation.destroyed_session((glibhelper_server_session_handle)session);
 
-		g_source_destroy(session->event_source);
-		g_io_channel_unref(session->gio_source);
-		g_free(session);
+		server_session_release(session);
 	} else if ((condition & G_IO_IN) != 0) {	// receive data
-		// receive callback
-		if (helper->operation.receive != NULL) {
-			receiveret = helper->operation.receive((glibhelper_server_session_handle)session);
-			if (receiveret == FALSE)
-				return FALSE;
+		if (helper->offload_pool != NULL) {
+			// offload mode
+			server_offload_receive(helper, session);
+		} else if (helper->operation.receive != NULL) {
+			// receive callback
+			// In drain mode, call receive callback until the socket queue is empty or budget is exhausted.
+			for (int i=0; i < helper->receive_budget || i == 0; i++) {
+				session->rx_state = GLIBHELPER_RX_NOT_READ;
+				receiveret = helper->operation.receive((glibhelper_server_session_handle)session);
+				if (receiveret == FALSE)
+					return FALSE;
+				if (session->rx_state != GLIBHELPER_RX_READ)
+					break;
+			}
 		}
 	} else {	//	G_IO_NVAL or undefined
 		return FALSE;	// When this event return FALSE, this event watch is disabled
@@ -259,6 +787,34 @@ static gboolean clientchannel_socket_event (GIOChannel *source,
 	return TRUE;
 }
 
+/**
+ * Attach watch of session socket to the server context (poll backend).
+ *
+ * @param [in]	helper	Server socket
+ * @param [in]	session	Session
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Resource allocation error.
+ */
+static gboolean server_session_watch(struct s_glibhelper_unix_socket_server_support *helper, struct s_gelibhelper_io_channel *session)
+{
+	GSource *source = NULL;
+
+	source = g_io_create_watch(session->gio_source,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
+	if (source == NULL)
+		return FALSE;
+
+	g_source_set_callback(source, (GSourceFunc)clientchannel_socket_event,(gpointer)session, NULL);
+
+	(void)g_source_attach(source, helper->context);
+
+	g_source_unref(source);
+
+	session->event_source = source;
+
+	return TRUE;
+}
 /**
  *
  *
@@ -275,12 +831,10 @@ static gboolean server_socket_event (GIOChannel *source,
 								gpointer data)
 {
 	GIOChannel *new_session_io = NULL;
-	GSource *new_session_source = NULL;
 	struct s_glibhelper_unix_socket_server_support *helper = NULL;
 	struct s_gelibhelper_io_channel *new_session = NULL;
 	int serverfd = -1;
 	int clifd = -1;
-	guint id = 0;
 
 	if (source == NULL || data == NULL)
 		return FALSE;// Arg error -> Stop callback Fail safe
@@ -319,25 +873,31 @@ static gboolean server_socket_event (GIOChannel *source,
 			return TRUE;
 		}
 		memset(new_session,0,sizeof(struct s_gelibhelper_io_channel));
+		g_queue_init(&new_session->offload_queue);
+		new_session->parent = helper;
+		new_session->gio_source = new_session_io;
 
-		new_session_source = g_io_create_watch(new_session_io,(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL));
-		if (new_session_source == NULL) {
+		if (helper->uring != NULL) {
+			// io_uring backend : multishot receive, submitted with the other requests of this iteration.
+			new_session->rx_request = glibhelper_uring_recv(helper->uring, clifd, server_session_uring_event, new_session);
+			if (new_session->rx_request == NULL) {
+				g_io_channel_unref(new_session_io);
+				g_free(new_session);
+				return TRUE;
+			}
+		} else if (server_session_watch(helper, new_session) == FALSE) {
 			g_io_channel_unref(new_session_io);
 			g_free(new_session);
 			return TRUE;
 		}
 
-		g_source_set_callback(new_session_source, (GSourceFunc)clientchannel_socket_event,(gpointer) new_session, NULL);
-
-		id = g_source_attach(new_session_source, helper->context);
-
-		g_source_unref(new_session_source);
-
-		new_session->parent = helper;
-		new_session->gio_source = new_session_io;
-		new_session->event_source = new_session_source;
+		if (server_session_register(helper, new_session) == FALSE) {
+			server_session_release(new_session);
+			return TRUE;
+		}
 
 		helper->clientlist = g_list_append( helper->clientlist, new_session);
+		__atomic_fetch_add(&helper->accepted, 1, __ATOMIC_RELAXED);
 
 		if (helper->operation.get_new_session != NULL)
 			helper->operation.get_new_session((glibhelper_server_session_handle)new_session);
@@ -377,6 +937,10 @@ gboolean glibhelper_create_server_socket(glibhelper_unix_socket_server_support *
 	if (helper == NULL)
 		return FALSE;
 	memset(helper,0,sizeof(struct s_glibhelper_unix_socket_server_support));
+	g_mutex_init(&helper->session_lock);
+
+	if (glibhelper_create_invoker(&helper->invoker, context, NULL) == FALSE)
+		goto errorout;
 
 	serverfd = socket(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK, AF_UNIX);
 	if (serverfd < 0) {
@@ -432,6 +996,20 @@ gboolean glibhelper_create_server_socket(glibhelper_unix_socket_server_support *
 	helper->userdata = userdata;
 	helper->clientlist = NULL;
 	helper->socketbuf_size = config->socketbuf_size;
+	helper->receive_budget = config->receive_budget;
+	helper->uring = config->uring;
+
+	if (config->offload_threads > 0 && config->operation.offload != NULL) {
+		helper->offload_packet_size = (config->offload_packet_size > 0) ? config->offload_packet_size : SERVER_OFFLOAD_PACKET_DEFAULT;
+		helper->offload_queue_limit = (config->offload_queue_limit > 0) ? (guint)config->offload_queue_limit : SERVER_OFFLOAD_QUEUE_DEFAULT;
+		helper->offload_pool = g_thread_pool_new(server_offload_worker, helper, config->offload_threads, TRUE, NULL);
+		if (helper->offload_pool == NULL) {
+			g_source_destroy(gserversource);
+			goto errorout;
+		}
+	}
+
+	helper->stats_entry = glibhelper_stats_register("server_socket", server_stats_dump, helper);
 
 	(*handle) = (glibhelper_unix_socket_server_support)(helper);
 
@@ -445,6 +1023,10 @@ errorout:
 	if (serverfd >= 0)
 		close(serverfd);
 
+	if (helper->invoker != NULL)
+		(void)glibhelper_terminate_invoker(helper->invoker);
+
+	g_mutex_clear(&helper->session_lock);
 	g_free(helper);
 
 	return FALSE;
@@ -472,6 +1054,12 @@ gboolean glibhelper_terminate_server_socket(glibhelper_unix_socket_server_suppor
 
 	helper = (struct s_glibhelper_unix_socket_server_support*)handle;
 
+	glibhelper_stats_unregister(helper->stats_entry);
+
+	// Wait running offloads. Their completions are released with the invoker.
+	if (helper->offload_pool != NULL)
+		g_thread_pool_free(helper->offload_pool, FALSE, TRUE);
+
 	// Destroy all session
 	listptr = g_list_first(helper->clientlist);
 
@@ -485,14 +1073,18 @@ gboolean glibhelper_terminate_server_socket(glibhelper_unix_socket_server_suppor
 			if (helper->operation.destroyed_session != NULL)
 				helper->operation.destroyed_session((glibhelper_server_session_handle)session);
 
-			g_source_destroy(session->event_source);
-			g_io_channel_unref(session->gio_source);
-			g_free(session);
+			server_session_unregister(helper, session);
+			server_session_release(session);
 		}
 		listptr = g_list_next(listptr);
 	}
 	g_list_free(helper->clientlist);
 
+	// Not processed write requests are released.
+	(void)glibhelper_terminate_invoker(helper->invoker);
+	g_mutex_clear(&helper->session_lock);
+	g_free(helper->session_table);
+
 	// Destroy server socket
 	g_source_destroy(helper->server.event_source);
 	g_io_channel_unref(helper->server.gio_source);
@@ -4,8 +4,12 @@
  * @file	glibhelper-unix-socket-support-util.c
  * @brief	util for unix domain socket seq packet helper.
  */
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
 #include <glib.h>
 #include <gio/gio.h>
+#endif
 
 #include <stdint.h>
 #include <stdio.h>
@@ -18,6 +22,8 @@
 
 #include "glibhelper-unix-socket-support-util.h"
 
+#define GLIBHELPER_WRITE_BATCH_CHUNK (64)	// Number of packets per sendmmsg call
+
 /**
  * Socket buffer size calculator
  *
@@ -66,3 +72,59 @@ int glibhelper_get_socket_name_type(char *str)
 
 	return ret;
 }
+/**
+ * Write multiple packets to seq packet socket by sendmmsg.
+ * Each packet is sent as an independent seq packet. When some packets are sent and the next packet
+ * can not be sent, the number of sent packets is returned and errno shows the reason (EAGAIN etc.).
+ * The caller can resume from packets[return value].
+ *
+ * @param [in]	fd	Socket fd.
+ * @param [in]	packets	Array of packet descriptor.
+ * @param [in]	num	Number of packets.
+ *
+ * @return int
+ * @retval >=0 Number of packets sent. When it is less than num, errno is set.
+ * @retval <0 error, no packet was sent (refer to error no).
+ */
+int glibhelper_socket_write_batch(int fd, glibhelper_socket_packet *packets, int num)
+{
+	struct mmsghdr msgs[GLIBHELPER_WRITE_BATCH_CHUNK];
+	struct iovec iovs[GLIBHELPER_WRITE_BATCH_CHUNK];
+	int num_of_send = 0;
+	int chunk = 0;
+	int ret = -1;
+
+	if (fd < 0 || packets == NULL || num < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	while (num_of_send < num) {
+		chunk = num - num_of_send;
+		if (chunk > GLIBHELPER_WRITE_BATCH_CHUNK)
+			chunk = GLIBHELPER_WRITE_BATCH_CHUNK;
+
+		memset(msgs, 0, sizeof(struct mmsghdr) * chunk);
+		for (int i=0; i < chunk; i++) {
+			iovs[i].iov_base = packets[num_of_send + i].buf;
+			iovs[i].iov_len = packets[num_of_send + i].count;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		do {
+			ret = sendmmsg(fd, msgs, chunk, 0);
+		} while((ret == -1) && (errno == EINTR));
+
+		if (ret < 0) {
+			if (num_of_send == 0)
+				return -1;
+			break;	// Partial completion, errno shows the reason of stop.
+		}
+
+		// When ret < chunk, next sendmmsg reports the error or sends more if buffer became free.
+		num_of_send += ret;
+	}
+
+	return num_of_send;
+}
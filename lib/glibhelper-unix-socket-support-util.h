@@ -7,14 +7,32 @@
 #ifndef GLIBHELPER_UINX_SOCKET_SUPPORT_UTIL_H
 #define GLIBHELPER_UINX_SOCKET_SUPPORT_UTIL_H
 //-----------------------------------------------------------------------------
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
 #include <glib.h>
 #include <gio/gio.h>
+#endif
 
+#include "glibhelper-unix-socket-support.h"
 
+//-----------------------------------------------------------------------------
+/** Receive state for drain mode. It is updated by socket read functions. */
+enum glibhelper_receive_state {
+	//! Receive callback did not read the socket
+	GLIBHELPER_RX_NOT_READ = 0,
+
+	//! Receive callback read a packet, more packets may be queued
+	GLIBHELPER_RX_READ = 1,
+
+	//! Socket queue is empty (EAGAIN), closed or error
+	GLIBHELPER_RX_DRAINED = 2,
+};
 
 //-----------------------------------------------------------------------------
 int glibhelper_calculate_socket_buffer_size(int packet_max_size, int packet_max_num);
 int glibhelper_get_socket_name_type(char *str);
+int glibhelper_socket_write_batch(int fd, glibhelper_socket_packet *packets, int num);
 
 
 
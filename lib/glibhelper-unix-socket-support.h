@@ -7,25 +7,42 @@
 #ifndef GLIBHELPER_UINX_SOCKET_SUPPORT_H
 #define GLIBHELPER_UINX_SOCKET_SUPPORT_H
 //-----------------------------------------------------------------------------
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
 #include <glib.h>
 #include <gio/gio.h>
+#endif
 
+#include "glibhelper-uring.h"
+
+//-----------------------------------------------------------------------------
+/** Packet descriptor for batch write.*/
+typedef struct s_glibhelper_socket_packet {
+	void *buf; /**< Pointer to packet data. */
+	size_t count; /**< Number of bytes of packet. */
+} glibhelper_socket_packet;
 
 //-----------------------------------------------------------------------------
 struct s_glibhelper_unix_socket_server_support;
 typedef struct s_glibhelper_unix_socket_server_support *glibhelper_unix_socket_server_support;
 
 typedef void* glibhelper_server_session_handle;
-
+typedef guint64 glibhelper_server_session_id; /**< (slot index << 32) | generation. 0 is invalid. */
 
 typedef void (*fp_get_new_session_callback_sv)(glibhelper_server_session_handle session); 
 typedef gboolean (*fp_receive_callback_sv)(glibhelper_server_session_handle session); 
 typedef void (*fp_destroyed_session_callback_sv)(glibhelper_server_session_handle session); 
+typedef void (*fp_foreach_session_callback_sv)(glibhelper_server_session_handle session, void *userdata); 
+typedef void* (*fp_offload_callback_sv)(glibhelper_server_session_id id, void *buf, size_t count, void *userdata); 
+typedef void (*fp_offload_complete_callback_sv)(glibhelper_server_session_handle session, void *result); 
 
 struct s_glibhelper_server_socket_operation {
 	fp_get_new_session_callback_sv get_new_session; /**< Callbuck for sever accepted new session. */
 	fp_receive_callback_sv receive; /**< Callbuck for packet receive. */
 	fp_destroyed_session_callback_sv destroyed_session; /**< Callbuck for destroyed session. */
+	fp_offload_callback_sv offload; /**< offload mode : Callbuck for received packet in worker thread. It returns result for offload_complete. */
+	fp_offload_complete_callback_sv offload_complete; /**< offload mode : Callbuck for offload result in server context. session is NULL when it was closed. */
 };
 
 /** glibhelper_server_socket_config.*/
@@ -33,6 +50,12 @@ typedef struct s_glibhelper_server_socket_config {
 	struct s_glibhelper_server_socket_operation operation; /**< server socket event handler. */
 	int socketbuf_size; /**< server socket buffer size : roundup(packet_size * queue). */
 	char socket_name[92]; /**< server socket name. abs name or socket file name. */
+	int receive_budget; /**< drain mode : max receive callbacks per wakeup (0 or 1 = one callback per wakeup). */
+	int offload_threads; /**< offload mode : number of worker threads for offload callback. 0 = disabled (receive callback is used). */
+	int offload_packet_size; /**< offload mode : max packet size for offload callback. 0 = default (4096). */
+	int offload_queue_limit; /**< offload mode : max packets queued per session while its offload runs. Receive of the session is paused
+								at the limit and resumed when half is drained. 0 = default (64). */
+	glibhelper_uring uring; /**< io_uring backend : ring for session receive in the server context. NULL = poll backend. */
 } glibhelper_server_socket_config;
 
 //-----------------------------------------------------------------------------
@@ -54,9 +77,12 @@ struct s_glibhelper_client_socket_operation {
 typedef struct s_glibhelper_client_socket_config {
 	struct s_glibhelper_client_socket_operation operation; /**< server socket event handler. */
 	char socket_name[92]; /**< server socket name. abs name or socket file name. */
+	int receive_budget; /**< drain mode : max receive callbacks per wakeup (0 or 1 = one callback per wakeup). */
+	glibhelper_uring uring; /**< io_uring backend : ring for receive in the client context. NULL = poll backend. */
 } glibhelper_client_socket_config;
 
 //-----------------------------------------------------------------------------
+#ifndef GLIBHELPER_EPOLL	// Internal socket is not provided by the epoll backend.
 struct s_glibhelper_unix_socket_internal_support;
 typedef struct s_glibhelper_unix_socket_internal_support *glibhelper_unix_socket_internal_support;
 
@@ -75,7 +101,9 @@ struct s_glibhelper_internal_socket_operation {
 typedef struct s_glibhelper_internal_socket_config {
 	struct s_glibhelper_internal_socket_operation operation; /**< server socket event handler. */
 	int socketbuf_size; /**< socket buffer size : roundup(packet_size * queue). */
+	int receive_budget; /**< drain mode : max receive callbacks per wakeup (0 or 1 = one callback per wakeup). */
 } glibhelper_internal_socket_config;
+#endif //#ifndef GLIBHELPER_EPOLL
 
 //-----------------------------------------------------------------------------
 gboolean glibhelper_create_server_socket(glibhelper_unix_socket_server_support *handle, GMainContext *context, glibhelper_server_socket_config *config, void *userdata);
@@ -86,6 +114,11 @@ ssize_t glibhelper_server_socket_read(glibhelper_server_session_handle handle, v
 ssize_t glibhelper_server_socket_write(glibhelper_server_session_handle handle, void *buf, size_t count);
 glibhelper_unix_socket_server_support glibhelper_server_socket_server_support_from_session_handle(glibhelper_server_session_handle handle);
 int glibhelper_server_socket_broadcast(glibhelper_unix_socket_server_support handle, void *buf, size_t count);
+glibhelper_server_session_id glibhelper_server_get_session_id(glibhelper_server_session_handle handle);
+gboolean glibhelper_server_session_is_alive(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id);
+ssize_t glibhelper_server_socket_write_by_id(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id, void *buf, size_t count);
+glibhelper_server_session_handle glibhelper_server_session_from_id(glibhelper_unix_socket_server_support handle, glibhelper_server_session_id id);
+int glibhelper_server_socket_foreach_session(glibhelper_unix_socket_server_support handle, fp_foreach_session_callback_sv func, void *userdata);
 
 
 //-----------------------------------------------------------------------------
@@ -95,9 +128,11 @@ int glibhelper_client_get_fd(glibhelper_client_session_handle handle);
 void* glibhelper_client_get_userdata(glibhelper_client_session_handle handle);
 ssize_t glibhelper_client_socket_read(glibhelper_client_session_handle handle, void *buf, size_t count);
 ssize_t glibhelper_client_socket_write(glibhelper_client_session_handle handle, void *buf, size_t count);
+int glibhelper_client_socket_write_batch(glibhelper_client_session_handle handle, glibhelper_socket_packet *packets, int num);
 
 
 //-----------------------------------------------------------------------------
+#ifndef GLIBHELPER_EPOLL
 gboolean glibhelper_create_internal_socket(glibhelper_unix_socket_internal_support *handle, GMainContext *context, glibhelper_internal_socket_config *config, void* userdata);
 gboolean glibhelper_bind_secondary_internal_socket(glibhelper_unix_socket_internal_support *secondary_handle, glibhelper_unix_socket_internal_support primary_handle, 
 	GMainContext *context, glibhelper_internal_socket_config *config, void* userdata);
@@ -106,6 +141,8 @@ int glibhelper_internal_get_fd(glibhelper_internal_session_handle handle);
 void* glibhelper_internal_get_userdata(glibhelper_internal_session_handle handle);
 ssize_t glibhelper_internal_socket_read(glibhelper_internal_session_handle handle, void *buf, size_t count);
 ssize_t glibhelper_internal_socket_write(glibhelper_internal_session_handle handle, void *buf, size_t count);
+int glibhelper_internal_socket_write_batch(glibhelper_internal_session_handle handle, glibhelper_socket_packet *packets, int num);
+#endif //#ifndef GLIBHELPER_EPOLL
 
 
 //-----------------------------------------------------------------------------
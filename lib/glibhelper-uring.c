@@ -0,0 +1,775 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-uring.c
+ * @brief	io_uring backend for glib event loop
+ */
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "glibhelper-uring.h"
+
+#ifdef GLIBHELPER_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <linux/io_uring.h>
+
+#define URING_ENTRIES_DEFAULT (256)
+#define URING_BUFFER_SIZE_DEFAULT (4096)
+#define URING_BUFFER_NUM_DEFAULT (256)
+#define URING_BUFFER_GROUP (0)
+
+enum uring_request_type {
+	URING_REQUEST_RECV = 0,	// Multishot recv with provided buffers
+	URING_REQUEST_READ,	// Read to own buffer, submitted again after each completion
+};
+
+struct s_glibhelper_uring_request {
+	struct s_glibhelper_uring *ring;
+	enum uring_request_type type;
+	int fd;
+	fp_uring_completion_callback callback;
+	void *userdata;
+	gboolean inflight;	// Submitted and final completion is not reaped
+	gboolean cancelled;	// Owner released the request, it is freed at final completion
+	gboolean paused;	// Owner paused the request, it is not submitted again until resume
+	gboolean pausing;	// Cancel for pause is submitted, its final completion is not passed to the callback
+	size_t size;
+	uint8_t data[];	// Buffer of read request
+};
+
+struct s_uring_source {
+	GSource source;
+	struct s_glibhelper_uring *ring;
+	gpointer fd_tag;
+};
+
+struct s_glibhelper_uring {
+	int ring_fd;
+	struct s_uring_source *source;
+	GList *requests;	// All requests not freed
+
+	// Submission queue
+	void *sq_ptr;
+	size_t sq_size;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_array;
+	unsigned *sq_flags;	// IORING_SQ_CQ_OVERFLOW : completions are kept in the kernel until GETEVENTS enter
+	unsigned sq_mask;
+	unsigned sq_entries;
+	unsigned sq_local_tail;	// Filled entries, published at submit
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	// Completion queue
+	void *cq_ptr;
+	size_t cq_size;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+
+	// Provided buffer ring for receive
+	struct io_uring_buf_ring *buf_ring;
+	size_t buf_ring_size;
+	uint8_t *buffers;
+	unsigned buffer_size;
+	unsigned buffer_num;
+	uint16_t buf_tail;
+};
+//-----------------------------------------------------------------------------
+static int uring_setup(unsigned entries, struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+//-----------------------------------------------------------------------------
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+//-----------------------------------------------------------------------------
+static int uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+/**
+ * Check that the kernel supports multishot recv and provided buffer ring (Linux 6.0 or later).
+ * They were added in the same release as IORING_OP_SEND_ZC, so the opcode probe is used.
+ *
+ * @param [in]	ring_fd	io_uring fd
+ *
+ * @return gboolean
+ * @retval TRUE Supported.
+ * @retval FALSE Not supported.
+ */
+static gboolean uring_probe(int ring_fd)
+{
+	struct io_uring_probe *probe = NULL;
+	size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+	gboolean supported = FALSE;
+
+	probe = (struct io_uring_probe*)g_malloc(len);
+	if (probe == NULL)
+		return FALSE;
+	memset(probe, 0, len);
+
+	if (uring_register(ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+		if (probe->last_op >= IORING_OP_SEND_ZC
+			&& (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED) != 0)
+			supported = TRUE;
+	}
+
+	g_free(probe);
+
+	return supported;
+}
+//-----------------------------------------------------------------------------
+static void uring_buffer_recycle(struct s_glibhelper_uring *ring, unsigned bid)
+{
+	struct io_uring_buf *buf = &ring->buf_ring->bufs[ring->buf_tail & (ring->buffer_num - 1)];
+
+	buf->addr = (uint64_t)(uintptr_t)(ring->buffers + ((size_t)bid * ring->buffer_size));
+	buf->len = ring->buffer_size;
+	buf->bid = (uint16_t)bid;
+	ring->buf_tail++;
+	__atomic_store_n(&ring->buf_ring->tail, ring->buf_tail, __ATOMIC_RELEASE);
+}
+/**
+ * Submit filled entries to kernel. Entries filled in one loop iteration are submitted by one system call.
+ *
+ * @param [in]	ring	Ring
+ */
+static void uring_submit(struct s_glibhelper_uring *ring)
+{
+	unsigned pending = ring->sq_local_tail - (*ring->sq_tail);
+	int ret = 0;
+
+	if (pending == 0)
+		return;
+
+	__atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+	do {
+		ret = uring_enter(ring->ring_fd, pending, 0, 0);
+	} while (ret < 0 && errno == EINTR);
+}
+//-----------------------------------------------------------------------------
+static struct io_uring_sqe* uring_get_sqe(struct s_glibhelper_uring *ring)
+{
+	struct io_uring_sqe *sqe = NULL;
+	unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+	if (ring->sq_local_tail - head >= ring->sq_entries) {
+		// Full. Submit queued entries and retry.
+		uring_submit(ring);
+		head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+		if (ring->sq_local_tail - head >= ring->sq_entries)
+			return NULL;
+	}
+
+	sqe = &ring->sqes[ring->sq_local_tail & ring->sq_mask];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	ring->sq_local_tail++;
+
+	return sqe;
+}
+//-----------------------------------------------------------------------------
+static gboolean uring_request_submit(struct s_glibhelper_uring_request *request)
+{
+	struct io_uring_sqe *sqe = NULL;
+
+	sqe = uring_get_sqe(request->ring);
+	if (sqe == NULL)
+		return FALSE;
+
+	sqe->fd = request->fd;
+	sqe->user_data = (uint64_t)(uintptr_t)request;
+	if (request->type == URING_REQUEST_RECV) {
+		sqe->opcode = IORING_OP_RECV;
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = URING_BUFFER_GROUP;
+	} else {
+		sqe->opcode = IORING_OP_READ;
+		sqe->addr = (uint64_t)(uintptr_t)request->data;
+		sqe->len = (uint32_t)request->size;
+		sqe->off = (uint64_t)-1;	// Current file position
+	}
+	request->inflight = TRUE;
+
+	return TRUE;
+}
+//-----------------------------------------------------------------------------
+static void uring_request_free(struct s_glibhelper_uring_request *request)
+{
+	request->ring->requests = g_list_remove(request->ring->requests, request);
+	g_free(request);
+}
+/**
+ * Handle one completion.
+ *
+ * @param [in]	ring	Ring
+ * @param [in]	cqe	Completion
+ */
+static uint8_t uring_empty_packet[1];	// buf of zero length packet
+/**
+ * Check end of stream of socket. A zero length packet of SOCK_SEQPACKET ends multishot recv with res 0 as
+ * end of stream does, they are distinguished by the shutdown state of the socket.
+ *
+ * @param [in]	fd	Socket
+ *
+ * @return gboolean
+ * @retval TRUE End of stream (peer closed or error).
+ * @retval FALSE Zero length packet.
+ */
+static gboolean uring_recv_eof(int fd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLRDHUP;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) < 0)
+		return TRUE;
+
+	return ((pfd.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) != 0);
+}
+//-----------------------------------------------------------------------------
+static void uring_complete(struct s_glibhelper_uring *ring, struct io_uring_cqe *cqe)
+{
+	struct s_glibhelper_uring_request *request = (struct s_glibhelper_uring_request*)(uintptr_t)cqe->user_data;
+	gboolean more = ((cqe->flags & IORING_CQE_F_MORE) != 0);
+	gboolean has_buffer = ((cqe->flags & IORING_CQE_F_BUFFER) != 0);
+	unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	void *buf = NULL;
+	gboolean empty_packet = FALSE;
+	gboolean bret = TRUE;
+
+	if (request == NULL)
+		return;	// Completion of cancel request
+
+	if (request->cancelled == FALSE) {
+		if ((request->type == URING_REQUEST_RECV && cqe->res == -ENOBUFS)
+			|| (request->pausing == TRUE && cqe->res == -ECANCELED)) {
+			// All buffers are in use and the multishot recv was stopped (buffers are returned in this dispatch),
+			// or the request was stopped by pause. Submit again unless it is paused.
+			if (more == FALSE) {
+				request->inflight = FALSE;
+				request->pausing = FALSE;
+				if (request->paused == FALSE)
+					(void)uring_request_submit(request);
+			}
+			return;
+		}
+
+		if (has_buffer == TRUE)
+			buf = ring->buffers + ((size_t)bid * ring->buffer_size);
+		else if (request->type == URING_REQUEST_READ)
+			buf = request->data;
+
+		if (cqe->res == 0) {
+			// End of stream is passed with NULL buf.
+			if (request->type == URING_REQUEST_RECV && uring_recv_eof(request->fd) == FALSE) {
+				empty_packet = TRUE;
+				buf = uring_empty_packet;
+			} else {
+				buf = NULL;
+			}
+		}
+
+		// The request is in flight during the callback, so cancel in the callback does not free it.
+		bret = request->callback(request, cqe->res, buf, request->userdata);
+		if (bret == FALSE)
+			glibhelper_uring_cancel(request);
+	}
+
+	if (more == FALSE) {
+		request->inflight = FALSE;
+		request->pausing = FALSE;	// Completed before the cancel for pause
+		// Read is one-shot, and multishot recv can stop at completion queue overflow or zero length packet.
+		if (request->cancelled == FALSE && request->paused == FALSE && (cqe->res > 0 || empty_packet == TRUE))
+			(void)uring_request_submit(request);
+	}
+
+	if (has_buffer == TRUE)
+		uring_buffer_recycle(ring, bid);
+
+	if (request->cancelled == TRUE && request->inflight == FALSE)
+		uring_request_free(request);
+}
+/**
+ * Move overflowed completions from the kernel to the completion queue.
+ * When the completion queue is full, the kernel keeps completions in its overflow list and
+ * they are flushed only by io_uring_enter with IORING_ENTER_GETEVENTS.
+ *
+ * @param [in]	ring	Ring
+ */
+static void uring_cq_flush_overflow(struct s_glibhelper_uring *ring)
+{
+	int ret = 0;
+
+	if ((__atomic_load_n(ring->sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) == 0)
+		return;
+
+	do {
+		ret = uring_enter(ring->ring_fd, 0, 0, IORING_ENTER_GETEVENTS);
+	} while (ret < 0 && errno == EINTR);
+}
+//-----------------------------------------------------------------------------
+static gboolean uring_cq_pending(struct s_glibhelper_uring *ring)
+{
+	uring_cq_flush_overflow(ring);
+
+	return ((*ring->cq_head) != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE));
+}
+//-----------------------------------------------------------------------------
+static gboolean uring_source_prepare(GSource *source, gint *timeout)
+{
+	struct s_uring_source *uringsource = (struct s_uring_source*)source;
+
+	// Batched submission: all entries queued in previous dispatches are submitted before poll.
+	uring_submit(uringsource->ring);
+
+	*timeout = -1;
+
+	return uring_cq_pending(uringsource->ring);
+}
+//-----------------------------------------------------------------------------
+static gboolean uring_source_check(GSource *source)
+{
+	struct s_uring_source *uringsource = (struct s_uring_source*)source;
+
+	return uring_cq_pending(uringsource->ring);
+}
+//-----------------------------------------------------------------------------
+static gboolean uring_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+	struct s_uring_source *uringsource = (struct s_uring_source*)source;
+	struct s_glibhelper_uring *ring = uringsource->ring;
+	unsigned head = *ring->cq_head;
+	unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+	while (head != tail) {
+		uring_complete(ring, &ring->cqes[head & ring->cq_mask]);
+		head++;
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+		if (head == tail) {
+			// Reaped entries made room for overflowed completions.
+			uring_cq_flush_overflow(ring);
+			tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+		}
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+//-----------------------------------------------------------------------------
+static GSourceFuncs uring_source_funcs = {
+	.prepare = uring_source_prepare,
+	.check = uring_source_check,
+	.dispatch = uring_source_dispatch,
+	.finalize = NULL,
+};
+//-----------------------------------------------------------------------------
+static struct s_glibhelper_uring_request* uring_request_new(struct s_glibhelper_uring *ring, enum uring_request_type type,
+	int fd, size_t size, fp_uring_completion_callback callback, void *userdata)
+{
+	struct s_glibhelper_uring_request *request = NULL;
+
+	request = (struct s_glibhelper_uring_request*)g_malloc(sizeof(struct s_glibhelper_uring_request) + size);
+	if (request == NULL)
+		return NULL;
+	memset(request, 0, sizeof(struct s_glibhelper_uring_request));
+
+	request->ring = ring;
+	request->type = type;
+	request->fd = fd;
+	request->size = size;
+	request->callback = callback;
+	request->userdata = userdata;
+
+	if (uring_request_submit(request) == FALSE) {
+		g_free(request);
+		return NULL;
+	}
+	ring->requests = g_list_append(ring->requests, request);
+
+	return request;
+}
+/**
+ * Check that io_uring backend is available. It is not available when the library is built without
+ * --enable-io-uring, the kernel is older than Linux 6.0 or io_uring is disabled (ex. kernel.io_uring_disabled, seccomp).
+ *
+ * @return gboolean
+ * @retval TRUE Available.
+ * @retval FALSE Not available. Use the poll backend (pass NULL ring to helpers).
+ */
+gboolean glibhelper_uring_is_supported(void)
+{
+	struct io_uring_params params;
+	gboolean supported = FALSE;
+	int fd = -1;
+
+	memset(&params, 0, sizeof(params));
+	fd = uring_setup(2, &params);
+	if (fd < 0)
+		return FALSE;
+
+	supported = uring_probe(fd);
+	close(fd);
+
+	return supported;
+}
+/**
+ * Create io_uring and attach it to the context. The completions are dispatched in the context through the ring fd.
+ * When this function fails, helpers work with the poll backend by NULL ring.
+ *
+ * @param [in]	handle	Pointer to store created ring handle.
+ * @param [in]	context	Event loop context. NULL is default context.
+ * @param [in]	config	Ring configuration. NULL is default configuration.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error, resource allocation error or io_uring is not available.
+ */
+gboolean glibhelper_create_uring(glibhelper_uring *handle, GMainContext *context, glibhelper_uring_config *config)
+{
+	struct s_glibhelper_uring *ring = NULL;
+	struct io_uring_params params;
+	struct io_uring_buf_reg reg;
+	unsigned entries = URING_ENTRIES_DEFAULT;
+
+	if (handle == NULL)
+		return FALSE;
+
+	ring = (struct s_glibhelper_uring*)g_malloc(sizeof(struct s_glibhelper_uring));
+	if (ring == NULL)
+		return FALSE;
+	memset(ring, 0, sizeof(struct s_glibhelper_uring));
+	ring->ring_fd = -1;
+	ring->sq_ptr = MAP_FAILED;
+	ring->cq_ptr = MAP_FAILED;
+	ring->sqes = MAP_FAILED;
+	ring->buf_ring = MAP_FAILED;
+
+	ring->buffer_size = URING_BUFFER_SIZE_DEFAULT;
+	ring->buffer_num = URING_BUFFER_NUM_DEFAULT;
+	if (config != NULL) {
+		if (config->entries > 0)
+			entries = config->entries;
+		if (config->buffer_size > 0)
+			ring->buffer_size = config->buffer_size;
+		if (config->buffer_num > 0)
+			ring->buffer_num = config->buffer_num;
+	}
+	if (ring->buffer_num > 32768)
+		ring->buffer_num = 32768;	// Buffer ID is 16 bits, the ring size is up to 32768
+	if ((ring->buffer_num & (ring->buffer_num - 1)) != 0)
+		ring->buffer_num = 1U << (32 - __builtin_clz(ring->buffer_num));
+
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CLAMP;
+	ring->ring_fd = uring_setup(entries, &params);
+	if (ring->ring_fd < 0)
+		goto errorout;
+
+	if (uring_probe(ring->ring_fd) == FALSE || (params.features & IORING_FEAT_SINGLE_MMAP) == 0)
+		goto errorout;
+
+	// Submission and completion queue share one mapping.
+	ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (ring->cq_size > ring->sq_size)
+		ring->sq_size = ring->cq_size;
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED)
+		goto errorout;
+	ring->cq_ptr = ring->sq_ptr;
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+		goto errorout;
+
+	ring->sq_head = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.head);
+	ring->sq_tail = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.tail);
+	ring->sq_mask = *(unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.array);
+	ring->sq_flags = (unsigned*)((uint8_t*)ring->sq_ptr + params.sq_off.flags);
+	ring->sq_entries = params.sq_entries;
+	ring->sq_local_tail = *ring->sq_tail;
+	for (unsigned i=0; i < params.sq_entries; i++)
+		ring->sq_array[i] = i;	// Fixed index mapping
+
+	ring->cq_head = (unsigned*)((uint8_t*)ring->cq_ptr + params.cq_off.head);
+	ring->cq_tail = (unsigned*)((uint8_t*)ring->cq_ptr + params.cq_off.tail);
+	ring->cq_mask = *(unsigned*)((uint8_t*)ring->cq_ptr + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe*)((uint8_t*)ring->cq_ptr + params.cq_off.cqes);
+
+	// Provided buffer ring. Multishot recv picks a buffer for each packet.
+	ring->buf_ring_size = ring->buffer_num * sizeof(struct io_uring_buf);
+	ring->buf_ring = (struct io_uring_buf_ring*)mmap(NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ring->buf_ring == MAP_FAILED)
+		goto errorout;
+
+	ring->buffers = (uint8_t*)g_malloc((size_t)ring->buffer_num * ring->buffer_size);
+	if (ring->buffers == NULL)
+		goto errorout;
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+	reg.ring_entries = ring->buffer_num;
+	reg.bgid = URING_BUFFER_GROUP;
+	if (uring_register(ring->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+		goto errorout;
+
+	for (unsigned i=0; i < ring->buffer_num; i++)
+		uring_buffer_recycle(ring, i);
+
+	ring->source = (struct s_uring_source*)g_source_new(&uring_source_funcs, sizeof(struct s_uring_source));
+	if (ring->source == NULL)
+		goto errorout;
+	ring->source->ring = ring;
+	ring->source->fd_tag = g_source_add_unix_fd((GSource*)ring->source, ring->ring_fd, G_IO_IN);
+	(void)g_source_attach((GSource*)ring->source, context);	// Keep reference until terminate
+
+	(*handle) = (glibhelper_uring)(ring);
+
+	return TRUE;
+
+errorout:
+	g_free(ring->buffers);
+
+	if (ring->buf_ring != MAP_FAILED)
+		(void)munmap(ring->buf_ring, ring->buf_ring_size);
+
+	if (ring->sqes != MAP_FAILED)
+		(void)munmap(ring->sqes, ring->sqes_size);
+
+	if (ring->sq_ptr != MAP_FAILED)
+		(void)munmap(ring->sq_ptr, ring->sq_size);
+
+	if (ring->ring_fd >= 0)
+		(void)close(ring->ring_fd);
+
+	g_free(ring);
+
+	return FALSE;
+}
+/**
+ * Terminate io_uring. Pending requests are cancelled by the kernel and released without callback.
+ * Terminate the helpers using the ring before this function.
+ *
+ * @param [in]	handle	Ring handle.
+ *
+ * @return gboolean
+ * @retval TRUE Success.
+ * @retval FALSE Arg error.
+ */
+gboolean glibhelper_terminate_uring(glibhelper_uring handle)
+{
+	struct s_glibhelper_uring *ring = NULL;
+
+	if (handle == NULL)
+		return FALSE;// Arg error
+
+	ring = (struct s_glibhelper_uring*)handle;
+
+	g_source_destroy((GSource*)ring->source);
+	g_source_unref((GSource*)ring->source);
+
+	// Closing the ring fd cancels all in flight requests and waits them.
+	(void)munmap(ring->sqes, ring->sqes_size);
+	(void)munmap(ring->sq_ptr, ring->sq_size);
+	(void)close(ring->ring_fd);
+
+	g_list_free_full(ring->requests, g_free);
+	(void)munmap(ring->buf_ring, ring->buf_ring_size);
+	g_free(ring->buffers);
+	g_free(ring);
+
+	return TRUE;
+}
+/**
+ * Start multishot receive. The callback is called for each received packet until the request is cancelled,
+ * or the peer closes the socket (res = 0) or an error (res < 0) occurs.
+ * The receive is submitted with the other requests of the loop iteration.
+ *
+ * @param [in]	handle	Ring handle.
+ * @param [in]	fd	Socket fd. It shall be kept open until glibhelper_uring_cancel.
+ * @param [in]	callback	Completion callback.
+ * @param [in]	userdata	Argument of the callback.
+ *
+ * @return glibhelper_uring_request
+ * @retval !NULL Request.
+ * @retval NULL Arg error or resource allocation error.
+ */
+glibhelper_uring_request glibhelper_uring_recv(glibhelper_uring handle, int fd, fp_uring_completion_callback callback, void *userdata)
+{
+	if (handle == NULL || fd < 0 || callback == NULL)
+		return NULL;
+
+	return (glibhelper_uring_request)uring_request_new((struct s_glibhelper_uring*)handle, URING_REQUEST_RECV, fd, 0, callback, userdata);
+}
+/**
+ * Start repeated read. The read is submitted again after each completion, until the request is cancelled
+ * or res <= 0. It is used for the fds that produce a fixed size record per event (ex. timerfd, eventfd).
+ *
+ * @param [in]	handle	Ring handle.
+ * @param [in]	fd	fd. It shall be kept open until glibhelper_uring_cancel.
+ * @param [in]	size	Read size.
+ * @param [in]	callback	Completion callback.
+ * @param [in]	userdata	Argument of the callback.
+ *
+ * @return glibhelper_uring_request
+ * @retval !NULL Request.
+ * @retval NULL Arg error or resource allocation error.
+ */
+glibhelper_uring_request glibhelper_uring_read(glibhelper_uring handle, int fd, size_t size, fp_uring_completion_callback callback, void *userdata)
+{
+	if (handle == NULL || fd < 0 || size == 0 || callback == NULL)
+		return NULL;
+
+	return (glibhelper_uring_request)uring_request_new((struct s_glibhelper_uring*)handle, URING_REQUEST_READ, fd, size, callback, userdata);
+}
+/**
+ * Cancel request. The callback is never called after this function. It can be called in the callback.
+ * The request is released when the kernel completes it.
+ *
+ * @param [in]	request	Request. NULL is ignored.
+ */
+void glibhelper_uring_cancel(glibhelper_uring_request request)
+{
+	struct s_glibhelper_uring_request *req = (struct s_glibhelper_uring_request*)request;
+	struct io_uring_sqe *sqe = NULL;
+
+	if (req == NULL || req->cancelled == TRUE)
+		return;
+
+	req->cancelled = TRUE;
+
+	if (req->inflight == FALSE) {
+		uring_request_free(req);
+		return;
+	}
+
+	sqe = uring_get_sqe(req->ring);
+	if (sqe == NULL)
+		return;	// The request is released at terminate
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = (uint64_t)(uintptr_t)req;
+	sqe->user_data = 0;
+	// Submit now. The owner closes the fd after this function, and the peer shall see it without delay.
+	uring_submit(req->ring);
+}
+/**
+ * Pause request. The request is stopped in the kernel and not submitted again until glibhelper_uring_resume.
+ * Completions already posted by the kernel are still passed to the callback, no received data is lost.
+ * It can be called in the callback.
+ *
+ * @param [in]	request	Request. NULL is ignored.
+ */
+void glibhelper_uring_pause(glibhelper_uring_request request)
+{
+	struct s_glibhelper_uring_request *req = (struct s_glibhelper_uring_request*)request;
+	struct io_uring_sqe *sqe = NULL;
+
+	if (req == NULL || req->cancelled == TRUE || req->paused == TRUE)
+		return;
+
+	req->paused = TRUE;
+	if (req->inflight == FALSE || req->pausing == TRUE)
+		return;
+
+	sqe = uring_get_sqe(req->ring);
+	if (sqe == NULL)
+		return;	// Not stopped in the kernel, it is not submitted again after its final completion
+
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = (uint64_t)(uintptr_t)req;
+	sqe->user_data = 0;
+	req->pausing = TRUE;
+}
+/**
+ * Resume paused request. It is submitted with the other requests of the loop iteration.
+ *
+ * @param [in]	request	Request. NULL is ignored.
+ */
+void glibhelper_uring_resume(glibhelper_uring_request request)
+{
+	struct s_glibhelper_uring_request *req = (struct s_glibhelper_uring_request*)request;
+
+	if (req == NULL || req->cancelled == TRUE || req->paused == FALSE)
+		return;
+
+	req->paused = FALSE;
+	// In flight request is submitted again at the final completion of the cancel for pause.
+	if (req->inflight == FALSE)
+		(void)uring_request_submit(req);
+}
+#else //#ifdef GLIBHELPER_IO_URING
+/**
+ * Check that io_uring backend is available. The library is built without --enable-io-uring.
+ *
+ * @return gboolean
+ * @retval FALSE Not available. Use the poll backend (pass NULL ring to helpers).
+ */
+gboolean glibhelper_uring_is_supported(void)
+{
+	return FALSE;
+}
+/**
+ * Create io_uring. The library is built without --enable-io-uring, so it always fails
+ * and the helpers work with the poll backend by NULL ring.
+ *
+ * @param [in]	handle	Pointer to store created ring handle.
+ * @param [in]	context	Event loop context.
+ * @param [in]	config	Ring configuration.
+ *
+ * @return gboolean
+ * @retval FALSE Not available.
+ */
+gboolean glibhelper_create_uring(glibhelper_uring *handle, GMainContext *context, glibhelper_uring_config *config)
+{
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+gboolean glibhelper_terminate_uring(glibhelper_uring handle)
+{
+	return FALSE;
+}
+//-----------------------------------------------------------------------------
+glibhelper_uring_request glibhelper_uring_recv(glibhelper_uring handle, int fd, fp_uring_completion_callback callback, void *userdata)
+{
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+glibhelper_uring_request glibhelper_uring_read(glibhelper_uring handle, int fd, size_t size, fp_uring_completion_callback callback, void *userdata)
+{
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+void glibhelper_uring_cancel(glibhelper_uring_request request)
+{
+}
+//-----------------------------------------------------------------------------
+void glibhelper_uring_pause(glibhelper_uring_request request)
+{
+}
+//-----------------------------------------------------------------------------
+void glibhelper_uring_resume(glibhelper_uring_request request)
+{
+}
+#endif //#ifdef GLIBHELPER_IO_URING
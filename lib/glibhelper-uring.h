@@ -0,0 +1,51 @@
+/**
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * @file	glibhelper-uring.h
+ * @brief	header for glibhelper-uring
+ */
+#ifndef GLIBHELPER_URING_H
+#define GLIBHELPER_URING_H
+//-----------------------------------------------------------------------------
+#ifdef GLIBHELPER_EPOLL
+#include "glibhelper-epoll.h"
+#else
+#include <glib.h>
+#include <gio/gio.h>
+#endif
+
+#include <stdint.h>
+
+struct s_glibhelper_uring;
+typedef struct s_glibhelper_uring *glibhelper_uring;
+
+struct s_glibhelper_uring_request;
+typedef struct s_glibhelper_uring_request *glibhelper_uring_request;
+
+/**
+ * Completion callback. res is number of bytes (>0), 0 at end of stream or -errno.
+ * A zero length packet of receive is res 0 with non NULL buf, end of stream is res 0 with NULL buf.
+ * buf is valid only in the callback. Return FALSE to stop the request (same as glibhelper_uring_cancel).
+ * After a completion with res < 0 or end of stream, the request is not active and the owner shall cancel it.
+ */
+typedef gboolean (*fp_uring_completion_callback)(glibhelper_uring_request request, int res, void *buf, void *userdata);
+
+/** glibhelper_uring_config.*/
+typedef struct s_glibhelper_uring_config {
+	unsigned int entries; /**< Number of submission queue entries. 0 = default (256). */
+	unsigned int buffer_size; /**< Size of receive buffer. Longer packets are truncated. 0 = default (4096). */
+	unsigned int buffer_num; /**< Number of receive buffers shared by all receive requests, round up to power of 2. 0 = default (256). */
+} glibhelper_uring_config;
+
+//-----------------------------------------------------------------------------
+gboolean glibhelper_uring_is_supported(void);
+gboolean glibhelper_create_uring(glibhelper_uring *handle, GMainContext *context, glibhelper_uring_config *config);
+gboolean glibhelper_terminate_uring(glibhelper_uring handle);
+glibhelper_uring_request glibhelper_uring_recv(glibhelper_uring handle, int fd, fp_uring_completion_callback callback, void *userdata);
+glibhelper_uring_request glibhelper_uring_read(glibhelper_uring handle, int fd, size_t size, fp_uring_completion_callback callback, void *userdata);
+void glibhelper_uring_cancel(glibhelper_uring_request request);
+void glibhelper_uring_pause(glibhelper_uring_request request);
+void glibhelper_uring_resume(glibhelper_uring_request request);
+
+//-----------------------------------------------------------------------------
+#endif //#ifndef GLIBHELPER_URING_H
@@ -13,8 +13,10 @@
 
 #include "glibhelper-unix-socket-support.h"
 #include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-internal-ring.h"
 #include "glibhelper-timerfd-support.h"
 #include "glibhelper-signal.h"
+#include "glibhelper-loop-thread.h"
 
 #include "example-common.h"
 
@@ -25,15 +27,15 @@
 
 typedef struct s_example_data_struct_sub {
 	glibhelper_unix_socket_client_support clisochandle;
-	glibhelper_unix_socket_internal_support insochandle;
+	glibhelper_internal_ring insochandle;
 } example_data_struct_sub;
 
 typedef struct s_example_data_struct_main {
-	glibhelper_unix_socket_internal_support insochandle;
+	glibhelper_internal_ring insochandle;
 	glibhelper_timerfd_support_handle timerhandle;
 } example_data_struct_main;
 
-char exampledata[1024];
+#define EXAMPLE_DATA_SIZE (1024)
 //-----------------------------------------------------------------------------
 static gboolean receive_cb(glibhelper_client_session_handle session)
 {
@@ -75,11 +77,19 @@ static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
 {
 	ssize_t ret = -1; 
 	example_data_struct_main *ex;
+	char *exampledata = NULL;
 	
 	ex = (example_data_struct_main *)glibhelper_timerfd_get_userdata(handle);
 
 	if (ex->insochandle != NULL) {
-		ret = glibhelper_client_socket_write(ex->insochandle,exampledata, sizeof(exampledata)); 
+		// Pass heap buffer to sub thread without copy. Sub thread releases it.
+		exampledata = (char*)g_malloc(EXAMPLE_DATA_SIZE);
+		if (exampledata != NULL) {
+			(void)snprintf(exampledata, EXAMPLE_DATA_SIZE, "example data %ld", g_get_monotonic_time());
+			ret = glibhelper_internal_ring_write_ptr(ex->insochandle, exampledata, EXAMPLE_DATA_SIZE, g_free);
+			if (ret < 0)
+				g_free(exampledata);
+		}
 	}
 	fprintf (stderr, "timer cb\n");
 
@@ -88,29 +98,35 @@ static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
 //-----------------------------------------------------------------------------
 static gboolean receive_cb_in_primary(glibhelper_internal_session_handle session)
 {
-	fprintf (stderr, "Internal socket primary in \n");
+	fprintf (stderr, "Internal ring primary in \n");
 
 	return TRUE;
 }
 //-----------------------------------------------------------------------------
 static void destroyed_session_cb_in_primary(glibhelper_internal_session_handle session)
 {
-	fprintf (stderr, "Internal socket disconnected cb primary\n");
+	fprintf (stderr, "Internal ring disconnected cb primary\n");
 }
 //-----------------------------------------------------------------------------
 static gboolean receive_cb_in_secondary(glibhelper_internal_session_handle session)
 {
 	ssize_t ret = 0;
-
-	ret = glibhelper_internal_socket_read(session, exampledata, sizeof(exampledata));
-	fprintf (stderr, "Internal socket secondary in %ld\n",ret);
+	void *exampledata = NULL;
+	fp_release_callback_in release = NULL;
+
+	ret = glibhelper_internal_ring_read_ptr(session, &exampledata, &release);
+	if (ret > 0) {
+		fprintf (stderr, "Internal ring secondary in %ld \"%s\"\n",ret,(char*)exampledata);
+		if (release != NULL)
+			release(exampledata);
+	}
 
 	return TRUE;
 }
 //-----------------------------------------------------------------------------
 static void destroyed_session_cb_in_secondary(glibhelper_internal_session_handle session)
 {
-	fprintf (stderr, "Internal socket disconnected cb secondary\n");
+	fprintf (stderr, "Internal ring disconnected cb secondary\n");
 }
 //-----------------------------------------------------------------------------
 static glibhelper_client_socket_config scfg = {
@@ -122,23 +138,7 @@ static 	glibhelper_timerfd_config tcfg = {
 	.interval = 1000 * 1000 * 1000 //(ns)
 };
 
-glibhelper_internal_socket_config inscfg;
-//-----------------------------------------------------------------------------
-typedef struct s_sub_thread_data {
-	GMainLoop *gsubloop;
-	example_data_struct_sub *ex_sub;
-} sub_thread_data;
-//-----------------------------------------------------------------------------
-static gpointer subthread(gpointer data)
-{
-	sub_thread_data *subdata = (sub_thread_data*)data;
-
-    g_main_loop_run(subdata->gsubloop);
-
-	fprintf(stderr,"subthread exit\n");
-
-	return NULL;
-}
+glibhelper_internal_ring_config inscfg;
 //-----------------------------------------------------------------------------
 int main (int argc, char **argv)
 {
@@ -148,27 +148,35 @@ int main (int argc, char **argv)
 	example_data_struct_main ex_main = {NULL};
 	example_data_struct_sub ex_sub = {NULL};
 	GMainContext *subctx = NULL;
-	GMainLoop *gsubloop = NULL;
-	GThread *sub_thread = NULL;
+	glibhelper_loop_thread loopthread = NULL;
+	glibhelper_loop_thread_config lcfg = {
+		.name = "cli-loop",
+		.strict = FALSE,
+		.spin = 50 * 1000	// Busy-poll 50us after each event to skip wakeup latency of next response
+	};
 
 	glibhelper_unix_socket_client_support sochandle = NULL;
-	glibhelper_unix_socket_internal_support insochandle_p = NULL;
-	glibhelper_unix_socket_internal_support insochandle_s = NULL;
+	glibhelper_internal_ring insochandle_p = NULL;
+	glibhelper_internal_ring insochandle_s = NULL;
 	glibhelper_timerfd_support_handle timerhandle = NULL;
 
-	sub_thread_data sub_data;
-
 	gloop = g_main_loop_new(NULL, FALSE);	//get default event loop context
 	if (gloop == NULL)
 		goto finish;
 
-	subctx = g_main_context_new();
-	gsubloop = g_main_loop_new(subctx, FALSE);
-
+	// Signal mask (SIGPIPE etc.) shall be set before the loop thread starts, the thread inherits it.
 	bret = glibhelper_siganl_initialize(gloop);
 	if (bret == FALSE)
 		goto finish;
 
+	// Settings failure (ex. no permission for realtime policy) is not fatal in non strict mode.
+	bret = glibhelper_create_loop_thread(&loopthread, &lcfg);
+	if (bret == FALSE)
+		goto finish;
+	if (glibhelper_loop_thread_get_error(loopthread) != 0)
+		fprintf(stderr,"loop thread settings are not applied: %s\n", strerror(glibhelper_loop_thread_get_error(loopthread)));
+	subctx = glibhelper_loop_thread_get_context(loopthread);
+
 	scfg.operation.receive = receive_cb;
 	scfg.operation.destroyed_session = destroyed_session_cb;
 
@@ -180,23 +188,23 @@ int main (int argc, char **argv)
 	}
 	ex_sub.clisochandle = sochandle;
 
-	inscfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(2*1024, 16);
+	inscfg.packet_max_size = 2*1024;
+	inscfg.packet_max_num = 16;
 	inscfg.operation.receive = receive_cb_in_primary;
 	inscfg.operation.destroyed_session = destroyed_session_cb_in_primary;
 
-	bret = glibhelper_create_internal_socket(&insochandle_p, NULL, &inscfg, &ex_main);
+	bret = glibhelper_create_internal_ring(&insochandle_p, NULL, &inscfg, &ex_main);
 	if (bret != TRUE) {
-		fprintf(stderr,"glibhelper_create_internal_socket error\n");
+		fprintf(stderr,"glibhelper_create_internal_ring error\n");
 	}
 	ex_main.insochandle = insochandle_p;
 
-	inscfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(2*1024, 16);
 	inscfg.operation.receive = receive_cb_in_secondary;
 	inscfg.operation.destroyed_session = destroyed_session_cb_in_secondary;
 
-	bret = glibhelper_bind_secondary_internal_socket(&insochandle_s, insochandle_p, subctx, &inscfg, &ex_sub);
+	bret = glibhelper_bind_secondary_internal_ring(&insochandle_s, insochandle_p, subctx, &inscfg, &ex_sub);
 	if (bret != TRUE) {
-		fprintf(stderr,"glibhelper_create_internal_socket error\n");
+		fprintf(stderr,"glibhelper_bind_secondary_internal_ring error\n");
 	}
 	ex_sub.insochandle = insochandle_s;
 
@@ -206,30 +214,27 @@ int main (int argc, char **argv)
 	}
 	ex_main.timerhandle = timerhandle;
 
-	sub_data.gsubloop = gsubloop;
-	sub_data.ex_sub = &ex_sub;
-
-	sub_thread = g_thread_new("subthread_cli", subthread, &sub_data);
-
     g_main_loop_run(gloop);
 
-	g_main_loop_quit(gsubloop);
-	(void)g_thread_join(sub_thread);
 finish:
+	// Stop sub loop before helpers in the context are terminated.
+	if (loopthread != NULL)
+		(void)glibhelper_loop_thread_stop(loopthread);
+
 	if (timerhandle != NULL)
 		glibhelper_terminate_timerfd(timerhandle);
 
 	if (ex_sub.insochandle != NULL)
-		glibhelper_terminate_internal_socket(ex_sub.insochandle);
+		glibhelper_terminate_internal_ring(ex_sub.insochandle);
 
 	if (ex_main.insochandle != NULL)
-		glibhelper_terminate_internal_socket(ex_main.insochandle);
+		glibhelper_terminate_internal_ring(ex_main.insochandle);
 
 	if (ex_sub.clisochandle != NULL)
 		glibhelper_terminate_client_socket(ex_sub.clisochandle);
 
-	g_main_loop_ref(gsubloop);
-	g_main_context_unref(subctx);
+	if (loopthread != NULL)
+		glibhelper_terminate_loop_thread(loopthread);
 
 	fprintf(stderr,"term!!\n");
 
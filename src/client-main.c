@@ -13,6 +13,7 @@
 
 #include "glibhelper-unix-socket-support.h"
 #include "glibhelper-unix-socket-support-util.h"
+#include "glibhelper-unix-socket-support-managed-client.h"
 #include "glibhelper-timerfd-support.h"
 #include "glibhelper-signal.h"
 
@@ -23,29 +24,30 @@
 #include <gio/gio.h>
 
 typedef struct s_example_data_struct {
-	glibhelper_unix_socket_client_support sochandle;
+	glibhelper_unix_socket_managed_client sochandle;
 	
 } example_data_struct;
 
 char exampledata[1024];
 //-----------------------------------------------------------------------------
-static gboolean receive_cb(glibhelper_client_session_handle session)
+static void connected_cb(glibhelper_managed_session_handle session)
+{
+	fprintf (stderr, "connected cb\n");
+}
+//-----------------------------------------------------------------------------
+static gboolean receive_cb(glibhelper_managed_session_handle session)
 {
 	ssize_t ret = 0;
 
-	ret = glibhelper_client_socket_read(session, exampledata, sizeof(exampledata));
+	ret = glibhelper_managed_client_socket_read(session, exampledata, sizeof(exampledata));
 	fprintf (stderr, "cli in %ld\n",ret);
 
 	return TRUE;
 }
 //-----------------------------------------------------------------------------
-static void destroyed_session_cb(glibhelper_client_session_handle session)
+static void disconnected_cb(glibhelper_managed_session_handle session)
 {
-	example_data_struct *ex;
-	
-	ex = (example_data_struct *)glibhelper_client_get_userdata(session);
-	ex->sochandle = NULL;
-
+	// The managed client reconnects automatically, the handle is still valid.
 	fprintf (stderr, "disconnected cb\n");
 }
 //-----------------------------------------------------------------------------
@@ -57,16 +59,19 @@ static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
 	ex = (example_data_struct *)glibhelper_timerfd_get_userdata(handle);
 
 	if (ex->sochandle != NULL) {
-		ret = glibhelper_client_socket_write(ex->sochandle,exampledata, sizeof(exampledata)); 
+		ret = glibhelper_managed_client_socket_write(ex->sochandle,exampledata, sizeof(exampledata)); 
 	}
 	fprintf (stderr, "timer cb\n");
 
 	return TRUE;
 }
 //-----------------------------------------------------------------------------
-static glibhelper_client_socket_config scfg = {
+static glibhelper_managed_client_config scfg = {
 	//.socket_name = SOCKET_NAME
-	.socket_name = "\0/agl/testserver"
+	.socket_name = "\0/agl/testserver",
+	.backoff_initial = 100, //(ms)
+	.backoff_max = 5000, //(ms)
+	.sendqueue_max = 16
 };
 
 static 	glibhelper_timerfd_config tcfg = {
@@ -80,7 +85,7 @@ int main (int argc, char **argv)
 	gboolean bret = FALSE;
 	example_data_struct ex= {NULL};
 
-	glibhelper_unix_socket_client_support sochandle = NULL;;
+	glibhelper_unix_socket_managed_client sochandle = NULL;;
 	glibhelper_timerfd_support_handle timerhandle = NULL;
 
 	gloop = g_main_loop_new(NULL, FALSE);	//get default event loop context
@@ -91,14 +96,15 @@ int main (int argc, char **argv)
 	if (bret == FALSE)
 		goto finish;
 
+	scfg.operation.connected = connected_cb;
 	scfg.operation.receive = receive_cb;
-	scfg.operation.destroyed_session = destroyed_session_cb;
+	scfg.operation.disconnected = disconnected_cb;
 
 	tcfg.operation.timeout = timeout_cb;
 
-	bret = glibhelper_connect_socket(&sochandle, NULL, &scfg, &ex);
+	bret = glibhelper_create_managed_client(&sochandle, NULL, &scfg, &ex);
 	if (bret != TRUE) {
-		fprintf(stderr,"glibhelper_connect_socket error\n");
+		fprintf(stderr,"glibhelper_create_managed_client error\n");
 	}
 
 	ex.sochandle = sochandle;
@@ -116,7 +122,7 @@ finish:
 		glibhelper_terminate_timerfd(timerhandle);
 
 	if (ex.sochandle != NULL)
-		glibhelper_terminate_client_socket(ex.sochandle);
+		glibhelper_terminate_managed_client(ex.sochandle);
 
 	fprintf(stderr,"term!!\n");
 
@@ -15,6 +15,7 @@
 #include "glibhelper-unix-socket-support-util.h"
 #include "glibhelper-timerfd-support.h"
 #include "glibhelper-signal.h"
+#include "glibhelper-loop-thread.h"
 
 
 #define SOCKET_NAME "/tmp/9Lq7BNBnBycd6nxy.socket"
@@ -22,9 +23,19 @@
 #include <glib.h>
 #include <gio/gio.h>
 
+//-----------------------------------------------------------------------------
+// Latest session. It is written by sub thread and read by main thread.
+G_LOCK_DEFINE_STATIC(latest_session);
+static glibhelper_unix_socket_server_support latest_server = NULL;
+static glibhelper_server_session_id latest_session_id = 0;
 //-----------------------------------------------------------------------------
 static void get_new_session_cb(glibhelper_server_session_handle session)
 {
+	G_LOCK(latest_session);
+	latest_server = glibhelper_server_socket_server_support_from_session_handle(session);
+	latest_session_id = glibhelper_server_get_session_id(session);
+	G_UNLOCK(latest_session);
+
 	fprintf (stderr, "connected\n");
 }
 //-----------------------------------------------------------------------------
@@ -49,7 +60,21 @@ static void destroyed_session_cb(glibhelper_server_session_handle session)
 //-----------------------------------------------------------------------------
 static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
 {
-	fprintf (stderr, "timer cb\n");
+	glibhelper_unix_socket_server_support server = NULL;
+	glibhelper_server_session_id id = 0;
+	uint64_t hoge[4] = {0};
+	ssize_t ret = -1;
+
+	G_LOCK(latest_session);
+	server = latest_server;
+	id = latest_session_id;
+	G_UNLOCK(latest_session);
+
+	// Send from main thread. The session is owned by sub thread.
+	if (server != NULL)
+		ret = glibhelper_server_socket_write_by_id(server, id, hoge, sizeof(hoge));
+
+	fprintf (stderr, "timer cb (send by id %ld)\n", ret);
 
 	return TRUE;
 }
@@ -63,48 +88,38 @@ static 	glibhelper_timerfd_config tcfg = {
 	.interval = 1000 * 1000 * 1000 //(ns)
 };
 //-----------------------------------------------------------------------------
-typedef struct s_sub_thread_data {
-	GMainLoop *gsubloop;
-	glibhelper_unix_socket_server_support sochandle;
-	glibhelper_timerfd_support_handle timerhandle;
-} sub_thread_data;
-//-----------------------------------------------------------------------------
-static gpointer subthread(gpointer data)
-{
-	sub_thread_data *subdata = (sub_thread_data*)data;
-
-    g_main_loop_run(subdata->gsubloop);
-
-	fprintf(stderr,"subthread exit\n");
-
-	return NULL;
-}
-//-----------------------------------------------------------------------------
 int main (int argc, char **argv)
 {
 	GMainLoop *gloop = NULL;
 	int ret = -1;
 	gboolean bret = FALSE;
 	GMainContext *subctx = NULL;
-	GMainLoop *gsubloop = NULL;
-	GThread *sub_thread = NULL;
+	glibhelper_loop_thread loopthread = NULL;
+	glibhelper_loop_thread_config lcfg = {
+		.name = "sv-loop",
+		.strict = FALSE
+	};
 
 	glibhelper_unix_socket_server_support sochandle = NULL;
 	glibhelper_timerfd_support_handle timerhandle = NULL;
 
-	sub_thread_data sub_data;
-
 	gloop = g_main_loop_new(NULL, FALSE);	//get default event loop context
 	if (gloop == NULL)
 		goto finish;
 
-	subctx = g_main_context_new();
-	gsubloop = g_main_loop_new(subctx, FALSE);
-
+	// Signal mask (SIGPIPE etc.) shall be set before the loop thread starts, the thread inherits it.
 	bret = glibhelper_siganl_initialize(gloop);
 	if (bret == FALSE)
 		goto finish;
 
+	// Settings failure (ex. no permission for realtime policy) is not fatal in non strict mode.
+	bret = glibhelper_create_loop_thread(&loopthread, &lcfg);
+	if (bret == FALSE)
+		goto finish;
+	if (glibhelper_loop_thread_get_error(loopthread) != 0)
+		fprintf(stderr,"loop thread settings are not applied: %s\n", strerror(glibhelper_loop_thread_get_error(loopthread)));
+	subctx = glibhelper_loop_thread_get_context(loopthread);
+
 	scfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(2*1024, 16);
 	scfg.operation.get_new_session = get_new_session_cb;
 	scfg.operation.receive = receive_cb;
@@ -117,22 +132,17 @@ int main (int argc, char **argv)
 		fprintf(stderr,"glibhelper_create_server_socket error\n");
 	}
 
-	bret = glibhelper_create_timerfd(&timerhandle, subctx, &tcfg, NULL);
+	bret = glibhelper_create_timerfd(&timerhandle, NULL, &tcfg, NULL);
 	if (bret != TRUE) {
 		fprintf(stderr,"glibhelper_create_timerfd error\n");
 	}
 
-	sub_data.gsubloop = gsubloop;
-	sub_data.sochandle = sochandle;
-	sub_data.timerhandle = timerhandle;
-
-	sub_thread = g_thread_new("subthread", subthread, &sub_data);
-
     g_main_loop_run(gloop);
 
-	g_main_loop_quit(gsubloop);
-	(void)g_thread_join(sub_thread);
 finish:
+	// Stop sub loop before helpers in the context are terminated.
+	if (loopthread != NULL)
+		(void)glibhelper_loop_thread_stop(loopthread);
 
 	if (timerhandle != NULL)
 		glibhelper_terminate_timerfd(timerhandle);
@@ -140,6 +150,9 @@ finish:
 	if (sochandle != NULL)
 		glibhelper_terminate_server_socket(sochandle);
 
+	if (loopthread != NULL)
+		glibhelper_terminate_loop_thread(loopthread);
+
 	fprintf(stderr,"term!!\n");
 
 	return 0;
@@ -14,7 +14,9 @@
 #include "glibhelper-unix-socket-support.h"
 #include "glibhelper-unix-socket-support-util.h"
 #include "glibhelper-timerfd-support.h"
+#include "glibhelper-broadcast-scheduler.h"
 #include "glibhelper-signal.h"
+#include "glibhelper-loop-monitor.h"
 
 #include "example-common.h"
 
@@ -26,6 +28,9 @@
 typedef struct s_example_data_struct {
 	glibhelper_unix_socket_server_support sochandle;
 	glibhelper_timerfd_support_handle timerfd;
+	glibhelper_broadcast_scheduler scheduler;
+	glibhelper_signal_support signal;
+	glibhelper_loop_monitor monitor;
 } example_data_struct;
 
 //-----------------------------------------------------------------------------
@@ -53,7 +58,7 @@ static void destroyed_session_cb(glibhelper_server_session_handle session)
 	fprintf (stderr, "disconnected cb\n");
 }
 //-----------------------------------------------------------------------------
-static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
+static gboolean timeout_cb(glibhelper_timerfd_support_handle handle, const glibhelper_timerfd_info *info)
 {
 	example_data_struct *ex = NULL;
 	void *ptr = NULL;
@@ -62,6 +67,12 @@ static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
 	ex_command_str_t cmd;
 
 	//fprintf (stderr, "timer cb\n");
+	if (info->expirations > 1) {
+		// Event loop was stalled. Send one broadcast for missed ticks.
+		fprintf (stderr, "broadcast tick missed %lu (late %ld us, total overrun %lu)\n",
+				info->expirations - 1, info->lateness / 1000, glibhelper_timerfd_get_overrun(handle));
+	}
+
 	memset(&cmd,0,sizeof(cmd));
 	cmd.command = EX_COMMAND_SEND_STR;
 	strncpy(cmd.str, "broadcast to client from server", sizeof(cmd.str)-1);
@@ -69,20 +80,51 @@ static gboolean timeout_cb(glibhelper_timerfd_support_handle handle)
 	ptr = glibhelper_timerfd_get_userdata(handle);
 	if (ptr != NULL) {
 		ex = (example_data_struct*)ptr;
-		ret = glibhelper_server_socket_broadcast(ex->sochandle, &cmd, sizeof(cmd));
+		// Load shedding: skip periodic broadcast while the loop is overloaded.
+		if (glibhelper_loop_monitor_is_overloaded(ex->monitor) == TRUE)
+			return TRUE;
+		// Paced per session. Not yet sent status is replaced by the latest one (key 1).
+		ret = glibhelper_broadcast_scheduler_publish(ex->scheduler, 1, &cmd, sizeof(cmd));
 		fprintf (stderr, "broadcast to client from server (client = %d)\n",ret);
 	}
 
 	return TRUE;
 }
 //-----------------------------------------------------------------------------
+static void reload_cb(glibhelper_signal_support handle, int signo)
+{
+	fprintf (stderr, "reload requested (signal %d)\n", signo);
+}
+//-----------------------------------------------------------------------------
+static void overload_cb(glibhelper_loop_monitor handle, gboolean overloaded, uint64_t lag)
+{
+	fprintf (stderr, "loop %s (lag %lu us)\n", (overloaded == TRUE) ? "overloaded" : "recovered", (unsigned long)(lag / 1000));
+}
+//-----------------------------------------------------------------------------
 static glibhelper_server_socket_config scfg = {
 	//.socket_name = SOCKET_NAME
 	.socket_name = "\0/agl/testserver"
 };
 
+static glibhelper_broadcast_scheduler_config bcfg = {
+	.rate = 10,	// packets/s per client
+	.burst = 4,
+};
+
 static 	glibhelper_timerfd_config tcfg = {
-	.interval = 1000 * 1000 * 1000 //(ns)
+	.interval = 1000 * 1000 * 1000, //(ns)
+	.jitter_stats = TRUE	// Dumped by SIGUSR1
+};
+
+static glibhelper_loop_monitor_config mcfg = {
+	.operation.overload = overload_cb,
+	.interval = 100 * 1000 * 1000,	// 100ms
+	.threshold = 20 * 1000 * 1000	// 20ms
+};
+
+static glibhelper_signal_config sigcfg = {
+	.operation.reload = reload_cb,
+	.dump_fd = 0	// stderr
 };
 //-----------------------------------------------------------------------------
 int main (int argc, char **argv)
@@ -94,6 +136,7 @@ int main (int argc, char **argv)
 
 	glibhelper_unix_socket_server_support sochandle = NULL;;
 	glibhelper_timerfd_support_handle timerhandle = NULL;
+	glibhelper_uring uring = NULL;
 
 	gloop = g_main_loop_new(NULL, FALSE);	//get default event loop context
 	if (gloop == NULL)
@@ -103,12 +146,28 @@ int main (int argc, char **argv)
 	if (bret == FALSE)
 		goto finish;
 
+	// SIGUSR1: dump stats, SIGHUP: reload
+	bret = glibhelper_create_signal(&ex.signal, NULL, &sigcfg, &ex);
+	if (bret == FALSE)
+		goto finish;
+
+	bret = glibhelper_create_loop_monitor(&ex.monitor, NULL, &mcfg, &ex);
+	if (bret != TRUE) {
+		fprintf(stderr,"glibhelper_create_loop_monitor error\n");
+	}
+
+	// io_uring backend when it is available, otherwise poll backend.
+	if (glibhelper_create_uring(&uring, NULL, NULL) == FALSE)
+		uring = NULL;
+	scfg.uring = uring;
+	tcfg.uring = uring;
+
 	scfg.socketbuf_size = glibhelper_calculate_socket_buffer_size(2*1024, 16);
 	scfg.operation.get_new_session = get_new_session_cb;
 	scfg.operation.receive = receive_cb;
 	scfg.operation.destroyed_session = destroyed_session_cb;
 
-	tcfg.operation.timeout = timeout_cb;
+	tcfg.operation.timeout_ex = timeout_cb;
 
 	bret = glibhelper_create_server_socket(&sochandle, NULL, &scfg, &ex);
 	if (bret != TRUE) {
@@ -116,6 +175,12 @@ int main (int argc, char **argv)
 	}
 	ex.sochandle = sochandle;
 
+	bret = glibhelper_create_broadcast_scheduler(&ex.scheduler, sochandle, NULL, &bcfg);
+	if (bret != TRUE) {
+		fprintf(stderr,"glibhelper_create_broadcast_scheduler error\n");
+		goto finish;
+	}
+
 	bret = glibhelper_create_timerfd(&timerhandle, NULL, &tcfg, &ex);
 	if (bret != TRUE) {
 		fprintf(stderr,"glibhelper_create_timerfd error\n");
@@ -129,9 +194,21 @@ finish:
 	if (ex.timerfd != NULL)
 		glibhelper_terminate_timerfd(ex.timerfd);
 
+	if (ex.signal != NULL)
+		glibhelper_terminate_signal(ex.signal);
+
+	if (ex.monitor != NULL)
+		glibhelper_terminate_loop_monitor(ex.monitor);
+
+	if (ex.scheduler != NULL)
+		glibhelper_terminate_broadcast_scheduler(ex.scheduler);
+
 	if (ex.sochandle != NULL)
 		glibhelper_terminate_server_socket(ex.sochandle);
 
+	if (uring != NULL)
+		glibhelper_terminate_uring(uring);
+
 	fprintf(stderr,"term!!\n");
 
 	return 0;